@@ -0,0 +1,36 @@
+#ifndef __PARALLEL_UTILS_H__
+#define __PARALLEL_UTILS_H__
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+* @brief maximum number of threads available for parallel regions
+*
+* @return returns 1 if the project is built without OpenMP
+*/
+inline int get_max_threads()
+{
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+/**
+* @brief index of the calling thread in the current parallel region
+*
+* @return returns 0 if called outside a parallel region or if the project is built without OpenMP
+*/
+inline int get_thread_id()
+{
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
+#endif
@@ -0,0 +1,534 @@
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include "common/parallel_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+* @brief Bounded lock-free multi-producer multi-consumer queue
+*
+* Ring buffer where every cell carries a sequence number telling whether it is ready to be written or read at the current
+* position, so producers and consumers only contend on their own position counter (Vyukov's bounded MPMC queue).
+* Capacity is rounded up to a power of two.
+*
+* The blocking `push` and `pop` try the lock-free path first, yield for a few attempts, then sleep on a condition variable
+* until the other side makes progress, so idle threads don't hold a core. The mutex is only taken when a thread sleeps or
+* has to wake a sleeping one, and every successful push or pop, blocking or not, wakes threads sleeping on the other side
+*/
+template<class T>
+class BoundedQueue
+{
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param capacity maximum number of elements in the queue
+	*/
+	BoundedQueue(size_t capacity): _head(0), _tail(0), _closed(false), _waiting_pop(0), _waiting_push(0)
+	{
+		size_t size = 1;
+		while(size < capacity) size <<= 1;
+		_mask = size-1;
+		_cells = std::unique_ptr<Cell[]>(new Cell[size]);
+		for(size_t i=0; i<size; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	/**
+	* @brief push an element
+	*
+	* @return returns false if the queue is full
+	*/
+	bool try_push(const T& value)
+	{
+		size_t pos = _tail.load(std::memory_order_relaxed);
+		while(true)
+		{
+			Cell& cell = _cells[pos & _mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			long long diff = static_cast<long long>(seq)-static_cast<long long>(pos);
+			if(diff==0)
+			{
+				if(_tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+				{
+					cell.value = value;
+					cell.sequence.store(pos+1, std::memory_order_release);
+					wake(_waiting_pop, _not_empty);
+					return true;
+				}
+			}
+			else if(diff < 0) return false;
+			else pos = _tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	* @brief pop an element
+	*
+	* @return returns false if the queue is empty
+	*/
+	bool try_pop(T& value)
+	{
+		size_t pos = _head.load(std::memory_order_relaxed);
+		while(true)
+		{
+			Cell& cell = _cells[pos & _mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			long long diff = static_cast<long long>(seq)-static_cast<long long>(pos+1);
+			if(diff==0)
+			{
+				if(_head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+				{
+					value = cell.value;
+					cell.sequence.store(pos+_mask+1, std::memory_order_release);
+					wake(_waiting_push, _not_full);
+					return true;
+				}
+			}
+			else if(diff < 0) return false;
+			else pos = _head.load(std::memory_order_relaxed);
+		}
+	}
+
+	/// @brief push an element, waiting while the queue is full
+	void push(const T& value)
+	{
+		for(int attempt=0; !try_push(value); ++attempt)
+		{
+			if(attempt < spin_attempts)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(_mutex);
+			_waiting_push.fetch_add(1);
+			// pairs with the fence in `wake`, either the consumer sees this waiter or this retry sees the free cell
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			bool pushed = try_push(value);
+			if(!pushed) _not_full.wait(lock);
+			_waiting_push.fetch_sub(1);
+			if(pushed) break;
+		}
+	}
+
+	/**
+	* @brief pop an element, waiting while the queue is empty and not closed
+	*
+	* @return returns false if the queue is closed and empty
+	*/
+	bool pop(T& value)
+	{
+		for(int attempt=0; !try_pop(value); ++attempt)
+		{
+			if(_closed.load(std::memory_order_acquire))
+			{
+				// elements pushed before `close` are visible now
+				if(try_pop(value)) break;
+				return false;
+			}
+			if(attempt < spin_attempts)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(_mutex);
+			_waiting_pop.fetch_add(1);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			bool popped = try_pop(value);
+			if(!popped && !_closed.load(std::memory_order_acquire)) _not_empty.wait(lock);
+			_waiting_pop.fetch_sub(1);
+			if(popped) break;
+		}
+		return true;
+	}
+
+	/**
+	* @brief mark that no more elements will be pushed, `pop` returns false once the queue is drained
+	*/
+	void close()
+	{
+		_closed.store(true, std::memory_order_release);
+		notify(_not_empty);
+	}
+
+	/// @brief accept elements again after `close`
+	void reopen()
+	{
+		_closed.store(false, std::memory_order_release);
+	}
+
+private:
+	/// @brief lock-free attempts, yielding in between, before a blocking call sleeps
+	static const int spin_attempts = 16;
+
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> _cells;
+
+	size_t _mask;
+
+	/// @brief consumer and producer positions, padded to separate cache lines
+	char _pad0[64];
+	std::atomic<size_t> _head;
+	char _pad1[64];
+	std::atomic<size_t> _tail;
+	char _pad2[64];
+
+	std::atomic<bool> _closed;
+
+	/// @brief number of threads sleeping in `pop` and `push`
+	std::atomic<int> _waiting_pop, _waiting_push;
+
+	/// @brief only guards sleeping and waking up
+	std::mutex _mutex;
+
+	std::condition_variable _not_empty, _not_full;
+
+	void notify(std::condition_variable& cv)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		cv.notify_all();
+	}
+
+	/// @brief wake threads sleeping on cv after a successful push or pop, costs a fence and a load when nobody sleeps
+	void wake(std::atomic<int>& waiting, std::condition_variable& cv)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(waiting.load(std::memory_order_relaxed) > 0) notify(cv);
+	}
+};
+
+/**
+* @brief Latency histogram with logarithmic bins
+*
+* Bin i counts durations in \f$[2^{i/4}, 2^{(i+1)/4})\f$ microseconds, i.e. 4 bins per power of two. Recording is lock-free,
+* so a histogram can be shared by all workers of a stage
+*/
+class LatencyHistogram
+{
+public:
+	/// @brief number of bins, covers durations up to about 2^32 us
+	static const int num_bins = 128;
+
+	LatencyHistogram(): _count(0), _total_us(0)
+	{
+		for(int i=0; i<num_bins; ++i) _bins[i].store(0, std::memory_order_relaxed);
+	}
+
+	/// @brief record a duration in seconds
+	void record(double seconds)
+	{
+		double us = std::max(1.0, seconds*1e6);
+		int bin = std::min(num_bins-1, static_cast<int>(4*std::log2(us)));
+		_bins[bin].fetch_add(1, std::memory_order_relaxed);
+		_count.fetch_add(1, std::memory_order_relaxed);
+		_total_us.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+	}
+
+	/// @brief number of recorded durations
+	uint64_t count() const
+	{
+		return _count.load();
+	}
+
+	/// @brief mean duration in seconds
+	double mean() const
+	{
+		uint64_t n = count();
+		return n?_total_us.load()*1e-6/n:0.0;
+	}
+
+	/**
+	* @brief approximate percentile of recorded durations
+	*
+	* @param p percentile in [0, 100]
+	* @return returns upper edge of the bin containing the percentile, in seconds
+	*/
+	double percentile(double p) const
+	{
+		uint64_t n = count();
+		if(n==0) return 0.0;
+		uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p/100*n)));
+		uint64_t cumulative = 0;
+		for(int i=0; i<num_bins; ++i)
+		{
+			cumulative += _bins[i].load();
+			if(cumulative >= rank) return std::pow(2.0, (i+1)/4.0)*1e-6;
+		}
+		return std::pow(2.0, num_bins/4.0)*1e-6;
+	}
+
+	/// @brief count of bin i
+	uint64_t bin_count(int i) const
+	{
+		return _bins[i].load();
+	}
+
+	void reset()
+	{
+		for(int i=0; i<num_bins; ++i) _bins[i].store(0);
+		_count.store(0);
+		_total_us.store(0);
+	}
+
+private:
+	std::atomic<uint64_t> _bins[num_bins];
+
+	std::atomic<uint64_t> _count;
+
+	std::atomic<uint64_t> _total_us;
+};
+
+/**
+* @brief Pipelined executor of per-frame processing stages
+*
+* Every stage runs on its own worker thread(s), and consecutive stages are connected by bounded lock-free queues of frame
+* pointers, so different frames are in different stages at the same time (e.g. frame N+1 is loaded while frame N is in RANSAC).
+* A fixed pool of `num_buffers` frames is recycled: the source fills a free frame, and after the last stage the frame goes back
+* to the pool, so buffers in a frame (e.g. point vectors) keep their capacity and in-flight frames are bounded.
+* Stages with more than one worker may process frames out of order. Idle workers sleep on their input queue, and extra
+* workers of multi-worker stages are dropped when the pipeline would run more threads than `get_max_threads()`, since the
+* stages usually run OpenMP regions of their own.
+* Per-stage latency histograms, end-to-end latency (from start of the source to end of the last stage) and throughput are recorded
+*
+* @tparam Frame per-frame data passed between stages, default constructible
+*/
+template<class Frame>
+class Pipeline
+{
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param num_buffers number of frames in the pool, i.e. maximum number of frames in flight
+	*/
+	Pipeline(int num_buffers=4): _num_buffers(std::max(1, num_buffers)), _num_frames(0), _elapsed(0) {}
+
+	/**
+	* @brief set source stage
+	*
+	* @param name stage name
+	* @param source function filling the next frame, returns false when there are no more frames
+	*/
+	void set_source(const std::string& name, std::function<bool(Frame&)> source)
+	{
+		_source_name = name;
+		_source = source;
+	}
+
+	/**
+	* @brief append a processing stage
+	*
+	* @param name stage name
+	* @param func function processing a frame in place
+	* @param num_workers number of worker threads of the stage
+	*/
+	void add_stage(const std::string& name, std::function<void(Frame&)> func, int num_workers=1)
+	{
+		std::unique_ptr<Stage> stage(new Stage(name, func, std::max(1, num_workers), _num_buffers));
+		_stages.push_back(std::move(stage));
+	}
+
+	/**
+	* @brief run frames from the source through all stages, blocks until all frames are processed
+	*/
+	void run()
+	{
+		_source_latency.reset();
+		_end_to_end_latency.reset();
+		for(auto& stage: _stages) stage->latency.reset();
+		_num_frames = 0;
+
+		// frame pool, frames are allocated once and recycled across runs
+		if(_slots.size() != _num_buffers)
+		{
+			_slots.clear();
+			for(int i=0; i<_num_buffers; ++i) _slots.emplace_back(new Slot());
+		}
+		BoundedQueue<Slot*> pool(_num_buffers);
+		for(auto& slot: _slots) pool.push(slot.get());
+		std::vector<int> workers = bounded_workers();
+		for(int s=0; s<_stages.size(); ++s)
+		{
+			_stages[s]->input.reopen();
+			_stages[s]->active_workers.store(workers[s]);
+		}
+
+		auto start = Clock::now();
+		std::vector<std::thread> threads;
+		for(int s=0; s<_stages.size(); ++s)
+		{
+			for(int w=0; w<workers[s]; ++w) threads.emplace_back(&Pipeline::stage_worker, this, s, std::ref(pool));
+		}
+		run_source(pool);
+		for(std::thread& t: threads) t.join();
+		_elapsed = std::chrono::duration<double>(Clock::now()-start).count();
+	}
+
+	/// @brief number of stages, excluding the source
+	int num_stages()
+	{
+		return _stages.size();
+	}
+
+	/// @brief name of stage i, -1 for the source
+	const std::string& stage_name(int i)
+	{
+		return (i<0)?_source_name:_stages[i]->name;
+	}
+
+	/// @brief latency histogram of stage i, -1 for the source
+	const LatencyHistogram& stage_latency(int i)
+	{
+		return (i<0)?_source_latency:_stages[i]->latency;
+	}
+
+	/// @brief latency histogram from start of the source to end of the last stage
+	const LatencyHistogram& end_to_end_latency()
+	{
+		return _end_to_end_latency;
+	}
+
+	/// @brief number of frames processed in the last run
+	uint64_t num_frames()
+	{
+		return _num_frames;
+	}
+
+	/// @brief frames per second of the last run
+	double throughput()
+	{
+		return (_elapsed > 0)?_num_frames/_elapsed:0.0;
+	}
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	/// @brief pooled frame with its start time
+	struct Slot
+	{
+		Frame frame;
+		Clock::time_point start;
+	};
+
+	struct Stage
+	{
+		std::string name;
+		std::function<void(Frame&)> func;
+		int num_workers;
+		/// @brief input queue of the stage
+		BoundedQueue<Slot*> input;
+		/// @brief number of workers still running, when it drops to 0 the next stage can finish after draining its input
+		std::atomic<int> active_workers;
+		LatencyHistogram latency;
+
+		Stage(const std::string& n, std::function<void(Frame&)> f, int w, int capacity):
+			name(n), func(f), num_workers(w), input(capacity), active_workers(0) {}
+	};
+
+	int _num_buffers;
+
+	std::string _source_name;
+
+	std::function<bool(Frame&)> _source;
+
+	std::vector< std::unique_ptr<Stage> > _stages;
+
+	std::vector< std::unique_ptr<Slot> > _slots;
+
+	LatencyHistogram _source_latency;
+
+	LatencyHistogram _end_to_end_latency;
+
+	std::atomic<uint64_t> _num_frames;
+
+	/// @brief wall time of the last run in seconds
+	double _elapsed;
+
+	/// @brief fill free frames from the source and pass them to the first stage, runs on the calling thread
+	void run_source(BoundedQueue<Slot*>& pool)
+	{
+		while(true)
+		{
+			Slot* slot;
+			pool.pop(slot);
+			slot->start = Clock::now();
+			bool more = _source(slot->frame);
+			auto end = Clock::now();
+			if(!more)
+			{
+				pool.push(slot);
+				break;
+			}
+			_source_latency.record(std::chrono::duration<double>(end-slot->start).count());
+			forward(slot, 0, pool);
+		}
+		if(!_stages.empty()) _stages[0]->input.close();
+	}
+
+	/// @brief pass a frame to stage s, or back to the pool after the last stage
+	void forward(Slot* slot, int s, BoundedQueue<Slot*>& pool)
+	{
+		if(s < _stages.size())
+		{
+			_stages[s]->input.push(slot);
+			return;
+		}
+		_end_to_end_latency.record(std::chrono::duration<double>(Clock::now()-slot->start).count());
+		++_num_frames;
+		pool.push(slot);
+	}
+
+	/**
+	* @brief workers per stage, at least one each, extra workers dropped from the stages with the most workers until the
+	* total fits the available threads
+	*/
+	std::vector<int> bounded_workers()
+	{
+		std::vector<int> workers;
+		int total = 0;
+		for(auto& stage: _stages)
+		{
+			workers.push_back(stage->num_workers);
+			total += stage->num_workers;
+		}
+		int budget = std::max<int>(_stages.size(), get_max_threads());
+		while(total > budget)
+		{
+			--*std::max_element(workers.begin(), workers.end());
+			--total;
+		}
+		return workers;
+	}
+
+	void stage_worker(int s, BoundedQueue<Slot*>& pool)
+	{
+		Stage& stage = *_stages[s];
+		Slot* slot;
+		// returns false once the producers are finished and the input is drained
+		while(stage.input.pop(slot))
+		{
+			auto start = Clock::now();
+			stage.func(slot->frame);
+			stage.latency.record(std::chrono::duration<double>(Clock::now()-start).count());
+			forward(slot, s+1, pool);
+		}
+		// the last worker of the stage closes the input of the next one
+		if(stage.active_workers.fetch_sub(1, std::memory_order_acq_rel)==1 && s+1 < _stages.size()) _stages[s+1]->input.close();
+	}
+};
+
+#endif
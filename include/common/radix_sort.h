@@ -0,0 +1,85 @@
+#ifndef __RADIX_SORT_H__
+#define __RADIX_SORT_H__
+
+#include "common/parallel_utils.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+* @brief parallel LSD radix sort of unsigned 64 bit keys
+*
+* Keys are sorted 8 bits at a time, each pass builds per thread histograms of its chunk of keys and scatters
+* the chunk in order, so the sort is stable. Passes where all keys fall in the same bucket are skipped  
+* Runs in O(n * key_bits / 8)
+*
+* @param keys keys to sort, left unchanged
+* @param order computed permutation such that `keys[order[0]] <= keys[order[1]] <= ...`
+* @param key_bits number of least significant bits used by the keys, higher bits are ignored
+*/
+inline void radix_sort(const std::vector<uint64_t>& keys, std::vector<int>& order, int key_bits=64)
+{
+	const int radix_bits = 8;
+	const int nbuckets = 1<<radix_bits;
+	int n = keys.size();
+	order.resize(n);
+	for(int i=0; i<n; ++i) order[i] = i;
+	if(n < 2) return;
+
+	std::vector<uint64_t> cur_keys(keys), tmp_keys(n);
+	std::vector<int> tmp_order(n);
+	int nchunks = std::max(1, std::min(get_max_threads(), n/nbuckets));
+	std::vector<int> hist(nchunks*nbuckets);
+
+	for(int shift=0; shift<key_bits; shift+=radix_bits)
+	{
+		std::fill(hist.begin(), hist.end(), 0);
+		#pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+		for(int c=0; c<nchunks; ++c)
+		{
+			int* h = &hist[c*nbuckets];
+			int end = static_cast<long long>(n)*(c+1)/nchunks;
+			for(int i=static_cast<long long>(n)*c/nchunks; i<end; ++i) ++h[(cur_keys[i]>>shift) & (nbuckets-1)];
+		}
+
+		// skip pass if all keys have the same digit
+		bool single_bucket = false;
+		for(int b=0; b<nbuckets; ++b)
+		{
+			int total = 0;
+			for(int c=0; c<nchunks; ++c) total += hist[c*nbuckets+b];
+			if(total==n) single_bucket = true;
+			if(total!=0) break;
+		}
+		if(single_bucket) continue;
+
+		// exclusive prefix sum in (bucket, chunk) order gives each chunk its write offset per bucket
+		int offset = 0;
+		for(int b=0; b<nbuckets; ++b)
+		{
+			for(int c=0; c<nchunks; ++c)
+			{
+				int count = hist[c*nbuckets+b];
+				hist[c*nbuckets+b] = offset;
+				offset += count;
+			}
+		}
+
+		#pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+		for(int c=0; c<nchunks; ++c)
+		{
+			int* h = &hist[c*nbuckets];
+			int end = static_cast<long long>(n)*(c+1)/nchunks;
+			for(int i=static_cast<long long>(n)*c/nchunks; i<end; ++i)
+			{
+				int pos = h[(cur_keys[i]>>shift) & (nbuckets-1)]++;
+				tmp_keys[pos] = cur_keys[i];
+				tmp_order[pos] = order[i];
+			}
+		}
+		cur_keys.swap(tmp_keys);
+		order.swap(tmp_order);
+	}
+}
+
+#endif
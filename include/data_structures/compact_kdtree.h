@@ -0,0 +1,267 @@
+#ifndef __COMPACT_KDTREE_H__
+#define __COMPACT_KDTREE_H__
+
+#include "data_structures/quantized_points.h"
+#include "data_structures/knn_heap.h"
+#include <algorithm>
+
+/**
+* @brief KDTree over quantized point storage
+*
+* Memory compact alternative to `KDTree` for large pointclouds. Points are stored as `QuantizedPoints` (6 bytes per point)
+* in tree order, so every leaf is a contiguous bucket of up to `leaf_size` points that is decoded on the fly while it is scanned.
+* Nodes are kept in a single vector instead of one heap allocation per point.
+* The tree is built over the decoded coordinates, so queries are exact with respect to the stored points, which differ
+* from the input points by at most `get_max_error()`
+*/
+template<class T>
+class CompactKDTree
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param mode encoding of coordinates
+	* @param resolution quantization step of FIXED16 mode
+	* @param leaf_size maximum number of points in a leaf bucket
+	*/
+	CompactKDTree(QuantizationMode mode=QuantizationMode::FIXED16, double resolution=0.005, int leaf_size=16):
+		_points(mode, resolution), _leaf_size(std::max(1, leaf_size)) {}
+
+	/**
+	* @brief build tree from a vector of points
+	*
+	* @param pointvec vector of points, query results are indices in this vector
+	*/
+	void build(std::vector< Point<3, T> >& pointvec)
+	{
+		int n = pointvec.size();
+		_nodes.clear();
+		_indices.resize(n);
+		for(int i=0; i<n; ++i) _indices[i] = i;
+		// quantize first and build over the decoded coordinates
+		_points.encode(pointvec);
+		std::vector<T> coords(3*static_cast<size_t>(n));
+		for(int i=0; i<n; ++i) _points.decode(i, &coords[3*static_cast<size_t>(i)]);
+		if(n > 0) build_recursive(coords, 0, n);
+		// store points in tree order
+		_points.encode(pointvec, &_indices);
+	}
+
+	/**
+	* @brief get indices of points in the tree that are with in radius units from the query point
+	*
+	* @param point query point
+	* @param radius search radius
+	* @param indices vector to store indices of the neighbors, it is cleared first and can be reused across queries
+	*/
+	void neighborhood_indices(const Point<3, T>& point, const double& radius, std::vector<int>& indices)
+	{
+		indices.clear();
+		if(_nodes.empty()) return;
+		T q[3] = {point[0], point[1], point[2]};
+		T xyz[3];
+		neighborhood_recursive(0, q, radius, [&](int i) { indices.push_back(_indices[i]); }, xyz);
+	}
+
+	/**
+	* @brief get decoded points in the tree that are with in radius units from the query point
+	*
+	* @param point query point
+	* @param radius search radius
+	* @param neighbors vector to store decoded neighbors, it is cleared first and can be reused across queries
+	*/
+	void neighborhood(const Point<3, T>& point, const double& radius, std::vector< Point<3, T> >& neighbors)
+	{
+		neighbors.clear();
+		if(_nodes.empty()) return;
+		T q[3] = {point[0], point[1], point[2]};
+		T xyz[3];
+		neighborhood_recursive(0, q, radius, [&](int i) {
+			neighbors.emplace_back();
+			for(int k=0; k<3; ++k) neighbors.back()[k] = xyz[k];
+		}, xyz);
+	}
+
+	/**
+	* @brief get indices of the k points in the tree closest to the query point
+	*
+	* @param point query point
+	* @param k number of neighbors
+	* @param indices vector to store indices of the neighbors sorted by increasing distance
+	* @param dists vector to store distances of the neighbors to the query point
+	*/
+	void k_nearest_indices(const Point<3, T>& point, int k, std::vector<int>& indices, std::vector<double>& dists)
+	{
+		indices.clear();
+		dists.clear();
+		if(k<=0 || _nodes.empty()) return;
+		T q[3] = {point[0], point[1], point[2]};
+		// max-heap of (squared distance, tree order index) pairs stored in the two output vectors
+		k_nearest_recursive(0, q, k, indices, dists);
+		// heap sort by increasing distance
+		knn_heap_sort(indices, dists);
+		for(int i=0; i<indices.size(); ++i)
+		{
+			indices[i] = _indices[indices[i]];
+			dists[i] = std::sqrt(dists[i]);
+		}
+	}
+
+	/// @brief quantized points in tree order
+	const QuantizedPoints<T>& points() const
+	{
+		return _points;
+	}
+
+	/// @brief maximum absolute coordinate error of the stored points
+	double get_max_error() const
+	{
+		return _points.get_max_error();
+	}
+
+	/// @brief memory used by the tree in bytes
+	size_t memory_bytes() const
+	{
+		return _points.memory_bytes() + _indices.size()*sizeof(int) + _nodes.size()*sizeof(Node);
+	}
+
+private:
+	/// @brief tree node, leaves have no children and cover points [begin, end) in tree order
+	struct Node
+	{
+		T split;
+		int dim;
+		int begin, end;
+		int left, right;
+	};
+
+	QuantizedPoints<T> _points;
+
+	int _leaf_size;
+
+	/// @brief nodes, root at index 0
+	std::vector<Node> _nodes;
+
+	/// @brief index in the input vector of every point in tree order
+	std::vector<int> _indices;
+
+	/**
+	* @brief recursive helper function to build tree over points [begin, end) of _indices
+	*
+	* splits along the dimension of largest extent at the median point
+	*
+	* @return returns node index
+	*/
+	int build_recursive(const std::vector<T>& coords, int begin, int end)
+	{
+		int node = _nodes.size();
+		_nodes.push_back({0, 0, begin, end, -1, -1});
+		if(end-begin <= _leaf_size) return node;
+		T min_p[3], max_p[3];
+		for(int k=0; k<3; ++k)
+		{
+			min_p[k] = std::numeric_limits<T>::max();
+			max_p[k] = std::numeric_limits<T>::lowest();
+		}
+		for(int i=begin; i<end; ++i)
+		{
+			for(int k=0; k<3; ++k)
+			{
+				T c = coords[3*static_cast<size_t>(_indices[i])+k];
+				min_p[k] = std::min(min_p[k], c);
+				max_p[k] = std::max(max_p[k], c);
+			}
+		}
+		int dim = 0;
+		for(int k=1; k<3; ++k) if(max_p[k]-min_p[k] > max_p[dim]-min_p[dim]) dim = k;
+		int m = begin+(end-begin)/2;
+		std::nth_element(_indices.begin()+begin, _indices.begin()+m, _indices.begin()+end, [&coords, dim](int a, int b){
+			return coords[3*static_cast<size_t>(a)+dim] < coords[3*static_cast<size_t>(b)+dim];
+		});
+		// points in [begin, m) are <= split and points in [m, end) are >= split
+		_nodes[node].split = coords[3*static_cast<size_t>(_indices[m])+dim];
+		_nodes[node].dim = dim;
+		int left = build_recursive(coords, begin, m);
+		int right = build_recursive(coords, m, end);
+		_nodes[node].left = left;
+		_nodes[node].right = right;
+		return node;
+	}
+
+	/**
+	* @brief recursive helper function to visit points within radius of the query point
+	*
+	* @param visit function called with the tree order index of every neighbor, while its decoded coordinates are in xyz
+	*/
+	template<class Visit>
+	void neighborhood_recursive(int node, const T* q, const double& radius, const Visit& visit, T* xyz)
+	{
+		const Node& cur = _nodes[node];
+		if(cur.left==-1)
+		{
+			// leaf scan, decode points of the bucket
+			double sq_radius = radius*radius;
+			for(int i=cur.begin; i<cur.end; ++i)
+			{
+				_points.decode(i, xyz);
+				double dx = xyz[0]-q[0], dy = xyz[1]-q[1], dz = xyz[2]-q[2];
+				if(dx*dx+dy*dy+dz*dz <= sq_radius) visit(i);
+			}
+			return;
+		}
+		if(q[cur.dim]-radius <= cur.split) neighborhood_recursive(cur.left, q, radius, visit, xyz);
+		if(q[cur.dim]+radius >= cur.split) neighborhood_recursive(cur.right, q, radius, visit, xyz);
+	}
+
+	/**
+	* @brief recursive helper function to find k nearest neighbors of the query point
+	*
+	* @param indices tree order indices of the current k nearest neighbors, stored as a max-heap on squared distance
+	* @param sq_dists squared distances of the current k nearest neighbors
+	*/
+	void k_nearest_recursive(int node, const T* q, int k, std::vector<int>& indices, std::vector<double>& sq_dists)
+	{
+		const Node& cur = _nodes[node];
+		if(cur.left==-1)
+		{
+			T xyz[3];
+			for(int i=cur.begin; i<cur.end; ++i)
+			{
+				_points.decode(i, xyz);
+				double dx = xyz[0]-q[0], dy = xyz[1]-q[1], dz = xyz[2]-q[2];
+				double sq_dist = dx*dx+dy*dy+dz*dz;
+				if(indices.size() < k)
+				{
+					// sift up new element
+					indices.push_back(i);
+					sq_dists.push_back(sq_dist);
+					int c = indices.size()-1;
+					while(c>0 && sq_dists[(c-1)/2] < sq_dists[c])
+					{
+						std::swap(indices[c], indices[(c-1)/2]);
+						std::swap(sq_dists[c], sq_dists[(c-1)/2]);
+						c = (c-1)/2;
+					}
+				}
+				else if(sq_dist < sq_dists[0])
+				{
+					// replace current farthest neighbor
+					indices[0] = i;
+					sq_dists[0] = sq_dist;
+					knn_heap_sift_down(indices, sq_dists, 0, indices.size());
+				}
+			}
+			return;
+		}
+		double diff = q[cur.dim]-cur.split;
+		int near = (diff < 0)?cur.left:cur.right;
+		int far = (diff < 0)?cur.right:cur.left;
+		k_nearest_recursive(near, q, k, indices, sq_dists);
+		if(indices.size() < k || diff*diff <= sq_dists[0]) k_nearest_recursive(far, q, k, indices, sq_dists);
+	}
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define __KDTREE_H__
 
 #include "data_structures/point_types.h"
+#include "data_structures/knn_heap.h"
 #include <memory>
 #include <algorithm>
 
@@ -15,11 +16,13 @@ public:
 	typedef std::shared_ptr<KDNode> KDNodePtr;
 
 	Point<d, T> point;
+	/// @brief index of the point in the vector the tree was built from, -1 for inserted points
+	int index;
 	KDNodePtr left;
 	KDNodePtr right;
 
-	KDNode(): point(), left(nullptr), right(nullptr) {}
-	KDNode(Point<d, T>& p): point(p), left(nullptr), right(nullptr) {}
+	KDNode(): point(), index(-1), left(nullptr), right(nullptr) {}
+	KDNode(Point<d, T>& p, int i=-1): point(p), index(i), left(nullptr), right(nullptr) {}
 };
 
 /**
@@ -42,11 +45,13 @@ public:
 	/**
 	* @brief build tree from a vector of points
 	*
-	* @param pointvec vector of points
+	* @param pointvec vector of points, nodes keep the index of their point in this vector
 	*/
 	void build(std::vector< Point<d, T> >& pointvec)
 	{
-		root = build_tree_recursive(pointvec, 0, pointvec.size(), 0);
+		std::vector<int> indices(pointvec.size());
+		for(int i=0; i<indices.size(); ++i) indices[i] = i;
+		root = build_tree_recursive(pointvec, indices, 0, pointvec.size(), 0);
 	}
 
 	/**
@@ -128,6 +133,42 @@ public:
 		return neighbors;
 	}
 
+	/**
+	* @brief get indices of points in the tree that are with in radius units from the query point
+	*
+	* @param point query point
+	* @param radius search radius
+	* @param indices vector to store indices (in the vector the tree was built from) of the neighbors, it is cleared first 
+	* and can be reused across queries to avoid allocations
+	*/
+	void neighborhood_indices(const Point<d, T>& point, const double& radius, std::vector<int>& indices)
+	{
+		indices.clear();
+		neighborhood_indices_recursive(root, point, radius, 0, indices);
+	}
+
+	/**
+	* @brief get indices of the k points in the tree closest to the query point
+	*
+	* @param point query point
+	* @param k number of neighbors
+	* @param indices vector to store indices (in the vector the tree was built from) of the neighbors sorted by increasing distance
+	* @param dists vector to store distances of the neighbors to the query point
+	*
+	* @note both vectors are cleared first and can be reused across queries to avoid allocations.
+	* If the query point is in the tree, it is returned as its own closest neighbor
+	*/
+	void k_nearest_indices(const Point<d, T>& point, int k, std::vector<int>& indices, std::vector<double>& dists)
+	{
+		indices.clear();
+		dists.clear();
+		if(k<=0) return;
+		// max-heap of (distance, index) pairs stored in the two output vectors
+		k_nearest_recursive(root, point, k, 0, indices, dists);
+		// heap sort by increasing distance
+		knn_heap_sort(indices, dists);
+	}
+
 private:
 	/// @biref tree root ptr
 	KDNodePtr root;
@@ -136,25 +177,26 @@ private:
 	* @brief recursive helper function to build tree from a point vector
 	*
 	* @param pointvec vector of points
+	* @param indices indices of points in pointvec, partitioned in place
 	* @param l start index of the vector
 	* @param r end index the vector
 	* @param id current search dimension
 	* 
-	* @note builds tree using the vector between indices [l, r)
+	* @note builds tree using the indices between [l, r)
 	*/
-	KDNodePtr build_tree_recursive(std::vector< Point<d, T> >& pointvec, int l, int r, int id)
+	KDNodePtr build_tree_recursive(std::vector< Point<d, T> >& pointvec, std::vector<int>& indices, int l, int r, int id)
 	{
 		if(r<=l) return nullptr;
 		int m = l+(r-l)/2;
 		// O(n) partition such that elements to the left are < than element at pivot position and elements to the right are >= to element at pivot position
-		std::nth_element(pointvec.begin()+l, pointvec.begin()+m, pointvec.begin()+r, [&id](Point<d, T>& a, Point<d, T>& b){
-			return a[id]<b[id];
+		std::nth_element(indices.begin()+l, indices.begin()+m, indices.begin()+r, [&id, &pointvec](int a, int b){
+			return pointvec[a][id]<pointvec[b][id];
 		});
-		KDNodePtr cur_root = std::make_shared< KDNode<d, T> >(pointvec[m]);
+		KDNodePtr cur_root = std::make_shared< KDNode<d, T> >(pointvec[indices[m]], indices[m]);
 		id = (id+1)%d;
 		// recursively build tree for left and right branches
-		cur_root->left = build_tree_recursive(pointvec, l, m, id);
-		cur_root->right = build_tree_recursive(pointvec, m+1, r, id);
+		cur_root->left = build_tree_recursive(pointvec, indices, l, m, id);
+		cur_root->right = build_tree_recursive(pointvec, indices, m+1, r, id);
 		return cur_root;
 	}
 
@@ -178,10 +220,19 @@ private:
 			rnode = cur_root;
 		}
 		if(dist==0) return; // exact node is found
-		// check if a closer point can exist in left branch
-		if(point[id]-min_dist <= cur_root->point[id]) search_closest(cur_root->left, point, (id+1)%d, rnode, min_dist);
-		// check if a closer point can exist in right branch
-		if(point[id]+min_dist >= cur_root->point[id]) search_closest(cur_root->right, point, (id+1)%d, rnode, min_dist);
+		// descend into the branch containing the query point first, so that min_dist shrinks before the other branch is checked
+		if(point[id] < cur_root->point[id])
+		{
+			search_closest(cur_root->left, point, (id+1)%d, rnode, min_dist);
+			// check if a closer point can exist in right branch
+			if(point[id]+min_dist >= cur_root->point[id]) search_closest(cur_root->right, point, (id+1)%d, rnode, min_dist);
+		}
+		else
+		{
+			search_closest(cur_root->right, point, (id+1)%d, rnode, min_dist);
+			// check if a closer point can exist in left branch
+			if(point[id]-min_dist <= cur_root->point[id]) search_closest(cur_root->left, point, (id+1)%d, rnode, min_dist);
+		}
 	}
 
 	/**
@@ -204,6 +255,67 @@ private:
 		// check if neighbor can exist in right branch
 		if(point[id]+radius >= cur_root->point[id]) neighborhood_recursive(cur_root->right, point, radius, (id+1)%d, neighbors);
 	}
+
+	/**
+	* @brief recursive helper function to find k nearest neighbors of the query point
+	*
+	* @param cur_root current root to recurse from
+	* @param point query point
+	* @param k number of neighbors
+	* @param id current search dimension
+	* @param indices indices of the current k nearest neighbors, stored as a max-heap on distance
+	* @param dists distances of the current k nearest neighbors, stored as a max-heap
+	*/
+	void k_nearest_recursive(KDNodePtr& cur_root, const Point<d, T>& point, int k, int id, std::vector<int>& indices, std::vector<double>& dists)
+	{
+		if(cur_root==nullptr) return;
+		double dist = point.distance_to(cur_root->point);
+		if(indices.size() < k)
+		{
+			// sift up new element
+			indices.push_back(cur_root->index);
+			dists.push_back(dist);
+			int c = indices.size()-1;
+			while(c>0 && dists[(c-1)/2] < dists[c])
+			{
+				std::swap(indices[c], indices[(c-1)/2]);
+				std::swap(dists[c], dists[(c-1)/2]);
+				c = (c-1)/2;
+			}
+		}
+		else if(dist < dists[0])
+		{
+			// replace current farthest neighbor
+			indices[0] = cur_root->index;
+			dists[0] = dist;
+			knn_heap_sift_down(indices, dists, 0, indices.size());
+		}
+		// visit the branch containing the query point first
+		double diff = point[id] - cur_root->point[id];
+		KDNodePtr& near = (diff < 0)?cur_root->left:cur_root->right;
+		KDNodePtr& far = (diff < 0)?cur_root->right:cur_root->left;
+		k_nearest_recursive(near, point, k, (id+1)%d, indices, dists);
+		// farther branch can contain a neighbor only if it is closer than the current farthest neighbor
+		if(indices.size() < k || std::abs(diff) <= dists[0]) k_nearest_recursive(far, point, k, (id+1)%d, indices, dists);
+	}
+
+	/**
+	* @brief recursive helper function to retreive indices of points in the tree that are within a radius of the query point
+	*
+	* @param cur_root current root to recurse from
+	* @param point query point
+	* @param radius search radius around the query point 
+	* @param id current search dimension
+	* @param indices vector of indices of neighbors in the search area of the query point
+	*/
+	void neighborhood_indices_recursive(KDNodePtr& cur_root, const Point<d, T>& point, const double& radius, int id, std::vector<int>& indices)
+	{
+		if(cur_root==nullptr) return;
+		double dist = point.distance_to(cur_root->point);
+		if(dist<=radius) indices.push_back(cur_root->index);
+		if(point[id]-radius <= cur_root->point[id]) neighborhood_indices_recursive(cur_root->left, point, radius, (id+1)%d, indices);
+		if(point[id]+radius >= cur_root->point[id]) neighborhood_indices_recursive(cur_root->right, point, radius, (id+1)%d, indices);
+	}
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __KNN_HEAP_H__
+#define __KNN_HEAP_H__
+
+#include <vector>
+#include <algorithm>
+
+/**
+* @brief restore max-heap property of (dists, indices) in [0, size) from position c downwards
+*
+* k nearest neighbor searches keep the current neighbors as a max-heap on distance stored in the two output vectors,
+* so the farthest neighbor is at position 0
+*/
+inline void knn_heap_sift_down(std::vector<int>& indices, std::vector<double>& dists, int c, int size)
+{
+	while(true)
+	{
+		int largest = c;
+		int l = 2*c+1, r = 2*c+2;
+		if(l < size && dists[l] > dists[largest]) largest = l;
+		if(r < size && dists[r] > dists[largest]) largest = r;
+		if(largest==c) return;
+		std::swap(indices[c], indices[largest]);
+		std::swap(dists[c], dists[largest]);
+		c = largest;
+	}
+}
+
+/**
+* @brief heap sort a max-heap of (dists, indices) by increasing distance
+*/
+inline void knn_heap_sort(std::vector<int>& indices, std::vector<double>& dists)
+{
+	for(int end=indices.size(); end>1; --end)
+	{
+		std::swap(indices[0], indices[end-1]);
+		std::swap(dists[0], dists[end-1]);
+		knn_heap_sift_down(indices, dists, 0, end-1);
+	}
+}
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef __NEIGHBORHOOD_GRAPH_H__
+#define __NEIGHBORHOOD_GRAPH_H__
+
+#include "data_structures/kdtree.h"
+#include "common/parallel_utils.h"
+
+/**
+* @brief radius neighborhood graph of a pointcloud in compressed sparse row (CSR) form
+*
+* Neighbors of the \f$i^{th}\f$ point are `neighbors()[offsets()[i]]` to `neighbors()[offsets()[i+1]-1]`, a point is not its own neighbor.
+* The graph is built once from KDTree radius queries, and algorithms that walk neighborhoods repeatedly (clustering, region growing)
+* can then use it instead of querying the tree again
+*/
+template<unsigned int d, class T>
+class NeighborhoodGraph
+{
+public:
+	/// @brief Default constructor
+	NeighborhoodGraph() {}
+
+	/**
+	* @brief build graph by querying a KDTree for neighbors of every point
+	*
+	* points are processed in parallel chunks, each chunk reuses a single query buffer and collects neighbors into
+	* its own buffer, chunk buffers are then copied into the CSR arrays
+	*
+	* @param pointvec vector of points
+	* @param tree KDTree built from pointvec
+	* @param radius search radius
+	*/
+	void build(std::vector< Point<d, T> >& pointvec, KDTree<d, T>& tree, double radius)
+	{
+		int n = pointvec.size();
+		_offsets.assign(n+1, 0);
+		int nchunks = std::max(1, std::min(4*get_max_threads(), n));
+		std::vector< std::vector<int> > chunk_neighbors(nchunks);
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int c=0; c<nchunks; ++c)
+		{
+			std::vector<int> query;
+			std::vector<int>& buf = chunk_neighbors[c];
+			int end = static_cast<long long>(n)*(c+1)/nchunks;
+			for(int i=static_cast<long long>(n)*c/nchunks; i<end; ++i)
+			{
+				tree.neighborhood_indices(pointvec[i], radius, query);
+				int count = 0;
+				for(int j: query)
+				{
+					if(j==i) continue;
+					buf.push_back(j);
+					++count;
+				}
+				_offsets[i+1] = count;
+			}
+		}
+
+		for(int i=0; i<n; ++i) _offsets[i+1] += _offsets[i];
+		_neighbors.resize(_offsets[n]);
+		#pragma omp parallel for schedule(static)
+		for(int c=0; c<nchunks; ++c)
+		{
+			int begin = _offsets[static_cast<long long>(n)*c/nchunks];
+			std::copy(chunk_neighbors[c].begin(), chunk_neighbors[c].end(), _neighbors.begin()+begin);
+		}
+	}
+
+	/**
+	* @overload
+	*
+	* builds a KDTree from pointvec first
+	*/
+	void build(std::vector< Point<d, T> >& pointvec, double radius)
+	{
+		KDTree<d, T> tree;
+		tree.build(pointvec);
+		build(pointvec, tree, radius);
+	}
+
+	/// @brief number of points in the graph
+	int size() const
+	{
+		return _offsets.empty()?0:_offsets.size()-1;
+	}
+
+	/// @brief number of neighbors of the \f$i^{th}\f$ point
+	int degree(int i) const
+	{
+		return _offsets[i+1]-_offsets[i];
+	}
+
+	/// @brief pointer to first neighbor of the \f$i^{th}\f$ point
+	const int* neighbors_begin(int i) const
+	{
+		return _neighbors.data()+_offsets[i];
+	}
+
+	/// @brief pointer past the last neighbor of the \f$i^{th}\f$ point
+	const int* neighbors_end(int i) const
+	{
+		return _neighbors.data()+_offsets[i+1];
+	}
+
+	/// @brief CSR row offsets, size is number of points + 1
+	const std::vector<int>& offsets() const
+	{
+		return _offsets;
+	}
+
+	/// @brief CSR neighbor indices
+	const std::vector<int>& neighbors() const
+	{
+		return _neighbors;
+	}
+
+private:
+	/// @brief CSR row offsets
+	std::vector<int> _offsets;
+
+	/// @brief CSR neighbor indices
+	std::vector<int> _neighbors;
+};
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef __QUANTIZED_POINTS_H__
+#define __QUANTIZED_POINTS_H__
+
+#include "data_structures/point_types.h"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+/**
+* @brief encoding of quantized coordinates
+*
+* FIXED16: 16 bit unsigned fixed point offsets from the origin (minimum corner), error \f$\leq\f$ resolution/2
+* HALF: IEEE 754 half precision offsets from the origin (center), relative error \f$\leq 2^{-11}\f$ of the offset
+*/
+enum class QuantizationMode {FIXED16, HALF};
+
+/**
+* @brief convert float to IEEE 754 half precision bits, rounding to nearest even
+*/
+inline uint16_t float_to_half(float f)
+{
+	uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+	uint32_t sign = (x>>16) & 0x8000;
+	uint32_t mant = x & 0x7fffff;
+	if(((x>>23) & 0xff)==0xff) return sign | 0x7c00 | (mant?0x200:0); // inf or nan
+	int exp = static_cast<int>((x>>23) & 0xff) - 127 + 15;
+	if(exp >= 31) return sign | 0x7c00; // overflow to inf
+	if(exp <= 0)
+	{
+		// subnormal half or zero
+		if(exp < -10) return sign;
+		mant |= 0x800000;
+		int shift = 14-exp;
+		uint32_t h = mant>>shift;
+		uint32_t rem = mant & ((1u<<shift)-1), halfway = 1u<<(shift-1);
+		if(rem > halfway || (rem==halfway && (h&1))) ++h;
+		return sign | h;
+	}
+	uint32_t h = (static_cast<uint32_t>(exp)<<10) | (mant>>13);
+	uint32_t rem = mant & 0x1fff;
+	// a carry into the exponent is still the correctly rounded value
+	if(rem > 0x1000 || (rem==0x1000 && (h&1))) ++h;
+	return sign | h;
+}
+
+/**
+* @brief convert IEEE 754 half precision bits to float
+*/
+inline float half_to_float(uint16_t h)
+{
+	uint32_t sign = static_cast<uint32_t>(h & 0x8000)<<16;
+	int exp = (h>>10) & 0x1f;
+	uint32_t mant = h & 0x3ff;
+	uint32_t x;
+	if(exp==0)
+	{
+		if(mant==0) x = sign;
+		else
+		{
+			// normalize subnormal
+			exp = 1;
+			while(!(mant & 0x400))
+			{
+				mant <<= 1;
+				--exp;
+			}
+			mant &= 0x3ff;
+			x = sign | (static_cast<uint32_t>(exp+127-15)<<23) | (mant<<13);
+		}
+	}
+	else if(exp==31) x = sign | 0x7f800000 | (mant<<13);
+	else x = sign | (static_cast<uint32_t>(exp+127-15)<<23) | (mant<<13);
+	float f;
+	std::memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+/**
+* @brief lookup table of all 65536 half values, decoding with the table is a single load
+*/
+inline const float* half_table()
+{
+	static const std::vector<float> table = []()
+	{
+		std::vector<float> t(1<<16);
+		for(int i=0; i<t.size(); ++i) t[i] = half_to_float(static_cast<uint16_t>(i));
+		return t;
+	}();
+	return table.data();
+}
+
+/**
+* @brief Compact 3d point storage with 16 bit coordinates
+*
+* Coordinates are stored interleaved as 3 uint16_t values per point (6 bytes instead of 12 for float), relative to an origin
+* chosen from the bounding box of the encoded points (e.g. a tile origin). Points are decoded on the fly with `decode`
+*/
+template<class T>
+class QuantizedPoints
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param mode encoding of coordinates
+	* @param resolution quantization step of FIXED16 mode, the extent of the encoded points can be at most 65535*resolution
+	*/
+	QuantizedPoints(QuantizationMode mode=QuantizationMode::FIXED16, double resolution=0.005): _mode(mode), _resolution(resolution), _max_error(0)
+	{
+		for(int k=0; k<3; ++k) _origin[k] = 0;
+	}
+
+	/**
+	* @brief encode points
+	*
+	* @param pointvec vector of points
+	* @param order optional order of the points to encode, `order[i]` is the index in pointvec of the \f$i^{th}\f$ encoded point
+	*/
+	void encode(const std::vector< Point<3, T> >& pointvec, const std::vector<int>* order=nullptr)
+	{
+		int n = order?order->size():pointvec.size();
+		_data.resize(3*static_cast<size_t>(n));
+		_max_error = 0;
+		if(n==0) return;
+		if(_mode==QuantizationMode::FIXED16 && _resolution <= 0) throw std::domain_error("resolution must be positive");
+
+		T min_p[3], max_p[3];
+		for(int k=0; k<3; ++k)
+		{
+			min_p[k] = std::numeric_limits<T>::max();
+			max_p[k] = std::numeric_limits<T>::lowest();
+		}
+		for(const Point<3, T>& p: pointvec)
+		{
+			for(int k=0; k<3; ++k)
+			{
+				min_p[k] = std::min(min_p[k], p[k]);
+				max_p[k] = std::max(max_p[k], p[k]);
+			}
+		}
+		for(int k=0; k<3; ++k)
+		{
+			if(_mode==QuantizationMode::FIXED16)
+			{
+				_origin[k] = min_p[k];
+				if((max_p[k]-min_p[k])/_resolution > 65535) throw std::domain_error("extent too large for 16 bit coordinates at this resolution");
+			}
+			// half floats are most precise near 0
+			else _origin[k] = (min_p[k]+max_p[k])/2;
+		}
+
+		for(int i=0; i<n; ++i)
+		{
+			const Point<3, T>& p = pointvec[order?(*order)[i]:i];
+			for(int k=0; k<3; ++k)
+			{
+				double offset = p[k]-_origin[k];
+				uint16_t q;
+				if(_mode==QuantizationMode::FIXED16) q = static_cast<uint16_t>(std::min(65535.0, std::floor(offset/_resolution+0.5)));
+				else q = float_to_half(static_cast<float>(offset));
+				_data[3*static_cast<size_t>(i)+k] = q;
+				_max_error = std::max(_max_error, std::abs(decode_value(q, k)-static_cast<double>(p[k])));
+			}
+		}
+	}
+
+	/**
+	* @brief decode the \f$i^{th}\f$ point
+	*
+	* @param i point index
+	* @param xyz decoded coordinates
+	*/
+	void decode(int i, T* xyz) const
+	{
+		const uint16_t* q = &_data[3*static_cast<size_t>(i)];
+		if(_mode==QuantizationMode::FIXED16)
+		{
+			for(int k=0; k<3; ++k) xyz[k] = _origin[k] + static_cast<T>(q[k]*_resolution);
+		}
+		else
+		{
+			const float* table = half_table();
+			for(int k=0; k<3; ++k) xyz[k] = _origin[k] + table[q[k]];
+		}
+	}
+
+	/// @brief decode the \f$i^{th}\f$ point
+	Point<3, T> point(int i) const
+	{
+		Point<3, T> p;
+		T xyz[3];
+		decode(i, xyz);
+		for(int k=0; k<3; ++k) p[k] = xyz[k];
+		return p;
+	}
+
+	/// @brief number of points
+	size_t size() const
+	{
+		return _data.size()/3;
+	}
+
+	/// @brief memory used by the encoded coordinates in bytes
+	size_t memory_bytes() const
+	{
+		return _data.size()*sizeof(uint16_t);
+	}
+
+	/// @brief maximum absolute coordinate error of the encoded points
+	double get_max_error() const
+	{
+		return _max_error;
+	}
+
+	QuantizationMode get_mode() const
+	{
+		return _mode;
+	}
+
+private:
+	QuantizationMode _mode;
+
+	/// @brief quantization step of FIXED16 mode
+	double _resolution;
+
+	/// @brief origin the coordinates are relative to
+	T _origin[3];
+
+	/// @brief encoded coordinates, 3 per point
+	std::vector<uint16_t> _data;
+
+	/// @brief maximum absolute coordinate error
+	double _max_error;
+
+	/// @brief decode a single coordinate along dimension k
+	double decode_value(uint16_t q, int k) const
+	{
+		if(_mode==QuantizationMode::FIXED16) return _origin[k] + static_cast<T>(q*_resolution);
+		return _origin[k] + half_table()[q];
+	}
+};
+
+#endif
@@ -2,37 +2,32 @@
 #define __ASTAR_PLANNER_H__
 
 #include "planning_lib/base_global_planner.h"
-#include <limits>
-#include <queue>
+#include "planning_lib/grid_search_workspace.h"
 #include <algorithm>
-#include <iostream>
 
 /**
 * @brief A* planner for 2d maps.
+*
+* With an inflation layer set on the map, cells the robot footprint can't occupy are not expanded, and an optional clearance
+* weight w scales the cost of a step into a cell with inflation cost c by \f$1+w c/253\f$, so paths keep away from obstacles.
+* Step costs never drop below the euclidean step, so the octile heuristic stays consistent and every cell is expanded at most once.
+*
+* The search runs on row-major cell indices with a `GridSearchWorkspace` kept between queries, so repeated queries don't
+* reallocate or reinitialize per-cell state
 */
 class AstarPlanner2d: public BaseGlobalPlanner2d
 {
 public:
+	/// @brief Default constructor
+	AstarPlanner2d(): _clearance_weight(0) {}
+
 	/**
-	* @brief A* node containing information about parent indices and computed costs
+	* @brief set weight of the inflation cost in the step cost, only used if the map has an inflation layer
 	*/
-	struct AstarNode
+	void set_clearance_weight(float weight)
 	{
-		// parent index
-		Point2i parent;
-		// cost to reach this node from start node
-		float cost_to_reach;
-		// heuristic cost - cost to reach goal, euclidean distance from this node to goal
-		float heuristic_cost;
-		// total cost = cost to reach + heuristic cost
-		float cost;
-
-		AstarNode(): parent({-1, -1}), cost_to_reach(std::numeric_limits<float>::max()), 
-			heuristic_cost(std::numeric_limits<float>::max()), cost(std::numeric_limits<float>::max()) {}
-	};
-
-	/// @brief Default constructor
-	AstarPlanner2d() {}
+		_clearance_weight = std::max(0.0f, weight);
+	}
 
 	/**
 	* @brief computes path using A* search from start to end points
@@ -43,7 +38,7 @@ public:
 		int si=0, sj=0, gi=0, gj=0;
 		if(_map.xy_to_ij(start[0], start[1], si, sj) && _map.xy_to_ij(goal[0], goal[1], gi, gj))
 		{
-			if(_map(si, sj)==0 && _map(gi, gj)==0)
+			if(_map.is_traversable(si, sj) && _map.is_traversable(gi, gj))
 			{
 				Point2i start_i({si, sj});
 				Point2i goal_i({gi, gj});
@@ -61,69 +56,76 @@ public:
 		}
 		return std::vector<Point2f>();
 	}
-private:
-	/// @brief typedef to store elements in a priority queue
-	typedef std::pair<Point2i, std::pair<float, float>> PQ_Element;
 
-	/// @brief A* search method
-	std::vector<Point2i> astar(Point2i& start, Point2i& goal)
+	/// @brief number of cells expanded by the last search
+	virtual size_t get_num_expanded()
+	{
+		return _workspace.num_pops();
+	}
+
+	/// @brief number of heap insertions of the last search
+	virtual size_t get_num_pushes()
+	{
+		return _workspace.num_pushes();
+	}
+
+protected:
+	/// @brief weight of the inflation cost in the step cost
+	float _clearance_weight;
+
+	/// @brief search state, kept between queries
+	GridSearchWorkspace _workspace;
+
+	/// @brief cost of a move of length `step` cells into cell (i,j)
+	float step_cost(float step, int i, int j, float clearance_scale)
+	{
+		if(clearance_scale > 0) return step*(1 + clearance_scale*_map.cost(i, j));
+		return step;
+	}
+
+	/**
+	* @brief A* search method on row-major cell indices
+	*
+	* 8-connected moves into traversable cells with octile heuristic, cells are expanded at most once
+	*/
+	virtual std::vector<Point2i> astar(Point2i& start, Point2i& goal)
 	{
+		static const int di[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+		static const int dj[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+		static const float step[8] = {1.41421356f, 1, 1.41421356f, 1, 1, 1.41421356f, 1, 1.41421356f};
+
 		int width = _map.get_width(), height = _map.get_height();
-		// vector of A* nodes with info about parent indices and computed costs
-		std::vector<AstarNode> nodes(width*height, AstarNode());
-		// comparator for elements in the priority queue
-		auto comp = [](PQ_Element& a, PQ_Element& b){
-			if(a.second.first == b.second.first) return a.second.second > b.second.second;
-			return a.second.first > b.second.first;
-		};
-		std::priority_queue<PQ_Element, std::vector<PQ_Element>, decltype(comp)> pq(comp);
-		
-		int ind = start[0]*width+start[1];
-		nodes[ind].cost_to_reach = 0;
-		nodes[ind].heuristic_cost = goal.distance_to(start);
-		nodes[ind].cost = nodes[ind].cost_to_reach + nodes[ind].heuristic_cost;
-		pq.push({start, std::pair<float, float>{nodes[ind].cost, nodes[ind].cost_to_reach}});
+		_workspace.reset(static_cast<int64_t>(width)*height);
+		int32_t start_c = start[0]*width+start[1], goal_c = goal[0]*width+goal[1];
+		int gi = goal[0], gj = goal[1];
+		float clearance_scale = _map.has_inflation()?_clearance_weight/253.0f:0.0f;
 
+		_workspace.node(start_c).g = 0;
+		_workspace.push(start_c, octile_distance(start[0]-gi, start[1]-gj));
 		bool goal_reached = false;
-		while(!pq.empty())
+		while(!_workspace.empty())
 		{
-			PQ_Element cur = pq.top();
-			pq.pop();
-
-			if(goal.is_equal_to(cur.first))
+			int32_t c = _workspace.pop();
+			if(c==goal_c)
 			{
 				goal_reached = true;
 				break;
 			}
-
-			int cur_ind = cur.first[0]*width+cur.first[1];
-			// check neighbors if they are valid and not occupied and add to queue if they satisfy the validity conditions
-			for(int i=-1; i<=1; ++i)
+			int ci = c/width, cj = c%width;
+			float g = _workspace.node(c).g;
+			for(int k=0; k<8; ++k)
 			{
-				for(int j=-1; j<=1; ++j)
+				int ni = ci+di[k], nj = cj+dj[k];
+				if(ni<0 || ni>=height || nj<0 || nj>=width || !_map.is_traversable(ni, nj)) continue;
+				int32_t n = ni*width+nj;
+				GridSearchWorkspace::Node& node = _workspace.node(n);
+				if(node.heap_index==GridSearchWorkspace::closed) continue;
+				float cost = step_cost(step[k], ni, nj, clearance_scale);
+				if(g+cost < node.g)
 				{
-					if(i!=0 || j!=0)
-					{
-						Point2i neighbor({cur.first[0]+i, cur.first[1]+j});
-						if(neighbor[0]>=0 && neighbor[0]<height && neighbor[1]>=0 && neighbor[1]<width)
-						{
-							if(_map(neighbor[0], neighbor[1])==0)
-							{
-								ind = neighbor[0]*width+neighbor[1];
-								float cost_to_reach = nodes[cur_ind].cost_to_reach + neighbor.distance_to(cur.first);
-								float heuristic_cost = goal.distance_to(neighbor);
-								float cost = cost_to_reach + heuristic_cost;
-								if(cost < nodes[ind].cost)
-								{
-									pq.push({neighbor, std::pair<float, float>{cost, cost_to_reach}});
-									nodes[ind].parent = cur.first;
-									nodes[ind].cost_to_reach = cost_to_reach;
-									nodes[ind].heuristic_cost = heuristic_cost;
-									nodes[ind].cost = cost;
-								}
-							}
-						}
-					}
+					node.g = g+cost;
+					node.parent = c;
+					_workspace.push(n, node.g + octile_distance(ni-gi, nj-gj));
 				}
 			}
 		}
@@ -132,16 +134,7 @@ private:
 		std::vector<Point2i> path;
 		if(goal_reached)
 		{
-			auto path_point = goal;
-			path.push_back(path_point);
-			ind = path_point[0]*width+path_point[1];
-			while(!(nodes[ind].parent[0]==-1 && nodes[ind].parent[1]==-1))
-			{
-				path_point = nodes[ind].parent;
-				path.push_back(path_point);
-				ind = path_point[0]*width+path_point[1];
-			}
-			std::reverse(path.begin(), path.end());
+			for(int32_t c: _workspace.trace_back(goal_c)) path.push_back(Point2i({c/width, c%width}));
 		}
 		return path;
 	}
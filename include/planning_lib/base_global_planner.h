@@ -22,6 +22,32 @@ public:
 		_map.set(data, resolution, width, height, origin);
 	}
 
+	/**
+	* @overload
+	*
+	* adopts the buffer of data without copying, e.g. `set_map(std::move(cells), ...)`
+	*/
+	void set_map(std::vector<int8_t>&& data, float resolution, int width, int height, Point2f origin)
+	{
+		_map.set(std::move(data), resolution, width, height, origin);
+	}
+
+	/**
+	* @overload
+	*
+	* takes over a grid, e.g. loaded with `load_map`
+	*/
+	void set_map(OccupancyGrid2d&& map)
+	{
+		_map = std::move(map);
+	}
+
+	/// @brief occupancy grid describing the world map
+	OccupancyGrid2d& get_map()
+	{
+		return _map;
+	}
+
 	/**
 	* @brief virtual function that needs to be defined by derived planner classes
 	*
@@ -0,0 +1,111 @@
+#ifndef __BIDIRECTIONAL_ASTAR_PLANNER_H__
+#define __BIDIRECTIONAL_ASTAR_PLANNER_H__
+
+#include "planning_lib/astar_planner.h"
+
+/**
+* @brief Bidirectional A* planner for 2d maps
+*
+* @details Runs a forward search from the start and a backward search from the goal over reversed moves, each on its own
+* reusable workspace, always expanding the side with the smaller open list. Both sides use the balanced potential
+* \f$p(v) = (h_{goal}(v) - h_{start}(v))/2\f$ of the octile distances to goal and start, forward keys being \f$g_f(v) + p(v)\f$
+* and backward keys \f$g_b(v) - p(v)\f$. Both potentials are consistent, so this is a bidirectional Dijkstra on the same
+* non-negative reduced move costs, cells are expanded at most once per side, and whenever a cell reached by one side has been
+* reached by the other, the path through it is a candidate and the cheapest one, \f$\mu\f$, is kept. The search stops as soon
+* as the smallest keys of both sides add up to at least \f$\mu\f$, after which no cheaper path can exist (with separate
+* heuristics for both sides the matching criterion is much weaker, and both searches tend to run to completion).
+* Moves, costs and clearance weight are the same as in `AstarPlanner2d`, a move into cell c costing the same in both directions
+*/
+class BidirectionalAstarPlanner2d: public AstarPlanner2d
+{
+public:
+	/// @brief Default constructor
+	BidirectionalAstarPlanner2d() {}
+
+	/// @brief number of cells expanded by both sides in the last search
+	size_t get_num_expanded()
+	{
+		return _workspace.num_pops() + _backward_workspace.num_pops();
+	}
+
+	/// @brief number of heap insertions of both sides in the last search
+	size_t get_num_pushes()
+	{
+		return _workspace.num_pushes() + _backward_workspace.num_pushes();
+	}
+
+protected:
+	/// @brief search state of the backward search, the forward search uses the workspace of `AstarPlanner2d`
+	GridSearchWorkspace _backward_workspace;
+
+	/// @brief bidirectional search on row-major cell indices
+	std::vector<Point2i> astar(Point2i& start, Point2i& goal)
+	{
+		static const int di[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+		static const int dj[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+		static const float step[8] = {1.41421356f, 1, 1.41421356f, 1, 1, 1.41421356f, 1, 1.41421356f};
+
+		int width = _map.get_width(), height = _map.get_height();
+		int64_t n = static_cast<int64_t>(width)*height;
+		_workspace.reset(n);
+		_backward_workspace.reset(n);
+		int32_t start_c = start[0]*width+start[1], goal_c = goal[0]*width+goal[1];
+		float clearance_scale = _map.has_inflation()?_clearance_weight/253.0f:0.0f;
+
+		GridSearchWorkspace* workspaces[2] = {&_workspace, &_backward_workspace};
+		workspaces[0]->node(start_c).g = 0;
+		workspaces[1]->node(goal_c).g = 0;
+		// balanced potential of cell (i,j), added to forward keys and subtracted from backward keys
+		auto potential = [&](int i, int j)
+		{
+			return 0.5f*(octile_distance(i-goal[0], j-goal[1]) - octile_distance(i-start[0], j-start[1]));
+		};
+		workspaces[0]->push(start_c, potential(start[0], start[1]));
+		workspaces[1]->push(goal_c, -potential(goal[0], goal[1]));
+
+		float best = (start_c==goal_c)?0:std::numeric_limits<float>::infinity();
+		int32_t meet = (start_c==goal_c)?start_c:-1;
+		while(!workspaces[0]->empty() && !workspaces[1]->empty())
+		{
+			if(best <= workspaces[0]->top_key() + workspaces[1]->top_key()) break;
+			int side = (workspaces[0]->num_pushes()-workspaces[0]->num_pops() <=
+				workspaces[1]->num_pushes()-workspaces[1]->num_pops())?0:1;
+			GridSearchWorkspace& ws = *workspaces[side];
+			GridSearchWorkspace& other = *workspaces[1-side];
+			int32_t c = ws.pop();
+			int ci = c/width, cj = c%width;
+			float g = ws.node(c).g;
+			// backward moves go from neighbor into c, so they pay the cost of entering c
+			for(int k=0; k<8; ++k)
+			{
+				int ni = ci+di[k], nj = cj+dj[k];
+				if(ni<0 || ni>=height || nj<0 || nj>=width || !_map.is_traversable(ni, nj)) continue;
+				int32_t nc = ni*width+nj;
+				GridSearchWorkspace::Node& node = ws.node(nc);
+				if(node.heap_index==GridSearchWorkspace::closed) continue;
+				float cost = (side==0)?step_cost(step[k], ni, nj, clearance_scale):step_cost(step[k], ci, cj, clearance_scale);
+				if(g+cost < node.g)
+				{
+					node.g = g+cost;
+					node.parent = c;
+					ws.push(nc, node.g + ((side==0)?potential(ni, nj):-potential(ni, nj)));
+					if(other.visited(nc) && node.g + other.node(nc).g < best)
+					{
+						best = node.g + other.node(nc).g;
+						meet = nc;
+					}
+				}
+			}
+		}
+
+		// forward half from the start to the meeting cell, backward half from the meeting cell to the goal
+		std::vector<Point2i> path;
+		if(meet < 0) return path;
+		for(int32_t c: _workspace.trace_back(meet)) path.push_back(Point2i({c/width, c%width}));
+		std::vector<int32_t> backward = _backward_workspace.trace_back(meet);
+		for(int k=static_cast<int>(backward.size())-2; k>=0; --k) path.push_back(Point2i({backward[k]/width, backward[k]%width}));
+		return path;
+	}
+};
+
+#endif
@@ -0,0 +1,366 @@
+#ifndef __DSTAR_LITE_PLANNER_H__
+#define __DSTAR_LITE_PLANNER_H__
+
+#include "planning_lib/astar_planner.h"
+
+/**
+* @brief Incremental planner for 2d maps with a moving start (D* Lite)
+*
+* @details The search runs backward from the goal and keeps, for every cell, its cost to the goal g and a one-step lookahead
+* rhs computed from the g of its neighbors (Koenig and Likhachev, 2002). Cells where the two differ are queued with keys
+* that include the heuristic distance to the current start, and only those are repaired. After cells change (`update_cells`)
+* and the robot moves, the next `compute_plan` with the same goal updates the cells around the changes and propagates the
+* differences as far as they affect the path from the new start, instead of searching the whole map again.
+*
+* Moves and step costs are those of `AstarPlanner2d`, including the clearance weight, so paths have the same optimal cost.
+* The search state is dropped and rebuilt when the goal, the clearance weight or the map size changes, and with `reset`,
+* which is needed after the map is replaced by one of the same size.
+* The state takes 12 bytes per cell besides the queue
+*/
+class DStarLitePlanner2d: public AstarPlanner2d
+{
+public:
+	/// @brief Default constructor
+	DStarLitePlanner2d(): _start(-1), _last(-1), _goal(-1), _km(0), _state_clearance_scale(0), _num_expanded(0),
+		_num_pushes(0) {}
+
+	/**
+	* @brief computes path from start to goal, repairing the search state of the previous call if the goal is the same
+	*
+	* @return returns every cell of the path from start to goal, like `AstarPlanner2d`
+	*/
+	std::vector<Point2f> compute_plan(Point2f& start, Point2f& goal)
+	{
+		int si=0, sj=0, gi=0, gj=0;
+		std::vector<Point2f> path_f;
+		if(!_map.xy_to_ij(start[0], start[1], si, sj) || !_map.xy_to_ij(goal[0], goal[1], gi, gj)) return path_f;
+		if(!_map.is_traversable(si, sj) || !_map.is_traversable(gi, gj)) return path_f;
+
+		int width = _map.get_width();
+		int64_t num_cells = static_cast<int64_t>(width)*_map.get_height();
+		if(num_cells > std::numeric_limits<int32_t>::max()) throw std::domain_error("map too large for 32 bit cell indices");
+		int32_t start_c = si*width+sj, goal_c = gi*width+gj;
+		float clearance_scale = _map.has_inflation()?_clearance_weight/253.0f:0.0f;
+		_num_expanded = 0;
+		_num_pushes = 0;
+		if(static_cast<size_t>(num_cells)!=_g.size() || goal_c!=_goal || clearance_scale!=_state_clearance_scale)
+		{
+			initialize(num_cells, start_c, goal_c, clearance_scale);
+		}
+		else
+		{
+			if(start_c!=_start)
+			{
+				// keys queued so far stay lower bounds of keys computed from the new start
+				_km += heuristic(_last, start_c);
+				_last = start_c;
+				_start = start_c;
+			}
+			// steps into and out of changed cells changed cost
+			for(int32_t c: _changed)
+			{
+				update_vertex(c);
+				update_neighbors(c);
+			}
+		}
+		_changed.clear();
+		compute_shortest_path();
+
+		for(int32_t c: extract_path())
+		{
+			Point2f point;
+			_map.ij_to_xy(c/width, c%width, point[0], point[1]);
+			path_f.push_back(point);
+		}
+		return path_f;
+	}
+
+	/**
+	* @brief notify the planner that cells changed since the last call, e.g. after `OccupancyGrid2d::set_cell`
+	*
+	* the cells and their neighbors are updated on the next `compute_plan`
+	*/
+	void update_cells(const std::vector<Point2i>& cells)
+	{
+		for(auto& cell: cells) _changed.push_back(cell[0]*_map.get_width()+cell[1]);
+	}
+
+	/**
+	* @brief notify the planner of all cells in the dirty region of the map (see `OccupancyGrid2d::set_cell`) and clear it
+	*
+	* @note call `update_inflation_incremental` on the map first when the inflation layer is used
+	*/
+	void update_from_dirty_region()
+	{
+		int i_min, j_min, i_max, j_max;
+		if(_map.get_dirty_region(i_min, j_min, i_max, j_max))
+		{
+			int width = _map.get_width();
+			for(int i=i_min; i<=i_max; ++i) for(int j=j_min; j<=j_max; ++j) _changed.push_back(i*width+j);
+		}
+		_map.clear_dirty_region();
+	}
+
+	/// @brief drop the search state, the next `compute_plan` searches from scratch
+	void reset()
+	{
+		std::vector<float>().swap(_g);
+		std::vector<float>().swap(_rhs);
+		std::vector<int32_t>().swap(_heap_index);
+		_heap.clear();
+		_changed.clear();
+		_goal = -1;
+	}
+
+	/// @brief number of cells expanded by the last call
+	size_t get_num_expanded()
+	{
+		return _num_expanded;
+	}
+
+	/// @brief number of queue insertions of the last call
+	size_t get_num_pushes()
+	{
+		return _num_pushes;
+	}
+
+private:
+	/// @brief lexicographically ordered queue key
+	typedef std::pair<float, float> Key;
+
+	/// @brief current start, start at the last update of `_km`, and goal cells
+	int32_t _start, _last, _goal;
+
+	/// @brief sum of heuristic distances between successive starts, added to keys instead of requeueing all cells
+	float _km;
+
+	/// @brief clearance scale of the step costs the state was computed with
+	float _state_clearance_scale;
+
+	/// @brief cost to the goal and one-step lookahead cost of every cell
+	std::vector<float> _g, _rhs;
+
+	/// @brief position of every cell in the heap, -1 if not queued
+	std::vector<int32_t> _heap_index;
+
+	/// @brief binary min-heap of (key, cell) of inconsistent cells
+	std::vector< std::pair<Key, int32_t> > _heap;
+
+	/// @brief cells changed since the last call
+	std::vector<int32_t> _changed;
+
+	size_t _num_expanded, _num_pushes;
+
+	bool inside(int i, int j)
+	{
+		return i>=0 && j>=0 && i<_map.get_height() && j<_map.get_width();
+	}
+
+	float heuristic(int32_t a, int32_t b)
+	{
+		int width = _map.get_width();
+		return octile_distance(a/width-b/width, a%width-b%width);
+	}
+
+	Key calculate_key(int32_t c)
+	{
+		float g = std::min(_g[c], _rhs[c]);
+		return Key(g+heuristic(_start, c)+_km, g);
+	}
+
+	/// @brief start a new search from the goal
+	void initialize(int64_t num_cells, int32_t start, int32_t goal, float clearance_scale)
+	{
+		_g.assign(num_cells, std::numeric_limits<float>::infinity());
+		_rhs.assign(num_cells, std::numeric_limits<float>::infinity());
+		_heap_index.assign(num_cells, -1);
+		_heap.clear();
+		_start = _last = start;
+		_goal = goal;
+		_km = 0;
+		_state_clearance_scale = clearance_scale;
+		_rhs[goal] = 0;
+		heap_update(goal, calculate_key(goal));
+	}
+
+	/// @brief lowest cost of moving from cell c to a neighbor and on to the goal
+	float lookahead(int32_t c)
+	{
+		static const int di[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+		static const int dj[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+		static const float step[8] = {1.41421356f, 1, 1.41421356f, 1, 1, 1.41421356f, 1, 1.41421356f};
+		int width = _map.get_width(), ci = c/width, cj = c%width;
+		float best = std::numeric_limits<float>::infinity();
+		if(!_map.is_traversable(ci, cj)) return best;
+		for(int k=0; k<8; ++k)
+		{
+			int ni = ci+di[k], nj = cj+dj[k];
+			if(!inside(ni, nj) || !_map.is_traversable(ni, nj)) continue;
+			int32_t n = ni*width+nj;
+			if(_g[n] < best) best = std::min(best, _g[n]+step_cost(step[k], ni, nj, _state_clearance_scale));
+		}
+		return best;
+	}
+
+	/// @brief recompute rhs of cell c and queue it if it is inconsistent
+	void update_vertex(int32_t c)
+	{
+		if(c!=_goal) _rhs[c] = lookahead(c);
+		if(_g[c]!=_rhs[c]) heap_update(c, calculate_key(c));
+		else if(_heap_index[c] >= 0) heap_remove(c);
+	}
+
+	/// @brief update the neighbors of cell c, whose lookahead goes through c
+	void update_neighbors(int32_t c)
+	{
+		int width = _map.get_width(), ci = c/width, cj = c%width;
+		for(int k=0; k<9; ++k)
+		{
+			int ni = ci+k/3-1, nj = cj+k%3-1;
+			if(k!=4 && inside(ni, nj)) update_vertex(ni*width+nj);
+		}
+	}
+
+	/**
+	* @brief expand inconsistent cells until the start is consistent and no queued key is lower than its key
+	*
+	* keys queued before the start moved are lower bounds of their current keys only up to rounding, so cells whose first key
+	* component ties with the start's within rounding are expanded too
+	*/
+	void compute_shortest_path()
+	{
+		while(!_heap.empty())
+		{
+			float start_key = calculate_key(_start).first;
+			if(_heap[0].first.first > start_key + 1e-5f*start_key && _rhs[_start]==_g[_start]) break;
+			Key old_key = _heap[0].first;
+			int32_t c = _heap[0].second;
+			Key new_key = calculate_key(c);
+			++_num_expanded;
+			if(old_key < new_key) heap_update(c, new_key);
+			else if(_g[c] > _rhs[c])
+			{
+				// overconsistent, the cost to the goal dropped
+				_g[c] = _rhs[c];
+				heap_remove(c);
+				update_neighbors(c);
+			}
+			else
+			{
+				// underconsistent, the cost to the goal rose
+				_g[c] = std::numeric_limits<float>::infinity();
+				update_vertex(c);
+				update_neighbors(c);
+			}
+		}
+	}
+
+	/// @brief cells from the start to the goal, moving to the neighbor with the lowest step cost plus cost to the goal
+	std::vector<int32_t> extract_path()
+	{
+		static const int di[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+		static const int dj[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+		static const float step[8] = {1.41421356f, 1, 1.41421356f, 1, 1, 1.41421356f, 1, 1.41421356f};
+		std::vector<int32_t> path;
+		if(!(_g[_start] < std::numeric_limits<float>::infinity())) return path;
+		int width = _map.get_width();
+		int32_t c = _start;
+		path.push_back(c);
+		while(c!=_goal && path.size() <= _g.size())
+		{
+			int ci = c/width, cj = c%width;
+			float best = std::numeric_limits<float>::infinity();
+			int32_t next = -1;
+			for(int k=0; k<8; ++k)
+			{
+				int ni = ci+di[k], nj = cj+dj[k];
+				if(!inside(ni, nj) || !_map.is_traversable(ni, nj)) continue;
+				int32_t n = ni*width+nj;
+				float cost = _g[n]+step_cost(step[k], ni, nj, _state_clearance_scale);
+				if(cost < best)
+				{
+					best = cost;
+					next = n;
+				}
+			}
+			if(next < 0) return std::vector<int32_t>();
+			c = next;
+			path.push_back(c);
+		}
+		if(c!=_goal) path.clear();
+		return path;
+	}
+
+	/// @brief insert cell c with key, or change its key if it is queued
+	void heap_update(int32_t c, Key key)
+	{
+		int32_t i = _heap_index[c];
+		if(i < 0)
+		{
+			i = _heap.size();
+			_heap.push_back(std::make_pair(key, c));
+			++_num_pushes;
+			sift_up(i);
+		}
+		else if(key < _heap[i].first)
+		{
+			_heap[i].first = key;
+			sift_up(i);
+		}
+		else
+		{
+			_heap[i].first = key;
+			sift_down(i);
+		}
+	}
+
+	void heap_remove(int32_t c)
+	{
+		int32_t i = _heap_index[c];
+		_heap_index[c] = -1;
+		std::pair<Key, int32_t> last = _heap.back();
+		_heap.pop_back();
+		if(i < static_cast<int32_t>(_heap.size()))
+		{
+			_heap[i] = last;
+			_heap_index[last.second] = i;
+			sift_up(i);
+			sift_down(_heap_index[last.second]);
+		}
+	}
+
+	void sift_up(int32_t i)
+	{
+		std::pair<Key, int32_t> entry = _heap[i];
+		while(i > 0)
+		{
+			int32_t parent = (i-1)/2;
+			if(!(entry.first < _heap[parent].first)) break;
+			_heap[i] = _heap[parent];
+			_heap_index[_heap[i].second] = i;
+			i = parent;
+		}
+		_heap[i] = entry;
+		_heap_index[entry.second] = i;
+	}
+
+	void sift_down(int32_t i)
+	{
+		int32_t n = _heap.size();
+		std::pair<Key, int32_t> entry = _heap[i];
+		while(true)
+		{
+			int32_t child = 2*i+1;
+			if(child >= n) break;
+			if(child+1 < n && _heap[child+1].first < _heap[child].first) ++child;
+			if(!(_heap[child].first < entry.first)) break;
+			_heap[i] = _heap[child];
+			_heap_index[_heap[i].second] = i;
+			i = child;
+		}
+		_heap[i] = entry;
+		_heap_index[entry.second] = i;
+	}
+};
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef __GRID_SEARCH_WORKSPACE_H__
+#define __GRID_SEARCH_WORKSPACE_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+* @brief Per-cell search state and open list for best-first searches on grids, reusable across queries
+*
+* @details Nodes are 16 bytes per cell (cost to reach, parent cell, generation stamp, heap position) in a flat array
+* indexed by the row-major cell index. Starting a search only increments the generation, and a node is reset lazily the
+* first time it is touched in a search, so a query costs time proportional to the cells it visits rather than the map size.
+* The open list is a binary heap of (key, cell) pairs that knows the position of every queued cell, so improving a queued
+* cell moves it up in place instead of pushing a duplicate
+*/
+class GridSearchWorkspace
+{
+public:
+	/// @brief heap position of cells not in the open list
+	static const int32_t not_queued = -1;
+
+	/// @brief heap position of expanded cells
+	static const int32_t closed = -2;
+
+	struct Node
+	{
+		/// @brief cost to reach the cell from the search start
+		float g;
+		/// @brief previous cell on the best known path, -1 for the start
+		int32_t parent;
+		/// @brief search the node was last reset in
+		uint32_t generation;
+		/// @brief position in the heap, or `not_queued` / `closed`
+		int32_t heap_index;
+	};
+
+	GridSearchWorkspace(): _generation(0), _num_pushes(0), _num_pops(0) {}
+
+	/**
+	* @brief start a new search over a map of `num_cells` cells
+	*/
+	void reset(int64_t num_cells)
+	{
+		if(num_cells > std::numeric_limits<int32_t>::max()) throw std::domain_error("map too large for 32 bit cell indices");
+		if(_nodes.size() != static_cast<size_t>(num_cells))
+		{
+			_nodes.assign(num_cells, Node());
+			for(Node& node: _nodes) node.generation = 0;
+			_generation = 0;
+		}
+		++_generation;
+		if(_generation==0)
+		{
+			// generation wrapped around, stamps of old searches could match again
+			for(Node& node: _nodes) node.generation = 0;
+			_generation = 1;
+		}
+		_heap.clear();
+		_num_pushes = 0;
+		_num_pops = 0;
+	}
+
+	/**
+	* @brief node of cell c, reset if it was not touched in the current search
+	*/
+	Node& node(int32_t c)
+	{
+		Node& n = _nodes[c];
+		if(n.generation != _generation)
+		{
+			n.g = std::numeric_limits<float>::infinity();
+			n.parent = -1;
+			n.generation = _generation;
+			n.heap_index = not_queued;
+		}
+		return n;
+	}
+
+	/// @brief check if cell c was touched in the current search
+	bool visited(int32_t c)
+	{
+		return _nodes[c].generation==_generation;
+	}
+
+	/// @brief check if cell c was expanded in the current search
+	bool is_closed(int32_t c)
+	{
+		return visited(c) && _nodes[c].heap_index==closed;
+	}
+
+	/// @brief check if the open list is empty
+	bool empty()
+	{
+		return _heap.empty();
+	}
+
+	/// @brief smallest key in the open list
+	float top_key()
+	{
+		return _heap[0].first;
+	}
+
+	/// @brief cell with the smallest key in the open list
+	int32_t top()
+	{
+		return _heap[0].second;
+	}
+
+	/**
+	* @brief insert cell c with key, or lower its key if it is already queued
+	*/
+	void push(int32_t c, float key)
+	{
+		Node& n = node(c);
+		int32_t i = n.heap_index;
+		if(i < 0)
+		{
+			i = _heap.size();
+			_heap.push_back(std::make_pair(key, c));
+			++_num_pushes;
+		}
+		else if(key < _heap[i].first) _heap[i].first = key;
+		else return;
+		sift_up(i);
+	}
+
+	/**
+	* @brief remove the cell with the smallest key from the open list and mark it closed
+	*/
+	int32_t pop()
+	{
+		int32_t c = _heap[0].second;
+		_nodes[c].heap_index = closed;
+		std::pair<float, int32_t> last = _heap.back();
+		_heap.pop_back();
+		++_num_pops;
+		if(!_heap.empty())
+		{
+			_heap[0] = last;
+			_nodes[last.second].heap_index = 0;
+			sift_down(0);
+		}
+		return c;
+	}
+
+	/// @brief number of heap insertions in the current search
+	size_t num_pushes()
+	{
+		return _num_pushes;
+	}
+
+	/// @brief number of expanded cells in the current search
+	size_t num_pops()
+	{
+		return _num_pops;
+	}
+
+	/**
+	* @brief cells from the search start to cell c following parents
+	*/
+	std::vector<int32_t> trace_back(int32_t c)
+	{
+		std::vector<int32_t> cells;
+		while(c >= 0)
+		{
+			cells.push_back(c);
+			c = _nodes[c].parent;
+		}
+		std::reverse(cells.begin(), cells.end());
+		return cells;
+	}
+
+	/// @brief memory used by the nodes and the heap in bytes
+	size_t memory_bytes()
+	{
+		return _nodes.capacity()*sizeof(Node) + _heap.capacity()*sizeof(std::pair<float, int32_t>);
+	}
+
+private:
+	std::vector<Node> _nodes;
+
+	/// @brief binary min-heap of (key, cell)
+	std::vector< std::pair<float, int32_t> > _heap;
+
+	uint32_t _generation;
+
+	size_t _num_pushes, _num_pops;
+
+	void sift_up(int32_t i)
+	{
+		std::pair<float, int32_t> entry = _heap[i];
+		while(i > 0)
+		{
+			int32_t parent = (i-1)/2;
+			if(!(entry.first < _heap[parent].first)) break;
+			_heap[i] = _heap[parent];
+			_nodes[_heap[i].second].heap_index = i;
+			i = parent;
+		}
+		_heap[i] = entry;
+		_nodes[entry.second].heap_index = i;
+	}
+
+	void sift_down(int32_t i)
+	{
+		int32_t n = _heap.size();
+		std::pair<float, int32_t> entry = _heap[i];
+		while(true)
+		{
+			int32_t child = 2*i+1;
+			if(child >= n) break;
+			if(child+1 < n && _heap[child+1].first < _heap[child].first) ++child;
+			if(!(_heap[child].first < entry.first)) break;
+			_heap[i] = _heap[child];
+			_nodes[_heap[i].second].heap_index = i;
+			i = child;
+		}
+		_heap[i] = entry;
+		_nodes[entry.second].heap_index = i;
+	}
+};
+
+/**
+* @brief octile distance in cells, the exact shortest path length on an empty 8-connected grid
+*/
+inline float octile_distance(int di, int dj)
+{
+	di = std::abs(di);
+	dj = std::abs(dj);
+	return std::max(di, dj) + 0.41421356f*std::min(di, dj);
+}
+
+#endif
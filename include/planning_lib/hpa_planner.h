@@ -0,0 +1,500 @@
+#ifndef __HPA_PLANNER_H__
+#define __HPA_PLANNER_H__
+
+#include "planning_lib/base_global_planner.h"
+#include "planning_lib/grid_search_workspace.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+/**
+* @brief Hierarchical path-finding planner (HPA*) for 2d maps
+*
+* @details The map is split into square clusters. Along every border between two clusters, each maximal run of cells that are
+* traversable on both sides is an entrance, with a pair of abstract nodes across the border at its middle (short runs) or at
+* both ends (runs of 6 cells or more), linked by a move of cost 1. Since diagonal moves may cut corners, a diagonal move
+* across a border between two non-traversable cells is an entrance too. Within every cluster, the shortest path lengths between
+* its abstract nodes are precomputed with Dijkstra searches restricted to the cluster (Botea, Mueller and Schaeffer, 2004).
+* Clusters are independent, so the precomputation runs in parallel.
+*
+* A query connects start and goal to the abstract nodes of their clusters, runs A* on the small abstract graph and refines
+* every step of the abstract path with a search restricted to one cluster. Paths are valid 8-connected paths like those of
+* `AstarPlanner2d`, and slightly longer in general since paths cross cluster borders only at entrances.
+* Moves have uniform cost, the clearance weight of `AstarPlanner2d` has no equivalent here.
+*
+* The abstract graph is built on the first query or with `build_abstract_graph`. When cells change, `update_cells` recomputes
+* the entrances and distances of the clusters around the changed cells only, and `update_region` those around a box of cells.
+* The graph is rebuilt on the next query when the map size changes, and with `reset`, which is needed after the map is replaced
+* by one of the same size
+*/
+class HpaPlanner2d: public BaseGlobalPlanner2d
+{
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param cluster_size cluster side in cells
+	*/
+	HpaPlanner2d(int cluster_size=32): _cluster_size(std::max(2, cluster_size)), _clusters_w(0), _clusters_h(0), _built(false),
+		_graph_width(0), _graph_height(0), _num_expanded(0) {}
+
+	/**
+	* @brief computes path using the abstract graph from start to goal points
+	*
+	* @return returns every cell of the path from start to goal, like `AstarPlanner2d`
+	*/
+	std::vector<Point2f> compute_plan(Point2f& start, Point2f& goal)
+	{
+		int si=0, sj=0, gi=0, gj=0;
+		std::vector<Point2f> path_f;
+		if(!_map.xy_to_ij(start[0], start[1], si, sj) || !_map.xy_to_ij(goal[0], goal[1], gi, gj)) return path_f;
+		if(!_map.is_traversable(si, sj) || !_map.is_traversable(gi, gj)) return path_f;
+		if(!is_built()) build_abstract_graph();
+		for(int32_t c: hpa(si, sj, gi, gj))
+		{
+			Point2f point;
+			_map.ij_to_xy(c/_map.get_width(), c%_map.get_width(), point[0], point[1]);
+			path_f.push_back(point);
+		}
+		return path_f;
+	}
+
+	/**
+	* @brief find entrances and intra-cluster distances of all clusters
+	*/
+	void build_abstract_graph()
+	{
+		_clusters_h = (_map.get_height()+_cluster_size-1)/_cluster_size;
+		_clusters_w = (_map.get_width()+_cluster_size-1)/_cluster_size;
+		int nclusters = _clusters_h*_clusters_w;
+		_clusters.assign(nclusters, Cluster());
+		_right_entrances.assign(nclusters, EntranceList());
+		_down_entrances.assign(nclusters, EntranceList());
+		_graph_width = _map.get_width();
+		_graph_height = _map.get_height();
+		_built = true;
+		update_clusters(0, 0, _clusters_h-1, _clusters_w-1);
+	}
+
+	/// @brief drop the abstract graph, the next query builds it again
+	void reset()
+	{
+		_built = false;
+		std::vector<Cluster>().swap(_clusters);
+		std::vector<EntranceList>().swap(_right_entrances);
+		std::vector<EntranceList>().swap(_down_entrances);
+	}
+
+	/**
+	* @brief recompute the abstract graph around cells in rows [i_min, i_max] and columns [j_min, j_max] after they changed
+	*
+	* entrances on the borders of the clusters containing the cells are found again, and distances are recomputed for these
+	* clusters and their neighbors, whose abstract nodes on shared borders may have changed
+	*/
+	void update_region(int i_min, int j_min, int i_max, int j_max)
+	{
+		if(!is_built()) return;
+		update_clusters(i_min/_cluster_size, j_min/_cluster_size, i_max/_cluster_size, j_max/_cluster_size);
+	}
+
+	/**
+	* @brief recompute the abstract graph around changed cells, e.g. after `OccupancyGrid2d::set_cell`
+	*
+	* only the clusters containing the cells and their neighbors are updated, so distant changes don't update the clusters
+	* between them like a single region around them would
+	*/
+	void update_cells(const std::vector<Point2i>& cells)
+	{
+		if(!is_built() || cells.empty()) return;
+		std::vector<uint8_t> changed(_clusters.size(), 0);
+		for(auto& cell: cells) changed[(cell[0]/_cluster_size)*_clusters_w + cell[1]/_cluster_size] = 1;
+		// clusters with changed cells and their neighbors
+		std::vector<int> clusters;
+		for(int k=0; k<_clusters.size(); ++k)
+		{
+			int ci = k/_clusters_w, cj = k%_clusters_w;
+			bool affected = false;
+			for(int ni=std::max(0, ci-1); ni<=std::min(_clusters_h-1, ci+1) && !affected; ++ni)
+			{
+				for(int nj=std::max(0, cj-1); nj<=std::min(_clusters_w-1, cj+1); ++nj) affected |= changed[ni*_clusters_w+nj];
+			}
+			if(affected) clusters.push_back(k);
+		}
+		update_clusters(clusters);
+	}
+
+	/**
+	* @brief update the abstract graph from the dirty region of the map (see `OccupancyGrid2d::set_cell`) and clear it
+	*
+	* the dirty region is a single box, call this after every change, or use `update_cells`, when changes are far apart
+	*
+	* @note call `update_inflation_incremental` on the map first when the inflation layer is used
+	*/
+	void update_from_dirty_region()
+	{
+		int i_min, j_min, i_max, j_max;
+		if(_map.get_dirty_region(i_min, j_min, i_max, j_max)) update_region(i_min, j_min, i_max, j_max);
+		_map.clear_dirty_region();
+	}
+
+	/// @brief number of abstract nodes, excluding start and goal
+	size_t get_num_abstract_nodes()
+	{
+		size_t n = 0;
+		for(auto& cluster: _clusters) n += cluster.nodes.size();
+		return n;
+	}
+
+	/// @brief number of abstract nodes expanded by the last query
+	size_t get_num_expanded()
+	{
+		return _num_expanded;
+	}
+
+private:
+	/// @brief pairs of neighboring cells across a border, first in the cluster, second in a neighbor cluster
+	typedef std::vector< std::pair<int32_t, int32_t> > EntranceList;
+
+	struct Cluster
+	{
+		/// @brief cells of the abstract nodes in the cluster
+		std::vector<int32_t> nodes;
+		/// @brief shortest path lengths in cells between nodes within the cluster, row-major, infinity if not connected
+		std::vector<float> dist;
+		/// @brief cells across a border linked to every node
+		std::vector< std::vector<int32_t> > links;
+	};
+
+	int _cluster_size, _clusters_w, _clusters_h;
+
+	bool _built;
+
+	/// @brief map size the abstract graph was built for
+	int _graph_width, _graph_height;
+
+	std::vector<Cluster> _clusters;
+
+	/// @brief entrances on the right and lower border of every cluster
+	std::vector<EntranceList> _right_entrances, _down_entrances;
+
+	size_t _num_expanded;
+
+	/// @brief check if the abstract graph is built for the current map size
+	bool is_built()
+	{
+		int width = _map.get_width(), height = _map.get_height();
+		return _built && width==_graph_width && height==_graph_height && _clusters_h==(height+_cluster_size-1)/_cluster_size
+			&& _clusters_w==(width+_cluster_size-1)/_cluster_size;
+	}
+
+	int cluster_of(int32_t c)
+	{
+		int width = _map.get_width();
+		return (c/width/_cluster_size)*_clusters_w + (c%width)/_cluster_size;
+	}
+
+	/// @brief cell bounds [i0, i1) x [j0, j1) of cluster k
+	void cluster_bounds(int k, int& i0, int& j0, int& i1, int& j1)
+	{
+		i0 = (k/_clusters_w)*_cluster_size;
+		j0 = (k%_clusters_w)*_cluster_size;
+		i1 = std::min(i0+_cluster_size, _map.get_height());
+		j1 = std::min(j0+_cluster_size, _map.get_width());
+	}
+
+	/**
+	* @brief recompute entrances and distances of clusters [ci_min, ci_max] x [cj_min, cj_max] and their neighbors
+	*
+	* entrances from the neighbors are found again too, diagonal entrances depend on cells of the clusters at both corners
+	*/
+	void update_clusters(int ci_min, int cj_min, int ci_max, int cj_max)
+	{
+		int ci0 = std::max(0, ci_min-1), cj0 = std::max(0, cj_min-1);
+		int ci1 = std::min(_clusters_h-1, ci_max+1), cj1 = std::min(_clusters_w-1, cj_max+1);
+		std::vector<int> clusters;
+		for(int ci=ci0; ci<=ci1; ++ci) for(int cj=cj0; cj<=cj1; ++cj) clusters.push_back(ci*_clusters_w+cj);
+		update_clusters(clusters);
+	}
+
+	/**
+	* @overload
+	*
+	* @param clusters clusters to recompute, they must include the neighbors of clusters with changed cells
+	*/
+	void update_clusters(const std::vector<int>& clusters)
+	{
+		int n = clusters.size();
+		bool parallel = !_map.is_tiled();
+		#pragma omp parallel for schedule(dynamic) if(parallel)
+		for(int t=0; t<n; ++t)
+		{
+			find_entrances(clusters[t], true);
+			find_entrances(clusters[t], false);
+		}
+		#pragma omp parallel for schedule(dynamic) if(parallel)
+		for(int t=0; t<n; ++t) build_cluster(clusters[t]);
+	}
+
+	/**
+	* @brief find entrances on the right (or lower) border of cluster k
+	*
+	* besides straight entrances, a diagonal move across the border whose two corner cells are not traversable is an entrance
+	* of its own, so that every path of the grid has an abstract counterpart. The right border also gets the diagonal move to
+	* the lower right cluster, the lower border the one to the lower left cluster
+	*/
+	void find_entrances(int k, bool right)
+	{
+		int i0, j0, i1, j1;
+		cluster_bounds(k, i0, j0, i1, j1);
+		int width = _map.get_width(), height = _map.get_height();
+		EntranceList& entrances = right?_right_entrances[k]:_down_entrances[k];
+		entrances.clear();
+		if((right && j1 >= width) || (!right && i1 >= height)) return;
+		// walk along the border, cell a inside the cluster and cell b across
+		int length = right?(i1-i0):(j1-j0);
+		int run_start = -1;
+		for(int t=0; t<=length; ++t)
+		{
+			bool open = false;
+			if(t < length)
+			{
+				int ai = right?i0+t:i1-1, aj = right?j1-1:j0+t;
+				int bi = right?ai:ai+1, bj = right?aj+1:aj;
+				open = _map.is_traversable(ai, aj) && _map.is_traversable(bi, bj);
+			}
+			if(open && run_start < 0) run_start = t;
+			if(!open && run_start >= 0)
+			{
+				std::vector<int> offsets;
+				if(t-run_start < 6) offsets.push_back((run_start+t-1)/2);
+				else
+				{
+					offsets.push_back(run_start);
+					offsets.push_back(t-1);
+				}
+				for(int o: offsets)
+				{
+					int ai = right?i0+o:i1-1, aj = right?j1-1:j0+o;
+					int32_t a = ai*width+aj, b = right?a+1:a+width;
+					entrances.push_back(std::make_pair(a, b));
+				}
+				run_start = -1;
+			}
+		}
+		for(int t=0; t<length; ++t)
+		{
+			int ai = right?i0+t:i1-1, aj = right?j1-1:j0+t;
+			if(!_map.is_traversable(ai, aj)) continue;
+			for(int s=-1; s<=1; s+=2)
+			{
+				int bi = right?ai+s:ai+1, bj = right?aj+1:aj+s;
+				bool inside = right?(bi>=i0 && (bi<i1 || (s>0 && bi<height))):(bj<j1 && (bj>=j0 || (s<0 && bj>=0)));
+				if(!inside || !_map.is_traversable(bi, bj)) continue;
+				if(_map.is_traversable(ai, bj) || _map.is_traversable(bi, aj)) continue;
+				entrances.push_back(std::make_pair(ai*width+aj, bi*width+bj));
+			}
+		}
+	}
+
+	/// @brief collect abstract nodes of cluster k from the entrances on its borders and compute their distances
+	void build_cluster(int k)
+	{
+		Cluster& cluster = _clusters[k];
+		cluster.nodes.clear();
+		cluster.links.clear();
+		auto add_link = [&cluster](int32_t a, int32_t b)
+		{
+			size_t idx = std::find(cluster.nodes.begin(), cluster.nodes.end(), a)-cluster.nodes.begin();
+			if(idx==cluster.nodes.size())
+			{
+				cluster.nodes.push_back(a);
+				cluster.links.push_back(std::vector<int32_t>());
+			}
+			cluster.links[idx].push_back(b);
+		};
+		// entrances of the cluster are on the borders of its 3x3 neighborhood
+		int ci = k/_clusters_w, cj = k%_clusters_w;
+		for(int ni=std::max(0, ci-1); ni<=std::min(_clusters_h-1, ci+1); ++ni)
+		{
+			for(int nj=std::max(0, cj-1); nj<=std::min(_clusters_w-1, cj+1); ++nj)
+			{
+				for(EntranceList* entrances: {&_right_entrances[ni*_clusters_w+nj], &_down_entrances[ni*_clusters_w+nj]})
+				{
+					for(auto& e: *entrances)
+					{
+						if(cluster_of(e.first)==k) add_link(e.first, e.second);
+						if(cluster_of(e.second)==k) add_link(e.second, e.first);
+					}
+				}
+			}
+		}
+
+		int m = cluster.nodes.size();
+		cluster.dist.assign(m*m, std::numeric_limits<float>::infinity());
+		std::vector<float> dist;
+		for(int a=0; a<m; ++a)
+		{
+			cluster_dijkstra(k, cluster.nodes[a], -1, dist, nullptr);
+			for(int b=0; b<m; ++b) cluster.dist[a*m+b] = dist[local_index(k, cluster.nodes[b])];
+		}
+	}
+
+	/// @brief index of cell c in the local arrays of cluster k
+	int local_index(int k, int32_t c)
+	{
+		int i0, j0, i1, j1;
+		cluster_bounds(k, i0, j0, i1, j1);
+		int width = _map.get_width();
+		return (c/width-i0)*(j1-j0) + (c%width-j0);
+	}
+
+	/**
+	* @brief Dijkstra search from cell source restricted to cluster k
+	*
+	* @param k cluster
+	* @param source source cell
+	* @param target cell to stop at, -1 to search the whole cluster
+	* @param dist path lengths in cells of all cells of the cluster in local order, infinity if not reached
+	* @param parent if not null, local index of the previous cell of every reached cell, -1 for the source
+	*/
+	void cluster_dijkstra(int k, int32_t source, int32_t target, std::vector<float>& dist, std::vector<int>* parent)
+	{
+		static const int di[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+		static const int dj[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+		static const float step[8] = {1.41421356f, 1, 1.41421356f, 1, 1, 1.41421356f, 1, 1.41421356f};
+		int i0, j0, i1, j1;
+		cluster_bounds(k, i0, j0, i1, j1);
+		int w = j1-j0;
+		dist.assign((i1-i0)*w, std::numeric_limits<float>::infinity());
+		if(parent) parent->assign(dist.size(), -1);
+		int src = local_index(k, source), dst = (target>=0)?local_index(k, target):-1;
+		typedef std::pair<float, int> Entry;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > pq;
+		dist[src] = 0;
+		pq.push(Entry(0, src));
+		while(!pq.empty())
+		{
+			Entry cur = pq.top();
+			pq.pop();
+			if(cur.first > dist[cur.second]) continue;
+			if(cur.second==dst) break;
+			int li = cur.second/w, lj = cur.second%w;
+			for(int n=0; n<8; ++n)
+			{
+				int ni = li+di[n], nj = lj+dj[n];
+				if(ni<0 || nj<0 || ni>=i1-i0 || nj>=w || !_map.is_traversable(i0+ni, j0+nj)) continue;
+				float d = cur.first+step[n];
+				if(d < dist[ni*w+nj])
+				{
+					dist[ni*w+nj] = d;
+					if(parent) (*parent)[ni*w+nj] = cur.second;
+					pq.push(Entry(d, ni*w+nj));
+				}
+			}
+		}
+	}
+
+	/// @brief cells of the shortest path from a to b within cluster k, excluding a
+	void refine(int k, int32_t a, int32_t b, std::vector<int32_t>& path)
+	{
+		std::vector<float> dist;
+		std::vector<int> parent;
+		cluster_dijkstra(k, a, b, dist, &parent);
+		int i0, j0, i1, j1;
+		cluster_bounds(k, i0, j0, i1, j1);
+		int w = j1-j0, width = _map.get_width();
+		std::vector<int32_t> cells;
+		for(int l=local_index(k, b); parent[l]>=0; l=parent[l]) cells.push_back((i0+l/w)*width + j0+l%w);
+		path.insert(path.end(), cells.rbegin(), cells.rend());
+	}
+
+	/// @brief abstract search and refinement, returns cells from start to goal
+	std::vector<int32_t> hpa(int si, int sj, int gi, int gj)
+	{
+		int width = _map.get_width();
+		int32_t start = si*width+sj, goal = gi*width+gj;
+		int start_cluster = cluster_of(start), goal_cluster = cluster_of(goal);
+		_num_expanded = 0;
+
+		// connect start and goal to the abstract nodes of their clusters
+		std::vector<float> start_dist, goal_dist;
+		cluster_dijkstra(start_cluster, start, -1, start_dist, nullptr);
+		cluster_dijkstra(goal_cluster, goal, -1, goal_dist, nullptr);
+
+		std::unordered_map<int32_t, float> g;
+		std::unordered_map<int32_t, int32_t> parent;
+		typedef std::pair<float, int32_t> Entry;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > pq;
+		g[start] = 0;
+		parent[start] = -1;
+		pq.push(Entry(octile_distance(si-gi, sj-gj), start));
+		bool goal_reached = false;
+		while(!pq.empty())
+		{
+			Entry cur = pq.top();
+			pq.pop();
+			int32_t u = cur.second;
+			float gu = g[u];
+			if(cur.first > gu + octile_distance(u/width-gi, u%width-gj) + 1e-4f) continue;
+			++_num_expanded;
+			if(u==goal)
+			{
+				goal_reached = true;
+				break;
+			}
+			auto relax = [&](int32_t v, float cost)
+			{
+				auto it = g.find(v);
+				if(it==g.end() || gu+cost < it->second)
+				{
+					g[v] = gu+cost;
+					parent[v] = u;
+					pq.push(Entry(gu+cost+octile_distance(v/width-gi, v%width-gj), v));
+				}
+			};
+			int k = cluster_of(u);
+			Cluster& cluster = _clusters[k];
+			if(u==start)
+			{
+				for(int32_t v: cluster.nodes)
+				{
+					float d = start_dist[local_index(k, v)];
+					if(d < std::numeric_limits<float>::infinity() && v!=u) relax(v, d);
+				}
+			}
+			if(k==goal_cluster)
+			{
+				float d = (u==start)?start_dist[local_index(k, goal)]:goal_dist[local_index(k, u)];
+				if(d < std::numeric_limits<float>::infinity()) relax(goal, d);
+			}
+			size_t a = std::find(cluster.nodes.begin(), cluster.nodes.end(), u)-cluster.nodes.begin();
+			if(a < cluster.nodes.size())
+			{
+				int m = cluster.nodes.size();
+				for(int b=0; b<m; ++b)
+				{
+					if(b!=a && cluster.dist[a*m+b] < std::numeric_limits<float>::infinity()) relax(cluster.nodes[b], cluster.dist[a*m+b]);
+				}
+				for(int32_t v: cluster.links[a]) relax(v, octile_distance(v/width-u/width, v%width-u%width));
+			}
+		}
+
+		std::vector<int32_t> path;
+		if(!goal_reached) return path;
+		std::vector<int32_t> abstract_path;
+		for(int32_t c=goal; c>=0; c=parent[c]) abstract_path.push_back(c);
+		std::reverse(abstract_path.begin(), abstract_path.end());
+		path.push_back(start);
+		for(size_t s=1; s<abstract_path.size(); ++s)
+		{
+			int32_t a = abstract_path[s-1], b = abstract_path[s];
+			// steps within a cluster are refined, links across borders are single moves
+			if(cluster_of(a)==cluster_of(b)) refine(cluster_of(a), a, b, path);
+			else path.push_back(b);
+		}
+		return path;
+	}
+};
+
+#endif
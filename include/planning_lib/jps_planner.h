@@ -0,0 +1,205 @@
+#ifndef __JPS_PLANNER_H__
+#define __JPS_PLANNER_H__
+
+#include "planning_lib/base_global_planner.h"
+#include "planning_lib/grid_search_workspace.h"
+#include <algorithm>
+
+/**
+* @brief Jump Point Search planner for 2d maps
+*
+* @details A* on uniform-cost 8-connected grids that only puts jump points in the open list (Harabor and Grastien, 2011).
+* From a cell reached in some direction, the search keeps moving in that direction over cells whose other neighbors are
+* reached at least as cheaply through the parent, and stops at the goal or at a cell with a forced neighbor (one next to an
+* obstacle that can only be reached optimally through this cell). Diagonal moves recursively scan their two straight
+* components. Moves follow the same rules as `AstarPlanner2d` (any move into a traversable cell, diagonals may cut corners),
+* so paths have the same optimal cost while large open areas cost a few scans instead of one heap operation per cell.
+* Step costs are uniform, the clearance weight of `AstarPlanner2d` has no equivalent here
+*/
+class JpsPlanner2d: public BaseGlobalPlanner2d
+{
+public:
+	/// @brief Default constructor
+	JpsPlanner2d() {}
+
+	/**
+	* @brief computes path using jump point search from start to goal points
+	*
+	* @return returns every cell of the path from start to goal, like `AstarPlanner2d`
+	*/
+	std::vector<Point2f> compute_plan(Point2f& start, Point2f& goal)
+	{
+		int si=0, sj=0, gi=0, gj=0;
+		std::vector<Point2f> path_f;
+		if(!_map.xy_to_ij(start[0], start[1], si, sj) || !_map.xy_to_ij(goal[0], goal[1], gi, gj)) return path_f;
+		if(!_map.is_traversable(si, sj) || !_map.is_traversable(gi, gj)) return path_f;
+
+		std::vector<Point2i> jump_points = jps(si, sj, gi, gj);
+		// cells between consecutive jump points lie on a straight or diagonal line
+		for(size_t k=0; k<jump_points.size(); ++k)
+		{
+			int i = jump_points[k][0], j = jump_points[k][1];
+			if(k > 0)
+			{
+				int pi = jump_points[k-1][0], pj = jump_points[k-1][1];
+				int di = (i>pi)-(i<pi), dj = (j>pj)-(j<pj);
+				while(true)
+				{
+					pi += (pi!=i)?di:0;
+					pj += (pj!=j)?dj:0;
+					if(pi==i && pj==j) break;
+					Point2f point;
+					_map.ij_to_xy(pi, pj, point[0], point[1]);
+					path_f.push_back(point);
+				}
+			}
+			Point2f point;
+			_map.ij_to_xy(i, j, point[0], point[1]);
+			path_f.push_back(point);
+		}
+		return path_f;
+	}
+
+	/// @brief number of jump points expanded by the last search
+	size_t get_num_expanded()
+	{
+		return _workspace.num_pops();
+	}
+
+	/// @brief number of heap insertions of the last search
+	size_t get_num_pushes()
+	{
+		return _workspace.num_pushes();
+	}
+
+private:
+	/// @brief search state, kept between queries
+	GridSearchWorkspace _workspace;
+
+	/// @brief goal cell of the current search
+	int _gi, _gj;
+
+	/// @brief check if (i,j) is inside the map and traversable
+	bool free(int i, int j)
+	{
+		return i>=0 && j>=0 && i<_map.get_height() && j<_map.get_width() && _map.is_traversable(i, j);
+	}
+
+	/// @brief check if a cell reached moving in direction (di,dj) has a forced neighbor
+	bool has_forced_neighbor(int i, int j, int di, int dj)
+	{
+		if(di!=0 && dj!=0) return (!free(i-di, j) && free(i-di, j+dj)) || (!free(i, j-dj) && free(i+di, j-dj));
+		if(di!=0) return (!free(i, j+1) && free(i+di, j+1)) || (!free(i, j-1) && free(i+di, j-1));
+		return (!free(i+1, j) && free(i+1, j+dj)) || (!free(i-1, j) && free(i-1, j+dj));
+	}
+
+	/**
+	* @brief move from (i,j) in direction (di,dj) until the goal, a cell with a forced neighbor or, for diagonal moves,
+	* a cell from which a straight scan finds a jump point
+	*
+	* @return returns false if an obstacle or the map border is hit first, else (i,j) is set to the jump point
+	*/
+	bool jump(int& i, int& j, int di, int dj)
+	{
+		while(true)
+		{
+			i += di;
+			j += dj;
+			if(!free(i, j)) return false;
+			if((i==_gi && j==_gj) || has_forced_neighbor(i, j, di, dj)) return true;
+			if(di!=0 && dj!=0)
+			{
+				int si = i, sj = j, ti = i, tj = j;
+				if(jump(si, sj, di, 0) || jump(ti, tj, 0, dj)) return true;
+			}
+		}
+	}
+
+	/// @brief relax jump point (i,j) reached from cell c with cost g
+	void relax(int32_t c, float g, int ci, int cj, int i, int j)
+	{
+		int32_t n = i*_map.get_width()+j;
+		GridSearchWorkspace::Node& node = _workspace.node(n);
+		if(node.heap_index==GridSearchWorkspace::closed) return;
+		float cost = g + octile_distance(i-ci, j-cj);
+		if(cost < node.g)
+		{
+			node.g = cost;
+			node.parent = c;
+			_workspace.push(n, cost + octile_distance(i-_gi, j-_gj));
+		}
+	}
+
+	/// @brief jump point search, returns jump points from start to goal
+	std::vector<Point2i> jps(int si, int sj, int gi, int gj)
+	{
+		int width = _map.get_width();
+		_workspace.reset(static_cast<int64_t>(width)*_map.get_height());
+		_gi = gi;
+		_gj = gj;
+		int32_t start_c = si*width+sj, goal_c = gi*width+gj;
+		_workspace.node(start_c).g = 0;
+		_workspace.push(start_c, octile_distance(si-gi, sj-gj));
+		bool goal_reached = false;
+		while(!_workspace.empty())
+		{
+			int32_t c = _workspace.pop();
+			if(c==goal_c)
+			{
+				goal_reached = true;
+				break;
+			}
+			int ci = c/width, cj = c%width;
+			GridSearchWorkspace::Node& node = _workspace.node(c);
+			float g = node.g;
+			// directions to scan, all 8 from the start, natural and forced neighbors otherwise
+			int dirs[8][2], ndirs = 0;
+			if(node.parent < 0)
+			{
+				for(int di=-1; di<=1; ++di) for(int dj=-1; dj<=1; ++dj) if(di!=0 || dj!=0)
+				{
+					dirs[ndirs][0] = di;
+					dirs[ndirs++][1] = dj;
+				}
+			}
+			else
+			{
+				int pi = node.parent/width, pj = node.parent%width;
+				int di = (ci>pi)-(ci<pi), dj = (cj>pj)-(cj<pj);
+				auto add = [&](int a, int b) { dirs[ndirs][0] = a; dirs[ndirs++][1] = b; };
+				add(di, dj);
+				if(di!=0 && dj!=0)
+				{
+					add(di, 0);
+					add(0, dj);
+					if(!free(ci-di, cj) && free(ci-di, cj+dj)) add(-di, dj);
+					if(!free(ci, cj-dj) && free(ci+di, cj-dj)) add(di, -dj);
+				}
+				else if(di!=0)
+				{
+					if(!free(ci, cj+1) && free(ci+di, cj+1)) add(di, 1);
+					if(!free(ci, cj-1) && free(ci+di, cj-1)) add(di, -1);
+				}
+				else
+				{
+					if(!free(ci+1, cj) && free(ci+1, cj+dj)) add(1, dj);
+					if(!free(ci-1, cj) && free(ci-1, cj+dj)) add(-1, dj);
+				}
+			}
+			for(int d=0; d<ndirs; ++d)
+			{
+				int i = ci, j = cj;
+				if(jump(i, j, dirs[d][0], dirs[d][1])) relax(c, g, ci, cj, i, j);
+			}
+		}
+
+		std::vector<Point2i> path;
+		if(goal_reached)
+		{
+			for(int32_t c: _workspace.trace_back(goal_c)) path.push_back(Point2i({c/width, c%width}));
+		}
+		return path;
+	}
+};
+
+#endif
@@ -0,0 +1,383 @@
+#ifndef __MAP_LOADER_H__
+#define __MAP_LOADER_H__
+
+#include "planning_lib/occupancy_grid2d.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+* @brief map metadata as stored in a ROS map_server style yaml file
+*/
+struct MapMetadata
+{
+	/// @brief image file path, relative paths are relative to the yaml file
+	std::string image;
+	float resolution;
+	Point2f origin;
+	bool negate;
+	float occupied_thresh;
+	float free_thresh;
+
+	MapMetadata(): resolution(0.05), origin({0, 0}), negate(false), occupied_thresh(0.65), free_thresh(0.196) {}
+};
+
+/**
+* @brief read-only view of a whole file, memory mapped where supported
+*/
+class MappedFile
+{
+public:
+	MappedFile(): _data(nullptr), _size(0), _mapped(false) {}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/// @brief map a file, returns false if it can't be read
+	bool open(const std::string& filename)
+	{
+		close();
+#if defined(__unix__) || defined(__APPLE__)
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if(fd < 0) return false;
+		struct stat st;
+		if(fstat(fd, &st)==0 && st.st_size > 0)
+		{
+			void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(addr != MAP_FAILED)
+			{
+				madvise(addr, st.st_size, MADV_SEQUENTIAL);
+				_data = static_cast<const unsigned char*>(addr);
+				_size = st.st_size;
+				_mapped = true;
+			}
+		}
+		::close(fd);
+		if(_mapped) return true;
+#endif
+		// fallback, read the whole file
+		std::ifstream f(filename.c_str(), std::ios::binary | std::ios::ate);
+		if(!f) return false;
+		_buffer.resize(static_cast<size_t>(f.tellg()));
+		f.seekg(0);
+		f.read((char *)_buffer.data(), _buffer.size());
+		_data = _buffer.data();
+		_size = _buffer.size();
+		return true;
+	}
+
+	void close()
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		if(_mapped) munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+		_mapped = false;
+		_data = nullptr;
+		_size = 0;
+		std::vector<unsigned char>().swap(_buffer);
+	}
+
+	const unsigned char* data() const
+	{
+		return _data;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+
+private:
+	const unsigned char* _data;
+
+	size_t _size;
+
+	bool _mapped;
+
+	/// @brief file contents when mapping is not available
+	std::vector<unsigned char> _buffer;
+};
+
+/**
+* @brief read map metadata from a yaml file
+*
+* only the flat `key: value` entries of map_server yaml files are parsed
+*
+* @param yamlfile yaml file path
+* @param meta parsed metadata
+* @return returns false if the file can't be read or has no image entry
+*/
+inline bool read_map_yaml(const std::string& yamlfile, MapMetadata& meta)
+{
+	std::ifstream f(yamlfile.c_str());
+	if(!f) return false;
+	std::string line;
+	while(std::getline(f, line))
+	{
+		size_t colon = line.find(':');
+		if(colon==std::string::npos) continue;
+		std::string key = line.substr(0, colon);
+		key.erase(0, key.find_first_not_of(" \t"));
+		key.erase(key.find_last_not_of(" \t")+1);
+		std::string value = line.substr(colon+1);
+		value.erase(0, value.find_first_not_of(" \t"));
+		value.erase(value.find_last_not_of(" \t\r")+1);
+		if(key=="image") meta.image = value;
+		else if(key=="resolution") meta.resolution = std::strtof(value.c_str(), nullptr);
+		else if(key=="negate") meta.negate = std::atoi(value.c_str())!=0;
+		else if(key=="occupied_thresh") meta.occupied_thresh = std::strtof(value.c_str(), nullptr);
+		else if(key=="free_thresh") meta.free_thresh = std::strtof(value.c_str(), nullptr);
+		else if(key=="origin")
+		{
+			for(char& c: value) if(c=='[' || c==']' || c==',') c = ' ';
+			std::istringstream ss(value);
+			ss>>meta.origin[0]>>meta.origin[1];
+		}
+	}
+	if(meta.image.empty()) return false;
+	// image path relative to the yaml file
+	size_t slash = yamlfile.find_last_of('/');
+	if(meta.image[0]!='/' && slash!=std::string::npos) meta.image = yamlfile.substr(0, slash+1)+meta.image;
+	return true;
+}
+
+/**
+* @brief read the next decimal number of a PGM file, skipping whitespace and comments
+*/
+inline bool read_pgm_int(const unsigned char* data, size_t size, size_t& pos, long& value)
+{
+	while(pos < size)
+	{
+		if(data[pos]=='#') while(pos < size && data[pos]!='\n') ++pos;
+		else if(std::isspace(data[pos])) ++pos;
+		else break;
+	}
+	if(pos >= size || !std::isdigit(data[pos])) return false;
+	value = 0;
+	while(pos < size && std::isdigit(data[pos])) value = 10*value + (data[pos++]-'0');
+	return true;
+}
+
+/**
+* @brief parse the header of a PGM image
+*
+* @param data file contents
+* @param size file size
+* @param pos position after the header, i.e. of the single whitespace before binary pixels or of the first ascii pixel
+* @param binary true for binary P5 images, false for ascii P2
+* @param width image width
+* @param height image height
+* @param maxval maximum gray value
+* @return returns false if the header is not a valid PGM header
+*/
+inline bool read_pgm_header(const unsigned char* data, size_t size, size_t& pos, bool& binary, long& width, long& height,
+	long& maxval)
+{
+	if(size < 2 || data[0]!='P' || (data[1]!='5' && data[1]!='2')) return false;
+	binary = (data[1]=='5');
+	pos = 2;
+	if(!read_pgm_int(data, size, pos, width) || !read_pgm_int(data, size, pos, height) || !read_pgm_int(data, size, pos, maxval))
+	{
+		return false;
+	}
+	return width>0 && height>0 && maxval>0 && maxval<=65535;
+}
+
+/**
+* @brief occupancy cell of a gray value, see `load_pgm`
+*/
+inline int8_t pgm_to_cell(long p, long maxval, float occupied_thresh, float free_thresh, bool negate)
+{
+	float prob = negate?float(p)/maxval:float(maxval-p)/maxval;
+	if(prob > occupied_thresh) return 100;
+	if(prob < free_thresh) return 0;
+	return -1;
+}
+
+/**
+* @brief load a PGM image (binary P5 or ascii P2) as occupancy cells
+*
+* Binary images are memory mapped and converted in a single parallel pass through a per-gray-level lookup table.
+* A pixel p with maximum gray value m has occupancy probability \f$(m-p)/m\f$ (\f$p/m\f$ if negate), cells with probability
+* above `occupied_thresh` are 100, below `free_thresh` are 0 and -1 (unknown) otherwise
+*
+* @param pgmfile image file path
+* @param occupied_thresh occupied probability threshold
+* @param free_thresh free probability threshold
+* @param negate whether white is occupied
+* @param cells occupancy cells in row major order, same layout as the image
+* @param width image width
+* @param height image height
+* @return returns false if the file can't be read or is not a valid PGM image
+*/
+inline bool load_pgm(const std::string& pgmfile, float occupied_thresh, float free_thresh, bool negate,
+	std::vector<int8_t>& cells, int& width, int& height)
+{
+	MappedFile file;
+	if(!file.open(pgmfile)) return false;
+	const unsigned char* data = file.data();
+	size_t size = file.size(), pos = 0;
+	bool binary;
+	long w, h, maxval;
+	if(!read_pgm_header(data, size, pos, binary, w, h, maxval)) return false;
+	width = w;
+	height = h;
+	size_t n = static_cast<size_t>(w)*h;
+	cells.resize(n);
+
+	auto to_cell = [=](long p) -> int8_t
+	{
+		return pgm_to_cell(p, maxval, occupied_thresh, free_thresh, negate);
+	};
+
+	if(binary)
+	{
+		// single whitespace after the header
+		++pos;
+		int bytes_per_pixel = (maxval < 256)?1:2;
+		if(size < pos+n*bytes_per_pixel) return false;
+		const unsigned char* pixels = data+pos;
+		if(bytes_per_pixel==1)
+		{
+			int8_t table[256];
+			for(int p=0; p<256; ++p) table[p] = to_cell(std::min<long>(p, maxval));
+			#pragma omp parallel for schedule(static)
+			for(long i=0; i<h; ++i)
+			{
+				const unsigned char* row = pixels+static_cast<size_t>(i)*w;
+				int8_t* out = &cells[static_cast<size_t>(i)*w];
+				for(long j=0; j<w; ++j) out[j] = table[row[j]];
+			}
+		}
+		else
+		{
+			// 16 bit big endian pixels
+			#pragma omp parallel for schedule(static)
+			for(long i=0; i<h; ++i)
+			{
+				for(long j=0; j<w; ++j)
+				{
+					size_t c = static_cast<size_t>(i)*w+j;
+					cells[c] = to_cell((pixels[2*c]<<8) | pixels[2*c+1]);
+				}
+			}
+		}
+	}
+	else
+	{
+		long p;
+		for(size_t c=0; c<n; ++c)
+		{
+			if(!read_pgm_int(data, size, pos, p)) return false;
+			cells[c] = to_cell(p);
+		}
+	}
+	return true;
+}
+
+/**
+* @brief load a map from a map_server style yaml file and its PGM image
+*
+* @param yamlfile yaml file path
+* @param grid loaded grid, cells are moved into it without copying
+* @return returns false if the yaml file or the image can't be read
+*/
+inline bool load_map(const std::string& yamlfile, OccupancyGrid2d& grid)
+{
+	MapMetadata meta;
+	if(!read_map_yaml(yamlfile, meta)) return false;
+	std::vector<int8_t> cells;
+	int width, height;
+	if(!load_pgm(meta.image, meta.occupied_thresh, meta.free_thresh, meta.negate, cells, width, height)) return false;
+	grid.set(std::move(cells), meta.resolution, width, height, meta.origin);
+	return true;
+}
+
+/**
+* @brief write the cells of a grid as a tiled map file for `MapTileStore`
+*
+* @param grid dense or tiled grid
+* @param filename tiled map file
+* @param tile_size tile side in cells, a power of two
+* @return returns false if the file can't be written
+*/
+inline bool write_tiled_map(OccupancyGrid2d& grid, const std::string& filename, int tile_size=256)
+{
+	int width = grid.get_width(), height = grid.get_height();
+	Point2f origin;
+	grid.ij_to_xy(0, 0, origin[0], origin[1]);
+	MapTileWriter writer(filename, width, height, grid.get_resolution(), origin, tile_size);
+	std::vector<int8_t> band(static_cast<size_t>(tile_size)*width);
+	for(int i0=0; i0<height; i0+=tile_size)
+	{
+		int nrows = std::min(tile_size, height-i0);
+		for(int r=0; r<nrows; ++r) for(int j=0; j<width; ++j) band[static_cast<size_t>(r)*width+j] = grid.value(i0+r, j);
+		writer.write_band(band.data(), nrows);
+	}
+	return writer.good();
+}
+
+/**
+* @brief convert a map_server style map to a tiled map file for `MapTileStore`
+*
+* 8 bit binary images are converted from the memory mapped image one band of tile rows at a time, so the map is never
+* fully in memory, other images are loaded with `load_map` first
+*
+* @param yamlfile yaml file path
+* @param filename tiled map file
+* @param tile_size tile side in cells, a power of two
+* @return returns false if the map can't be read or the tiled file can't be written
+*/
+inline bool convert_map_to_tiled(const std::string& yamlfile, const std::string& filename, int tile_size=256)
+{
+	MapMetadata meta;
+	if(!read_map_yaml(yamlfile, meta)) return false;
+	MappedFile file;
+	if(!file.open(meta.image)) return false;
+	const unsigned char* data = file.data();
+	size_t size = file.size(), pos = 0;
+	bool binary;
+	long w, h, maxval;
+	if(!read_pgm_header(data, size, pos, binary, w, h, maxval)) return false;
+	if(!binary || maxval >= 256)
+	{
+		file.close();
+		OccupancyGrid2d grid;
+		if(!load_map(yamlfile, grid)) return false;
+		return write_tiled_map(grid, filename, tile_size);
+	}
+	++pos;
+	if(size < pos+static_cast<size_t>(w)*h) return false;
+	int8_t table[256];
+	for(int p=0; p<256; ++p) table[p] = pgm_to_cell(std::min<long>(p, maxval), maxval, meta.occupied_thresh, meta.free_thresh, meta.negate);
+
+	MapTileWriter writer(filename, w, h, meta.resolution, meta.origin, tile_size);
+	std::vector<int8_t> band(static_cast<size_t>(tile_size)*w);
+	for(long i0=0; i0<h; i0+=tile_size)
+	{
+		long nrows = std::min<long>(tile_size, h-i0);
+		const unsigned char* pixels = data+pos+static_cast<size_t>(i0)*w;
+		#pragma omp parallel for schedule(static)
+		for(long r=0; r<nrows; ++r)
+		{
+			for(long j=0; j<w; ++j) band[static_cast<size_t>(r)*w+j] = table[pixels[static_cast<size_t>(r)*w+j]];
+		}
+		writer.write_band(band.data(), nrows);
+	}
+	return writer.good();
+}
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef __MAP_TILE_STORE_H__
+#define __MAP_TILE_STORE_H__
+
+#include "data_structures/point_types.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+* @brief Tiled on-disk occupancy map with an LRU cache of loaded tiles
+*
+* @details The file starts with a 32 byte header (8 byte magic "OCCTILE1", int32 width, height and tile size, float resolution
+* and origin x, y) followed by square tiles of 1 byte cells in row-major tile order, every tile stored row-major and padded
+* with unknown (-1) cells at the right and bottom map borders.
+* Tiles are read on first access and kept until the loaded tiles exceed the memory budget, then the least recently used
+* tiles are dropped. Tiles are immutable and handed out as shared pointers, so a store can be shared by several grids
+* (e.g. one per planner instance) and by several threads, and a dropped tile stays valid while a grid still holds it
+*/
+class MapTileStore
+{
+public:
+	/// @brief read-only tile cells
+	typedef std::shared_ptr<const std::vector<int8_t> > TilePtr;
+
+	/// @brief header size in bytes
+	static const int header_bytes = 32;
+
+	/**
+	* @brief Constructor
+	*
+	* @param filename tiled map file
+	* @param memory_budget maximum bytes of cells kept in the cache
+	*/
+	MapTileStore(const std::string& filename, size_t memory_budget=256*1024*1024):
+		_memory_budget(memory_budget), _loaded_bytes(0), _num_loads(0), _num_evictions(0)
+	{
+		_file.open(filename.c_str(), std::ios::binary);
+		if(!_file) throw std::runtime_error("could not open tiled map "+filename);
+		char header[header_bytes];
+		if(!_file.read(header, header_bytes) || std::memcmp(header, "OCCTILE1", 8)!=0)
+		{
+			throw std::runtime_error("not a tiled map file "+filename);
+		}
+		int32_t dims[3];
+		float values[3];
+		std::memcpy(dims, header+8, sizeof(dims));
+		std::memcpy(values, header+20, sizeof(values));
+		_width = dims[0];
+		_height = dims[1];
+		_tile_size = dims[2];
+		_resolution = values[0];
+		_origin = Point2f({values[1], values[2]});
+		if(_width<=0 || _height<=0 || _tile_size<=0 || (_tile_size & (_tile_size-1))!=0)
+		{
+			throw std::runtime_error("invalid tiled map header in "+filename);
+		}
+		_tiles_per_row = (_width+_tile_size-1)/_tile_size;
+	}
+
+	MapTileStore(const MapTileStore&) = delete;
+	MapTileStore& operator=(const MapTileStore&) = delete;
+
+	/**
+	* @brief get tile (ti,tj), loading it from the file if it is not cached
+	*
+	* @param ti tile row
+	* @param tj tile column
+	*/
+	TilePtr get_tile(int ti, int tj)
+	{
+		int64_t id = static_cast<int64_t>(ti)*_tiles_per_row+tj;
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _cache.find(id);
+		if(it != _cache.end())
+		{
+			_lru.splice(_lru.begin(), _lru, it->second.second);
+			return it->second.first;
+		}
+		size_t tile_bytes = static_cast<size_t>(_tile_size)*_tile_size;
+		std::shared_ptr< std::vector<int8_t> > tile(new std::vector<int8_t>(tile_bytes));
+		_file.clear();
+		_file.seekg(header_bytes + id*tile_bytes);
+		if(!_file.read((char *)tile->data(), tile_bytes)) throw std::runtime_error("could not read map tile");
+		++_num_loads;
+		_lru.push_front(id);
+		_cache[id] = std::make_pair(TilePtr(tile), _lru.begin());
+		_loaded_bytes += tile_bytes;
+		// keep at least the tile just loaded
+		while(_loaded_bytes > _memory_budget && _lru.size() > 1)
+		{
+			_cache.erase(_lru.back());
+			_lru.pop_back();
+			_loaded_bytes -= tile_bytes;
+			++_num_evictions;
+		}
+		return TilePtr(tile);
+	}
+
+	/// @brief set maximum bytes of cells kept in the cache, takes effect on the next load
+	void set_memory_budget(size_t memory_budget)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_memory_budget = memory_budget;
+	}
+
+	/// @brief bytes of cells currently in the cache
+	size_t loaded_bytes()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _loaded_bytes;
+	}
+
+	/// @brief number of tiles read from the file so far
+	size_t num_loads()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _num_loads;
+	}
+
+	/// @brief number of tiles dropped from the cache so far
+	size_t num_evictions()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _num_evictions;
+	}
+
+	int get_width()
+	{
+		return _width;
+	}
+
+	int get_height()
+	{
+		return _height;
+	}
+
+	int get_tile_size()
+	{
+		return _tile_size;
+	}
+
+	float get_resolution()
+	{
+		return _resolution;
+	}
+
+	Point2f get_origin()
+	{
+		return _origin;
+	}
+
+private:
+	std::ifstream _file;
+
+	int _width, _height, _tile_size, _tiles_per_row;
+
+	float _resolution;
+
+	Point2f _origin;
+
+	size_t _memory_budget, _loaded_bytes, _num_loads, _num_evictions;
+
+	/// @brief most recently used tile first
+	std::list<int64_t> _lru;
+
+	std::unordered_map< int64_t, std::pair< TilePtr, std::list<int64_t>::iterator > > _cache;
+
+	/// @brief guards the file and the cache
+	std::mutex _mutex;
+};
+
+/**
+* @brief Writer of tiled map files, fed with bands of `tile_size` rows so that whole maps never need to be in memory
+*/
+class MapTileWriter
+{
+public:
+	/**
+	* @brief Constructor, writes the header
+	*
+	* @param filename tiled map file
+	* @param width map width in cells
+	* @param height map height in cells
+	* @param resolution map resolution
+	* @param origin map origin in world coordinates
+	* @param tile_size tile side in cells, a power of two
+	*/
+	MapTileWriter(const std::string& filename, int width, int height, float resolution, Point2f origin, int tile_size=256):
+		_width(width), _height(height), _tile_size(tile_size), _next_row(0)
+	{
+		if(tile_size<=0 || (tile_size & (tile_size-1))!=0) throw std::domain_error("tile size must be a power of two");
+		_file.open(filename.c_str(), std::ios::binary);
+		if(!_file) throw std::runtime_error("could not create tiled map "+filename);
+		char header[MapTileStore::header_bytes];
+		int32_t dims[3] = {width, height, tile_size};
+		float values[3] = {resolution, origin[0], origin[1]};
+		std::memcpy(header, "OCCTILE1", 8);
+		std::memcpy(header+8, dims, sizeof(dims));
+		std::memcpy(header+20, values, sizeof(values));
+		_file.write(header, MapTileStore::header_bytes);
+	}
+
+	/**
+	* @brief write the next band of tiles
+	*
+	* @param rows cells of the next `tile_size` map rows (fewer for the last band) in row-major order, `width` cells per row
+	* @param nrows number of rows in the band
+	*/
+	void write_band(const int8_t* rows, int nrows)
+	{
+		if(nrows != std::min(_tile_size, _height-_next_row)) throw std::domain_error("band must cover the next tile row");
+		std::vector<int8_t> tile(static_cast<size_t>(_tile_size)*_tile_size);
+		for(int j0=0; j0<_width; j0+=_tile_size)
+		{
+			std::fill(tile.begin(), tile.end(), -1);
+			int ncols = std::min(_tile_size, _width-j0);
+			for(int r=0; r<nrows; ++r) std::memcpy(&tile[static_cast<size_t>(r)*_tile_size], rows+static_cast<size_t>(r)*_width+j0, ncols);
+			_file.write((char *)tile.data(), tile.size());
+		}
+		_next_row += nrows;
+	}
+
+	/// @brief check if all bands were written without errors
+	bool good()
+	{
+		_file.flush();
+		return _next_row==_height && static_cast<bool>(_file);
+	}
+
+private:
+	std::ofstream _file;
+
+	int _width, _height, _tile_size;
+
+	/// @brief first map row of the next band
+	int _next_row;
+};
+
+#endif
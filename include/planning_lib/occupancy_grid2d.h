@@ -2,18 +2,57 @@
 #define __OCCUPANCY_GRID2D_H__
 
 #include "data_structures/point_types.h"
+#include "common/parallel_utils.h"
+#include "planning_lib/map_tile_store.h"
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
 
 /**
 * @brief Occupacy grid for 2d maps
 *
 * @details Defines interface for 2-dimensional occupancy gird maps. Value at each cell in the grid,
 * describes the probability of the cell being occupied.
+* Cells are stored as 1 byte values (-1 unknown, 0 free, up to 100 occupied), a quarter of the memory of int cells.
+* An optional bitmap with one bit per cell, set if the cell is not free, makes collision checks touch 1/8 of the memory.
+*
+* With an inflation layer set, an exact Euclidean distance transform to the nearest non-free cell is computed once per map
+* (Felzenszwalb and Huttenlocher's lower envelope of parabolas, parallel over columns and rows), and turned into a 1 byte
+* cost per cell, so footprint collision checks and clearance costs are O(1) per cell.
+*
+* Cells can also be changed one at a time with `set_cell` or by integrating laser scans into per-cell log-odds. Changed cells
+* are collected in a dirty region, and the distance transform is repaired incrementally with a dynamic brushfire
+* (Lau, Sprunk and Burgard, 2013) which only visits cells whose nearest obstacle changes, so update time scales with the
+* changed area instead of the map size.
+*
+* For maps too large for memory, cells can instead come from a shared `MapTileStore` (`open_tiled`), which loads tiles on first
+* touch. The grid keeps the last tile it touched, so consecutive accesses within a tile (as in planner neighbor expansion)
+* cost a compare and a shift. Tiles written through `operator()` or `set_cell` are copied into the grid first (copy-on-write),
+* so grids sharing a store never see each other's changes. Bitmap, inflation layer and scan integration need a dense grid.
+*
+* An optional max-pooled pyramid marks every 2^k x 2^k block that contains a cell the robot can't be at. It tells the
+* largest free block around a cell in O(levels), so ray casts jump over whole free blocks, and it is updated in place
+* along with `set_cell` and incremental inflation updates
 */
 class OccupancyGrid2d
 {
 public:
 	/// @brief default constructor
-	OccupancyGrid2d() {}
+	OccupancyGrid2d(): _resolution(0), _width(0), _height(0), _use_bitmap(false), _use_inflation(false), _robot_radius(0),
+		_inflation_radius(0), _cost_scaling(0), _use_pyramid(false), _pyramid_levels(0), _tile_shift(0), _tiles_per_row(0)
+	{
+		set_sensor_model();
+		clear_dirty_region();
+	}
+
+	/// @brief cost of non-free cells in the inflation layer
+	static const uint8_t obstacle_cost = 255;
+
+	/// @brief cost of free cells closer than the robot radius to a non-free cell
+	static const uint8_t inscribed_cost = 254;
 
 	/**
 	* @brief set occupancy grid data
@@ -26,11 +65,563 @@ public:
 	*/
 	void set(std::vector<int>& data, float resolution, int width, int height, Point2f origin)
 	{
-		_data = data;
+		std::vector<int8_t> cells(data.begin(), data.end());
+		set(std::move(cells), resolution, width, height, origin);
+	}
+
+	/**
+	* @overload
+	*
+	* adopts the buffer of data without copying
+	*/
+	void set(std::vector<int8_t>&& data, float resolution, int width, int height, Point2f origin)
+	{
+		if(data.size() != static_cast<size_t>(width)*height) throw std::domain_error("map data size doesn't match width*height");
+		close_tiled();
+		_data = std::move(data);
 		_resolution = resolution;
 		_width = width;
 		_height = height;
 		_origin = origin;
+		std::vector<float>().swap(_log_odds);
+		if(_use_bitmap) update_bitmap();
+		if(_use_inflation) update_inflation();
+		else if(_use_pyramid) build_pyramid();
+		_dirty_min[0] = _dirty_min[1] = 0;
+		_dirty_max[0] = _height-1;
+		_dirty_max[1] = _width-1;
+	}
+
+	/**
+	* @brief use tiles of a tiled map file as cells, replacing the current cells
+	*
+	* @param store tile store, may be shared with other grids
+	*/
+	void open_tiled(std::shared_ptr<MapTileStore> store)
+	{
+		_data.clear();
+		_data.shrink_to_fit();
+		_width = _height = 0;
+		close_tiled();
+		_use_bitmap = false;
+		std::vector<uint64_t>().swap(_bitmap);
+		clear_inflation();
+		std::vector<float>().swap(_log_odds);
+		_tile_store = store;
+		_resolution = store->get_resolution();
+		_width = store->get_width();
+		_height = store->get_height();
+		_origin = store->get_origin();
+		int tile_size = store->get_tile_size();
+		_tile_shift = 0;
+		while((1<<_tile_shift) < tile_size) ++_tile_shift;
+		_tiles_per_row = (_width+tile_size-1)/tile_size;
+		if(_use_pyramid) build_pyramid();
+		_dirty_min[0] = _dirty_min[1] = 0;
+		_dirty_max[0] = _height-1;
+		_dirty_max[1] = _width-1;
+	}
+
+	/// @brief check if cells come from a tile store
+	bool is_tiled()
+	{
+		return static_cast<bool>(_tile_store);
+	}
+
+	/// @brief tile store of a tiled grid, null for dense grids
+	std::shared_ptr<MapTileStore> get_tile_store()
+	{
+		return _tile_store;
+	}
+
+	/**
+	* @brief value of cell (i,j), unlike `operator()` this never copies a shared tile
+	*/
+	int8_t value(int i, int j)
+	{
+		if(_tile_store) return tile_value(i, j);
+		return _data[static_cast<int64_t>(i)*_width+j];
+	}
+
+	/**
+	* @brief set inflation layer parameters and compute distance transform and costs
+	*
+	* free cells closer than `robot_radius` to a non-free cell get `inscribed_cost` and are not traversable, free cells within
+	* `inflation_radius` get cost $253 e^{-s(d-r)}$ where d is the distance to the nearest non-free cell, r the robot radius
+	* and s the cost scaling factor, other free cells get cost 0
+	*
+	* @param robot_radius radius of the robot footprint in meters
+	* @param inflation_radius distance in meters up to which cells get a clearance cost
+	* @param cost_scaling decay rate of the clearance cost per meter
+	*/
+	void set_inflation(float robot_radius, float inflation_radius, float cost_scaling=10.0)
+	{
+		if(_tile_store) throw std::domain_error("inflation layer needs a dense grid");
+		_use_inflation = true;
+		_robot_radius = robot_radius;
+		_inflation_radius = std::max(robot_radius, inflation_radius);
+		_cost_scaling = cost_scaling;
+		update_inflation();
+	}
+
+	/// @brief remove the inflation layer
+	void clear_inflation()
+	{
+		_use_inflation = false;
+		std::vector<int32_t>().swap(_nearest);
+		std::vector<uint8_t>().swap(_cost);
+		std::vector<uint8_t>().swap(_raise);
+		_open = OpenQueue();
+		if(_use_pyramid) build_pyramid();
+	}
+
+	/// @brief check if the inflation layer is set
+	bool has_inflation()
+	{
+		return _use_inflation;
+	}
+
+	/**
+	* @brief recompute distance transform and inflation costs from the cells
+	*
+	* @note needed after cells are modified through `operator()` while the inflation layer is used
+	*/
+	void update_inflation()
+	{
+		compute_distance_transform();
+		int64_t n = static_cast<int64_t>(_width)*_height;
+		_raise.assign(n, 0);
+		_open = OpenQueue();
+		_cost.resize(n);
+		#pragma omp parallel for schedule(static)
+		for(int64_t c=0; c<n; ++c) _cost[c] = compute_cost(c);
+		if(_use_pyramid) build_pyramid();
+	}
+
+	/**
+	* @brief change the value of cell (i,j)
+	*
+	* the bitmap is updated right away, and so is the pyramid without an inflation layer. If the cell changes between free
+	* and not free with an inflation layer set, the change is queued for the next `update_inflation_incremental` call
+	*/
+	void set_cell(int i, int j, int8_t value)
+	{
+		int64_t c = static_cast<int64_t>(i)*_width+j;
+		int8_t& cell = _tile_store?tile_cell(i, j):_data[c];
+		bool was_free = (cell==0), free = (value==0);
+		cell = value;
+		expand_dirty_region(i, j);
+		if(was_free == free) return;
+		if(_use_bitmap)
+		{
+			if(free) _bitmap[c>>6] &= ~(uint64_t(1)<<(c&63));
+			else _bitmap[c>>6] |= uint64_t(1)<<(c&63);
+		}
+		if(!_use_inflation)
+		{
+			if(_use_pyramid) update_pyramid(i, j, i, j);
+			return;
+		}
+		if(free)
+		{
+			// obstacle removed, cells that had it as nearest obstacle are raised
+			_nearest[c] = -1;
+			_raise[c] = 1;
+		}
+		else _nearest[c] = static_cast<int32_t>(c);
+		_open.push(std::make_pair(int64_t(0), c));
+	}
+
+	/**
+	* @brief repair the distance transform and inflation costs after `set_cell` calls
+	*
+	* dynamic brushfire: removed obstacles raise the cells they were nearest to, clearing them, and new or remaining obstacles
+	* next to raised cells lower their neighbors again, in order of squared distance. Nearest obstacles are propagated through
+	* 8-neighbors, so in rare configurations a distance can be slightly larger than the exact one (below 0.1 cell in practice).
+	* Costs are recomputed in the bounding box of visited cells, which is added to the dirty region
+	*/
+	void update_inflation_incremental()
+	{
+		if(!_use_inflation) return;
+		int64_t i_min = _height, j_min = _width, i_max = -1, j_max = -1;
+		while(!_open.empty())
+		{
+			int64_t key = _open.top().first, c = _open.top().second;
+			_open.pop();
+			int64_t ci = c/_width, cj = c%_width;
+			if(_raise[c])
+			{
+				for(int di=-1; di<=1; ++di)
+				{
+					for(int dj=-1; dj<=1; ++dj)
+					{
+						int64_t ni = ci+di, nj = cj+dj;
+						if((di==0 && dj==0) || ni<0 || nj<0 || ni>=_height || nj>=_width) continue;
+						int64_t n = ni*_width+nj;
+						if(_nearest[n] < 0 || _raise[n]) continue;
+						int64_t n_key = squared_cell_distance(n);
+						if(!is_site(_nearest[n]))
+						{
+							_nearest[n] = -1;
+							_raise[n] = 1;
+						}
+						_open.push(std::make_pair(n_key, n));
+					}
+				}
+				_raise[c] = 0;
+			}
+			else if(key==squared_cell_distance(c) && _nearest[c]>=0 && is_site(_nearest[c]))
+			{
+				int32_t site = _nearest[c];
+				int64_t si = site/_width, sj = site%_width;
+				for(int di=-1; di<=1; ++di)
+				{
+					for(int dj=-1; dj<=1; ++dj)
+					{
+						int64_t ni = ci+di, nj = cj+dj;
+						if((di==0 && dj==0) || ni<0 || nj<0 || ni>=_height || nj>=_width) continue;
+						int64_t n = ni*_width+nj;
+						if(_raise[n]) continue;
+						int64_t d2 = (ni-si)*(ni-si) + (nj-sj)*(nj-sj), n_d2 = squared_cell_distance(n);
+						if(d2 < n_d2 || (d2==n_d2 && !is_site(_nearest[n])))
+						{
+							_nearest[n] = site;
+							_open.push(std::make_pair(d2, n));
+						}
+					}
+				}
+			}
+			else continue;
+			// neighbors of a visited cell may have changed too
+			i_min = std::min(i_min, ci-1);
+			j_min = std::min(j_min, cj-1);
+			i_max = std::max(i_max, ci+1);
+			j_max = std::max(j_max, cj+1);
+		}
+		if(i_max < 0) return;
+		i_min = std::max<int64_t>(0, i_min);
+		j_min = std::max<int64_t>(0, j_min);
+		i_max = std::min<int64_t>(_height-1, i_max);
+		j_max = std::min<int64_t>(_width-1, j_max);
+		#pragma omp parallel for schedule(static)
+		for(int64_t i=i_min; i<=i_max; ++i)
+		{
+			for(int64_t j=j_min; j<=j_max; ++j) _cost[i*_width+j] = compute_cost(i*_width+j);
+		}
+		expand_dirty_region(i_min, j_min);
+		expand_dirty_region(i_max, j_max);
+		if(_use_pyramid) update_pyramid(i_min, j_min, i_max, j_max);
+	}
+
+	/**
+	* @brief keep a max-pooled pyramid of cells the robot can't be at (see `is_traversable`)
+	*
+	* @param use_pyramid true to build and use the pyramid
+	* @param num_levels number of levels above the cells, 0 for levels up to a single block covering the map
+	*/
+	void set_use_pyramid(bool use_pyramid, int num_levels=0)
+	{
+		_use_pyramid = use_pyramid;
+		_pyramid_levels = num_levels;
+		if(_use_pyramid) build_pyramid();
+		else std::vector< std::vector<uint8_t> >().swap(_pyramid);
+	}
+
+	/// @brief rebuild the pyramid, needed after cells are modified through `operator()` while the pyramid is used
+	void build_pyramid()
+	{
+		int levels = _pyramid_levels;
+		if(levels<=0) while((std::max(_width, _height)-1)>>levels > 0) ++levels;
+		_pyramid.assign(levels, std::vector<uint8_t>());
+		for(int k=1; k<=levels; ++k) _pyramid[k-1].resize(static_cast<size_t>(pyramid_height(k))*pyramid_width(k));
+		update_pyramid(0, 0, _height-1, _width-1);
+	}
+
+	/**
+	* @brief recompute pyramid blocks covering the cells in rows [i_min, i_max] and columns [j_min, j_max]
+	*
+	* parallel over block rows of every level, except for tiled grids which load tiles on access
+	*/
+	void update_pyramid(int i_min, int j_min, int i_max, int j_max)
+	{
+		if(i_max < i_min || j_max < j_min) return;
+		for(int k=1; k<=_pyramid.size(); ++k)
+		{
+			i_min >>= 1;
+			j_min >>= 1;
+			i_max >>= 1;
+			j_max >>= 1;
+			int child_height = (k==1)?_height:pyramid_height(k-1), child_width = (k==1)?_width:pyramid_width(k-1);
+			int width = pyramid_width(k);
+			std::vector<uint8_t>& level = _pyramid[k-1];
+			#pragma omp parallel for schedule(static) if(!_tile_store)
+			for(int bi=i_min; bi<=i_max; ++bi)
+			{
+				for(int bj=j_min; bj<=j_max; ++bj)
+				{
+					uint8_t blocked = 0;
+					for(int ci=2*bi; ci<std::min(2*bi+2, child_height); ++ci)
+					{
+						for(int cj=2*bj; cj<std::min(2*bj+2, child_width); ++cj)
+						{
+							if(k==1) blocked |= !is_traversable(ci, cj);
+							else blocked |= _pyramid[k-2][static_cast<size_t>(ci)*child_width+cj];
+						}
+					}
+					level[static_cast<size_t>(bi)*width+bj] = blocked;
+				}
+			}
+		}
+	}
+
+	/// @brief number of pyramid levels above the cells, 0 without pyramid
+	int num_pyramid_levels()
+	{
+		return _pyramid.size();
+	}
+
+	/**
+	* @brief check if block (bi,bj) of pyramid level k, covering cells [bi*2^k, (bi+1)*2^k) x [bj*2^k, (bj+1)*2^k), only has
+	* cells the robot can be at, level 0 is the cells
+	*/
+	bool is_block_free(int k, int bi, int bj)
+	{
+		if(k==0) return is_traversable(bi, bj);
+		return !_pyramid[k-1][static_cast<size_t>(bi)*pyramid_width(k)+bj];
+	}
+
+	/**
+	* @brief level of the largest free pyramid block containing cell (i,j), -1 if the robot can't be at the cell
+	*/
+	int free_block_level(int i, int j)
+	{
+		if(!is_traversable(i, j)) return -1;
+		int k = 0;
+		while(k < _pyramid.size() && !_pyramid[k][static_cast<size_t>(i>>(k+1))*pyramid_width(k+1)+(j>>(k+1))]) ++k;
+		return k;
+	}
+
+	/**
+	* @brief cast a ray through the grid, checking every cell the segment passes through
+	*
+	* the ray jumps from the entry of the largest free pyramid block around the current cell to its exit, so long rays through
+	* free space visit a few blocks instead of every cell. Without pyramid every cell is visited
+	*
+	* @param x0 x of the ray start in world coordinates
+	* @param y0 y of the ray start
+	* @param x1 x of the ray end
+	* @param y1 y of the ray end
+	* @return returns fraction of the segment before the first cell the robot can't be at or outside the map, 1 if there is none
+	*/
+	float ray_cast(float x0, float y0, float x1, float y1)
+	{
+		// continuous cell coordinates, cell (i,j) covers [i, i+1) x [j, j+1)
+		double u0 = (x0-_origin[0])/_resolution, v0 = (y0-_origin[1])/_resolution;
+		double du = (x1-_origin[0])/_resolution-u0, dv = (y1-_origin[1])/_resolution-v0;
+		double eps = 1e-6/std::max(1.0, std::max(std::abs(du), std::abs(dv)));
+		double t = 0;
+		while(true)
+		{
+			int i = std::floor(u0+t*du), j = std::floor(v0+t*dv);
+			if(i<0 || j<0 || i>=_height || j>=_width) return t;
+			int k = free_block_level(i, j);
+			if(k < 0) return t;
+			// blocks at the map border are cut at the border
+			int bi = (i>>k)<<k, bj = (j>>k)<<k, bi_end = std::min(bi+(1<<k), _height), bj_end = std::min(bj+(1<<k), _width);
+			double t_exit = std::numeric_limits<double>::infinity();
+			if(du > 0) t_exit = std::min(t_exit, (bi_end-u0)/du);
+			else if(du < 0) t_exit = std::min(t_exit, (bi-u0)/du);
+			if(dv > 0) t_exit = std::min(t_exit, (bj_end-v0)/dv);
+			else if(dv < 0) t_exit = std::min(t_exit, (bj-v0)/dv);
+			if(t_exit >= 1) return 1;
+			t = std::max(t, t_exit)+eps;
+		}
+	}
+
+	/**
+	* @brief set the inverse sensor model used by `integrate_scan`
+	*
+	* probabilities are stored as log-odds \f$\log(p/(1-p))\f$, a cell becomes occupied (100) above `occupied_thresh`,
+	* free (0) below `free_thresh` and unknown (-1) in between, like in map_server images
+	*
+	* @param prob_hit occupancy probability of a cell a beam ends in
+	* @param prob_miss occupancy probability of a cell a beam passes through
+	* @param prob_min lower clamping probability, so cells can change quickly again
+	* @param prob_max upper clamping probability
+	* @param occupied_thresh occupied probability threshold
+	* @param free_thresh free probability threshold
+	*/
+	void set_sensor_model(float prob_hit=0.7, float prob_miss=0.4, float prob_min=0.12, float prob_max=0.97,
+		float occupied_thresh=0.65, float free_thresh=0.196)
+	{
+		auto logit = [](float p) { return std::log(p/(1-p)); };
+		_l_hit = logit(prob_hit);
+		_l_miss = logit(prob_miss);
+		_l_min = logit(prob_min);
+		_l_max = logit(prob_max);
+		_l_occupied = logit(occupied_thresh);
+		_l_free = logit(free_thresh);
+	}
+
+	/**
+	* @brief integrate a 2d laser scan into the cells
+	*
+	* every beam is traced from the sensor with Bresenham's algorithm, cells it passes through get the miss update and the cell it
+	* ends in the hit update, unless the range is at least `max_range`. Log-odds are kept per cell from the first scan on,
+	* initialized from the cell values. Changed cells go through `set_cell`, and the inflation layer is updated incrementally
+	*
+	* @param origin sensor position in world coordinates
+	* @param yaw sensor heading in radians, angles are measured from the x axis towards the y axis
+	* @param ranges beam ranges in meters, beams with non-finite or non-positive ranges are skipped
+	* @param angle_min angle of the first beam relative to the heading
+	* @param angle_increment angle between consecutive beams
+	* @param max_range maximum sensor range, longer beams are cut and only clear cells
+	*/
+	void integrate_scan(const Point2f& origin, float yaw, const std::vector<float>& ranges, float angle_min,
+		float angle_increment, float max_range)
+	{
+		if(_tile_store) throw std::domain_error("scan integration needs a dense grid");
+		int64_t n = static_cast<int64_t>(_width)*_height;
+		if(_log_odds.size() != n)
+		{
+			_log_odds.resize(n);
+			#pragma omp parallel for schedule(static)
+			for(int64_t c=0; c<n; ++c) _log_odds[c] = (_data[c]>0)?_l_max:(_data[c]==0)?_l_min:0.0f;
+		}
+		int i0, j0;
+		if(!xy_to_ij(origin[0], origin[1], i0, j0)) return;
+		for(size_t b=0; b<ranges.size(); ++b)
+		{
+			float range = ranges[b];
+			if(!std::isfinite(range) || range <= 0) continue;
+			bool hit = range < max_range;
+			range = std::min(range, max_range);
+			float angle = yaw + angle_min + b*angle_increment;
+			int i1, j1;
+			xy_to_ij(origin[0]+range*std::cos(angle), origin[1]+range*std::sin(angle), i1, j1);
+			// Bresenham over all octants, stops at the map border
+			int di = std::abs(i1-i0), dj = -std::abs(j1-j0), si = (i0<i1)?1:-1, sj = (j0<j1)?1:-1, err = di+dj;
+			int i = i0, j = j0;
+			while(true)
+			{
+				if(i<0 || j<0 || i>=_height || j>=_width) break;
+				bool end = (i==i1 && j==j1);
+				update_log_odds(i, j, (end && hit)?_l_hit:_l_miss);
+				if(end) break;
+				int e2 = 2*err;
+				if(e2 >= dj)
+				{
+					err += dj;
+					i += si;
+				}
+				if(e2 <= di)
+				{
+					err += di;
+					j += sj;
+				}
+			}
+		}
+		update_inflation_incremental();
+	}
+
+	/**
+	* @brief bounding box of cells changed since the last `clear_dirty_region`, including cells whose inflation cost changed
+	*
+	* @return returns false if nothing changed
+	*/
+	bool get_dirty_region(int& i_min, int& j_min, int& i_max, int& j_max)
+	{
+		if(_dirty_max[0] < _dirty_min[0]) return false;
+		i_min = _dirty_min[0];
+		j_min = _dirty_min[1];
+		i_max = _dirty_max[0];
+		j_max = _dirty_max[1];
+		return true;
+	}
+
+	/// @brief reset the dirty region, e.g. after consumers of the map caught up with the changes
+	void clear_dirty_region()
+	{
+		_dirty_min[0] = _dirty_min[1] = std::numeric_limits<int>::max();
+		_dirty_max[0] = _dirty_max[1] = -1;
+	}
+
+	/**
+	* @brief index (i*width+j) of the non-free cell nearest to cell (i,j), -1 if all cells are free
+	*/
+	int nearest_obstacle(int i, int j)
+	{
+		return _nearest[static_cast<int64_t>(i)*_width+j];
+	}
+
+	/**
+	* @brief distance in meters from cell (i,j) to the nearest non-free cell, infinity if all cells are free
+	*/
+	float distance(int i, int j)
+	{
+		return cell_distance(static_cast<int64_t>(i)*_width+j)*_resolution;
+	}
+
+	/**
+	* @brief inflation cost of cell (i,j)
+	*/
+	uint8_t cost(int i, int j)
+	{
+		return _cost[static_cast<int64_t>(i)*_width+j];
+	}
+
+	/**
+	* @brief check if the robot can be at cell (i,j), i.e. the cell is free and, with an inflation layer,
+	* the footprint doesn't overlap a non-free cell
+	*/
+	bool is_traversable(int i, int j)
+	{
+		if(_use_inflation) return _cost[static_cast<int64_t>(i)*_width+j] < inscribed_cost;
+		return is_free(i, j);
+	}
+
+	/**
+	* @brief keep a bitmap of cells that are not free for collision checks with `is_free`
+	*
+	* @param use_bitmap true to build and use the bitmap
+	*/
+	void set_use_bitmap(bool use_bitmap)
+	{
+		if(use_bitmap && _tile_store) throw std::domain_error("bitmap needs a dense grid");
+		_use_bitmap = use_bitmap;
+		if(_use_bitmap) update_bitmap();
+		else std::vector<uint64_t>().swap(_bitmap);
+	}
+
+	/**
+	* @brief rebuild the bitmap from the cells
+	*
+	* @note needed after cells are modified through `operator()` while the bitmap is used
+	*/
+	void update_bitmap()
+	{
+		int64_t n = static_cast<int64_t>(_width)*_height;
+		_bitmap.assign((n+63)/64, 0);
+		int64_t nwords = _bitmap.size();
+		#pragma omp parallel for schedule(static)
+		for(int64_t w=0; w<nwords; ++w)
+		{
+			uint64_t word = 0;
+			int64_t end = std::min(n, 64*(w+1));
+			for(int64_t c=64*w; c<end; ++c) word |= static_cast<uint64_t>(_data[c]!=0)<<(c-64*w);
+			_bitmap[w] = word;
+		}
+	}
+
+	/**
+	* @brief check if cell (i,j) is free, using the bitmap if enabled
+	*/
+	bool is_free(int i, int j)
+	{
+		if(_tile_store) return tile_value(i, j)==0;
+		int64_t c = static_cast<int64_t>(i)*_width+j;
+		if(_use_bitmap) return !((_bitmap[c>>6]>>(c&63)) & 1);
+		return _data[c]==0;
 	}
 
 	/**
@@ -87,23 +678,34 @@ public:
 	* @param i row index of the map
 	* @param j column index of the map
 	* @return reference to the value at cell (i,j) in the map
+	*
+	* @note on a tiled grid the tile is copied into the grid, use `value` for read-only access
 	*/
-	int& operator()(int i, int j)
+	int8_t& operator()(int i, int j)
 	{
-		return _data[i*_width+j];
+		if(_tile_store) return tile_cell(i, j);
+		return _data[static_cast<int64_t>(i)*_width+j];
 	}
 
 	/**
 	* @overload
 	*/
-	int& operator()(int i)
+	int8_t& operator()(int i)
 	{
+		if(_tile_store) return tile_cell(i/_width, i%_width);
 		return _data[i];
 	}
 
+	/// @brief memory used by the cells, the bitmap and the inflation layer in bytes
+	size_t memory_bytes()
+	{
+		return _data.size()*sizeof(int8_t) + _bitmap.size()*sizeof(uint64_t) + _nearest.size()*sizeof(int32_t) + _cost.size()
+			+ _raise.size() + _log_odds.size()*sizeof(float) + pyramid_bytes() + _own_tiles.size()*(static_cast<size_t>(1)<<(2*_tile_shift));
+	}
+
 private:
 	/// @brief 2d occupancy probability data stored in row-major order linearly
-	std::vector<int> _data;
+	std::vector<int8_t> _data;
 
 	/// @brief map resolution
 	float _resolution;
@@ -116,6 +718,286 @@ private:
 
 	/// @brief map origin in world coordinates
 	Point2f _origin;
+
+	/// @brief whether the bitmap is kept
+	bool _use_bitmap;
+
+	/// @brief one bit per cell in row-major order, set if the cell is not free
+	std::vector<uint64_t> _bitmap;
+
+	/// @brief whether the inflation layer is kept
+	bool _use_inflation;
+
+	/// @brief inflation parameters
+	float _robot_radius, _inflation_radius, _cost_scaling;
+
+	/// @brief index of the nearest non-free cell of every cell, distances are computed from it
+	std::vector<int32_t> _nearest;
+
+	/// @brief inflation cost of every cell
+	std::vector<uint8_t> _cost;
+
+	/// @brief brushfire flag of cells whose nearest obstacle was removed and whose neighbors still need to be raised
+	std::vector<uint8_t> _raise;
+
+	/// @brief brushfire queue of (squared distance in cells, cell index), smallest distance first
+	typedef std::priority_queue< std::pair<int64_t, int64_t>, std::vector< std::pair<int64_t, int64_t> >,
+		std::greater< std::pair<int64_t, int64_t> > > OpenQueue;
+	OpenQueue _open;
+
+	/// @brief bounding box of changed cells, empty if min > max
+	int _dirty_min[2], _dirty_max[2];
+
+	/// @brief occupancy log-odds of every cell, allocated by the first scan
+	std::vector<float> _log_odds;
+
+	/// @brief sensor model log-odds
+	float _l_hit, _l_miss, _l_min, _l_max, _l_occupied, _l_free;
+
+	size_t pyramid_bytes()
+	{
+		size_t bytes = 0;
+		for(auto& level: _pyramid) bytes += level.size();
+		return bytes;
+	}
+
+	/// @brief whether the pyramid is kept
+	bool _use_pyramid;
+
+	/// @brief requested number of pyramid levels, 0 for all
+	int _pyramid_levels;
+
+	/// @brief level k at index k-1, one byte per block in row-major order, 1 if the block has a cell the robot can't be at
+	std::vector< std::vector<uint8_t> > _pyramid;
+
+	int pyramid_width(int k)
+	{
+		return ((_width-1)>>k)+1;
+	}
+
+	int pyramid_height(int k)
+	{
+		return ((_height-1)>>k)+1;
+	}
+
+	/// @brief store of a tiled grid, null for dense grids
+	std::shared_ptr<MapTileStore> _tile_store;
+
+	/// @brief log2 of the tile size and number of tiles per tile row
+	int _tile_shift, _tiles_per_row;
+
+	/**
+	* @brief last touched tile, copies of a grid start with an empty cache since cells may point into written tiles
+	*/
+	struct TileCache
+	{
+		/// @brief tile index, -1 if none
+		int64_t id;
+		/// @brief keeps the tile alive while it is evicted from the store
+		MapTileStore::TilePtr tile;
+		const int8_t* cells;
+
+		TileCache(): id(-1), cells(nullptr) {}
+		TileCache(const TileCache&): id(-1), cells(nullptr) {}
+		TileCache& operator=(const TileCache&)
+		{
+			reset();
+			return *this;
+		}
+		void reset()
+		{
+			id = -1;
+			tile.reset();
+			cells = nullptr;
+		}
+	};
+
+	TileCache _tile_cache;
+
+	/// @brief tiles written by this grid
+	std::unordered_map< int64_t, std::vector<int8_t> > _own_tiles;
+
+	/// @brief drop the tile store and written tiles
+	void close_tiled()
+	{
+		_tile_store.reset();
+		_own_tiles.clear();
+		_tile_cache.reset();
+	}
+
+	/// @brief make tile id the last touched tile
+	void touch_tile(int64_t id)
+	{
+		auto it = _own_tiles.find(id);
+		if(it != _own_tiles.end())
+		{
+			_tile_cache.tile.reset();
+			_tile_cache.cells = it->second.data();
+		}
+		else
+		{
+			_tile_cache.tile = _tile_store->get_tile(id/_tiles_per_row, id%_tiles_per_row);
+			_tile_cache.cells = _tile_cache.tile->data();
+		}
+		_tile_cache.id = id;
+	}
+
+	/// @brief value of cell (i,j) of a tiled grid
+	int8_t tile_value(int i, int j)
+	{
+		int64_t id = static_cast<int64_t>(i>>_tile_shift)*_tiles_per_row + (j>>_tile_shift);
+		if(id != _tile_cache.id) touch_tile(id);
+		int mask = (1<<_tile_shift)-1;
+		return _tile_cache.cells[((i & mask)<<_tile_shift) + (j & mask)];
+	}
+
+	/// @brief writable cell (i,j) of a tiled grid, copies the tile into the grid on first write
+	int8_t& tile_cell(int i, int j)
+	{
+		int64_t id = static_cast<int64_t>(i>>_tile_shift)*_tiles_per_row + (j>>_tile_shift);
+		auto it = _own_tiles.find(id);
+		if(it == _own_tiles.end())
+		{
+			MapTileStore::TilePtr tile = _tile_store->get_tile(id/_tiles_per_row, id%_tiles_per_row);
+			it = _own_tiles.insert(std::make_pair(id, *tile)).first;
+			_tile_cache.reset();
+		}
+		int mask = (1<<_tile_shift)-1;
+		return it->second[((i & mask)<<_tile_shift) + (j & mask)];
+	}
+
+	void expand_dirty_region(int i, int j)
+	{
+		_dirty_min[0] = std::min(_dirty_min[0], i);
+		_dirty_min[1] = std::min(_dirty_min[1], j);
+		_dirty_max[0] = std::max(_dirty_max[0], i);
+		_dirty_max[1] = std::max(_dirty_max[1], j);
+	}
+
+	/// @brief add a log-odds update to cell (i,j) and change the cell if it crosses a threshold
+	void update_log_odds(int i, int j, float delta)
+	{
+		int64_t c = static_cast<int64_t>(i)*_width+j;
+		float l = std::min(_l_max, std::max(_l_min, _log_odds[c]+delta));
+		_log_odds[c] = l;
+		int8_t value = (l > _l_occupied)?100:(l < _l_free)?0:-1;
+		if(value != _data[c]) set_cell(i, j, value);
+	}
+
+	/// @brief check if cell c is a non-free cell of the distance transform
+	bool is_site(int32_t c)
+	{
+		return c>=0 && _nearest[c]==c;
+	}
+
+	/// @brief squared distance in cells from cell c to its nearest non-free cell, max int64 if there is none
+	int64_t squared_cell_distance(int64_t c)
+	{
+		int32_t site = _nearest[c];
+		if(site < 0) return std::numeric_limits<int64_t>::max();
+		int64_t di = c/_width - site/_width, dj = c%_width - site%_width;
+		return di*di + dj*dj;
+	}
+
+	/// @brief distance in cells from cell c to its nearest non-free cell
+	float cell_distance(int64_t c)
+	{
+		int32_t site = _nearest[c];
+		if(site < 0) return std::numeric_limits<float>::infinity();
+		float di = c/_width - site/_width, dj = c%_width - site%_width;
+		return std::sqrt(di*di + dj*dj);
+	}
+
+	/// @brief inflation cost of cell c from its distance
+	uint8_t compute_cost(int64_t c)
+	{
+		if(_data[c]!=0) return obstacle_cost;
+		float dist = cell_distance(c)*_resolution;
+		if(dist < _robot_radius) return inscribed_cost;
+		if(dist > _inflation_radius) return 0;
+		return static_cast<uint8_t>(253*std::exp(-_cost_scaling*(dist-_robot_radius)));
+	}
+
+	/**
+	* @brief exact Euclidean distance transform, storing the nearest non-free cell of every cell
+	*
+	* first pass finds the nearest non-free cell in the same column with a downward and an upward sweep,
+	* second pass computes the lower envelope of the parabolas $(j-j')^2 + f(j')$ along every row,
+	* where $f(j')$ is the squared column distance of $(i, j')$
+	*/
+	void compute_distance_transform()
+	{
+		int64_t n = static_cast<int64_t>(_width)*_height;
+		_nearest.assign(n, -1);
+		if(n==0) return;
+
+		// column pass, columns are split in chunks so that sweeps over rows stay row-major
+		int nchunks = std::max(1, std::min(4*get_max_threads(), _width));
+		#pragma omp parallel for schedule(static)
+		for(int chunk=0; chunk<nchunks; ++chunk)
+		{
+			int j0 = static_cast<long long>(_width)*chunk/nchunks, j1 = static_cast<long long>(_width)*(chunk+1)/nchunks;
+			std::vector<int> last(j1-j0, -1);
+			for(int i=0; i<_height; ++i)
+			{
+				for(int j=j0; j<j1; ++j)
+				{
+					int64_t c = static_cast<int64_t>(i)*_width+j;
+					if(_data[c]!=0) last[j-j0] = i;
+					_nearest[c] = last[j-j0];
+				}
+			}
+			last.assign(j1-j0, -1);
+			for(int i=_height-1; i>=0; --i)
+			{
+				for(int j=j0; j<j1; ++j)
+				{
+					int64_t c = static_cast<int64_t>(i)*_width+j;
+					if(_data[c]!=0) last[j-j0] = i;
+					int above = _nearest[c];
+					if(last[j-j0]>=0 && (above<0 || last[j-j0]-i < i-above)) _nearest[c] = last[j-j0];
+				}
+			}
+		}
+
+		// row pass, _nearest holds the nearest row in the column and is replaced by the nearest cell index
+		#pragma omp parallel for schedule(static)
+		for(int i=0; i<_height; ++i)
+		{
+			std::vector<int> rows(_width), v(_width);
+			std::vector<double> f(_width), z(_width+1);
+			int64_t row_start = static_cast<int64_t>(i)*_width;
+			for(int j=0; j<_width; ++j)
+			{
+				rows[j] = _nearest[row_start+j];
+				f[j] = (rows[j]>=0)?static_cast<double>(i-rows[j])*(i-rows[j]):-1;
+			}
+			// lower envelope of parabolas of columns with a non-free cell
+			int k = -1;
+			for(int q=0; q<_width; ++q)
+			{
+				if(f[q] < 0) continue;
+				double s = -std::numeric_limits<double>::infinity();
+				while(k>=0)
+				{
+					s = ((f[q]+static_cast<double>(q)*q) - (f[v[k]]+static_cast<double>(v[k])*v[k]))/(2.0*(q-v[k]));
+					if(s > z[k]) break;
+					--k;
+				}
+				++k;
+				v[k] = q;
+				z[k] = (k==0)?-std::numeric_limits<double>::infinity():s;
+				z[k+1] = std::numeric_limits<double>::infinity();
+			}
+			if(k < 0) continue;
+			k = 0;
+			for(int q=0; q<_width; ++q)
+			{
+				while(z[k+1] < q) ++k;
+				_nearest[row_start+q] = static_cast<int64_t>(rows[v[k]])*_width + v[k];
+			}
+		}
+	}
 };
 
 #endif
\ No newline at end of file
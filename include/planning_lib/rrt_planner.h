@@ -8,6 +8,10 @@
 
 /**
 * @brief RRT planner for 2d maps
+*
+* Edges are checked with `OccupancyGrid2d::ray_cast` against every cell they pass through, so with an inflation layer on the
+* map they keep the robot radius away from obstacles. With the map pyramid enabled, the ray cast skips free blocks instead of
+* visiting their cells one by one
 */
 class RRTPlanner2d: public BaseGlobalPlanner2d
 {
@@ -70,7 +74,7 @@ private:
 			// this step limits the distance between neighboring waypoints in the final path
 			Point2f valid_point = get_stop_point(closest_point, rand_point, max_step);
 			// use ray tracing to get the valid point on the line that stop before cutting an occupied cell
-			valid_point = ray_trace_sampled(closest_point, valid_point, 200);
+			valid_point = ray_trace_grid(closest_point, valid_point);
 
 			if(!valid_point.is_equal_to(closest_point))
 			{
@@ -116,40 +120,29 @@ private:
 	}
 
 	/**
-	* @brief ray tracing method that generates a set of equidistant samples on the line joining start and end points and checks for the points that donot cut an occupied cell in the map
-	* 
-	* @note Since this method samples the line into equidistant points, there can be cases where the generated points miss the occupied cells completely.
-	* A better procedure is needed
+	* @brief ray tracing method that checks every cell the line joining start and end points passes through
+	*
+	* uses `OccupancyGrid2d::ray_cast`, which skips free blocks of the map pyramid if it is enabled
 	*
 	* @param start start point
 	* @param end end point
-	* @param nsamples number of equidistant samples to be used on the line
-	* @return returns the first valid point on the line joining start and end that doesn't cut an occupied cell when traversed from start point 
+	* @return returns the point on the line joining start and end half a cell before the first cell the robot can't be at,
+	* or end if there is none
 	*/
-	Point2f ray_trace_sampled(Point2f& start, Point2f& end, int nsamples)
+	Point2f ray_trace_grid(Point2f& start, Point2f& end)
 	{
+		float t = _map.ray_cast(start[0], start[1], end[0], end[1]);
+		if(t >= 1) return end;
+		float length = start.distance_to(end);
+		if(length > 0) t = std::max(0.0f, t - 0.5f*_map.get_resolution()/length);
 		Point2f diff = end-start;
-		float d = 1.0/static_cast<float>(nsamples);
-		float d1 = 0.0;
-		while(d1<=1)
-		{
-			Point2f valid_point = start + diff*d1;
-			int i, j;
-			if(_map.xy_to_ij(valid_point[0], valid_point[1], i, j))
-			{
-				if(_map(i, j)!=0) break;
-			}
-			else break;
-			d1 += d;
-		}
-		d1 -= d;
-		return start + diff*d1;
+		return start + diff*t;
 	}
 
 	/**
 	* @brief ray trace procedure using bresenham ray tracing
 	*
-	* @note This method retreives all the cells on the descritized map that the line passes through and is better approach than the sampled implementation.
+	* @note This method retreives all the cells on the descritized map that the line passes through instead of sampling points on the line.
 	*
 	* @todo This call is sometimes causing seg-fault. Debug the implementation
 	*
@@ -177,7 +170,7 @@ private:
 			if(ray_points[0].is_equal_to(start_i))
 			{
 				int i=0;
-				while(i<ray_points.size() && _map(ray_points[i][0], ray_points[i][1])==0)
+				while(i<ray_points.size() && _map.is_traversable(ray_points[i][0], ray_points[i][1]))
 				{
 					++i;
 				}
@@ -189,7 +182,7 @@ private:
 			else if(ray_points[ray_points.size()-1].is_equal_to(start_i))
 			{
 				int i=ray_points.size()-1;
-				while(i>=0 && _map(ray_points[i][0], ray_points[i][1])==0)
+				while(i>=0 && _map.is_traversable(ray_points[i][0], ray_points[i][1]))
 				{
 					--i;
 				}
@@ -0,0 +1,149 @@
+#ifndef __EUCLIDEAN_CLUSTER_EXTRACTOR_H__
+#define __EUCLIDEAN_CLUSTER_EXTRACTOR_H__
+
+#include "data_structures/neighborhood_graph.h"
+#include <limits>
+
+/**
+* @brief Euclidean cluster extractor
+*
+* Splits a pointcloud into clusters of points, such that two points are in the same cluster if they are connected by a chain of
+* points with consecutive points less than `tolerance` apart. Typically used on the non-ground points after ground removal to
+* get individual objects.
+* Radius neighborhoods are gathered in parallel into a NeighborhoodGraph, connected components are then found with union-find
+* over the graph edges
+*/
+template<class T>
+class EuclideanClusterExtractor
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/// @brief bounding box of a cluster as {min corner, max corner}
+	typedef std::pair< Point<3, T>, Point<3, T> > BoundingBox;
+
+	/**
+	* @brief Constructor
+	*
+	* @param tolerance maximum distance between neighboring points of a cluster
+	* @param min_cluster_size clusters with less points are discarded
+	* @param max_cluster_size clusters with more points are discarded
+	*/
+	EuclideanClusterExtractor(double tolerance=0.5, int min_cluster_size=10, int max_cluster_size=std::numeric_limits<int>::max()):
+		_tolerance(tolerance), _min_cluster_size(min_cluster_size), _max_cluster_size(max_cluster_size) {}
+
+	/// @brief set maximum distance between neighboring points of a cluster
+	void set_tolerance(double tolerance)
+	{
+		_tolerance = tolerance;
+	}
+
+	/// @brief set minimum and maximum number of points in a cluster
+	void set_cluster_size(int min_cluster_size, int max_cluster_size)
+	{
+		_min_cluster_size = min_cluster_size;
+		_max_cluster_size = max_cluster_size;
+	}
+
+	/**
+	* @brief extract clusters from a pointcloud represented as vector of points
+	*
+	* @param pointvec vector of points
+	* @param labels computed cluster index of every point, -1 if the point is not part of a cluster within the size limits
+	* @return returns bounding boxes of the clusters, indexed by cluster index
+	*/
+	std::vector<BoundingBox> extract(std::vector< Point<3, T> >& pointvec, std::vector<int>& labels)
+	{
+		_graph.build(pointvec, _tolerance);
+		return extract(pointvec, _graph, labels);
+	}
+
+	/**
+	* @overload
+	*
+	* @param graph neighborhood graph of pointvec with radius equal to the cluster tolerance,
+	* for example shared with other stages that need the same neighborhoods
+	*/
+	std::vector<BoundingBox> extract(std::vector< Point<3, T> >& pointvec, const NeighborhoodGraph<3, T>& graph, std::vector<int>& labels)
+	{
+		int n = pointvec.size();
+		labels.assign(n, -1);
+
+		// union-find over graph edges
+		_parent.resize(n);
+		for(int i=0; i<n; ++i) _parent[i] = i;
+		for(int i=0; i<n; ++i)
+		{
+			for(const int* it=graph.neighbors_begin(i); it!=graph.neighbors_end(i); ++it)
+			{
+				if(*it > i) unite(i, *it);
+			}
+		}
+
+		// size of every component, stored at its root
+		_size.assign(n, 0);
+		for(int i=0; i<n; ++i) ++_size[find(i)];
+
+		// number components within size limits in order of their first point, root label is reused as cluster index
+		std::vector<BoundingBox> boxes;
+		_root_label.assign(n, -1);
+		for(int i=0; i<n; ++i)
+		{
+			int root = find(i);
+			if(_size[root] < _min_cluster_size || _size[root] > _max_cluster_size) continue;
+			if(_root_label[root]==-1)
+			{
+				_root_label[root] = boxes.size();
+				boxes.push_back({pointvec[i], pointvec[i]});
+			}
+			int label = _root_label[root];
+			labels[i] = label;
+			BoundingBox& box = boxes[label];
+			for(int k=0; k<3; ++k)
+			{
+				box.first[k] = std::min(box.first[k], pointvec[i][k]);
+				box.second[k] = std::max(box.second[k], pointvec[i][k]);
+			}
+		}
+		return boxes;
+	}
+
+private:
+	/// @brief cluster tolerance
+	double _tolerance;
+
+	/// @brief minimum number of points in a cluster
+	int _min_cluster_size;
+
+	/// @brief maximum number of points in a cluster
+	int _max_cluster_size;
+
+	/// @brief neighborhood graph, kept to reuse its buffers across frames
+	NeighborhoodGraph<3, T> _graph;
+
+	/// @brief union-find parents, component sizes and cluster index of component roots
+	std::vector<int> _parent, _size, _root_label;
+
+	/// @brief find root of the component of i with path halving
+	int find(int i)
+	{
+		while(_parent[i]!=i)
+		{
+			_parent[i] = _parent[_parent[i]];
+			i = _parent[i];
+		}
+		return i;
+	}
+
+	/// @brief merge components of i and j
+	void unite(int i, int j)
+	{
+		i = find(i);
+		j = find(j);
+		if(i==j) return;
+		if(i < j) std::swap(i, j);
+		_parent[i] = j;
+	}
+};
+
+#endif
@@ -0,0 +1,271 @@
+#ifndef __GROUND_SEGMENTER_H__
+#define __GROUND_SEGMENTER_H__
+
+#include "data_structures/point_types.h"
+#include "common/parallel_utils.h"
+#include <limits>
+#include <algorithm>
+
+/**
+* @brief Ground segmenter for lidar pointclouds
+*
+* Based on Himmelsbach et al., "Fast segmentation of 3D point clouds for ground vehicles".
+* Points are binned into polar sectors around the sensor and range bins within each sector, and the lowest point of every bin
+* is taken as its prototype. In each sector, prototypes are visited with increasing range and piecewise ground lines `z = m*r + b`
+* are fit incrementally, a new line is started whenever slope or fit error exceed their limits. Because every sector has its own
+* piecewise lines, slopes and ramps that a single plane cannot describe are handled.
+* A point is labelled ground if its vertical distance to the ground line of its bin is within a threshold, so points far below
+* the ground (multipath returns, pits) are not ground either. Both binning and labelling are a
+* single linear pass over the points
+*/
+template<class T>
+class GroundSegmenter
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param num_sectors number of polar sectors
+	* @param num_bins number of range bins in each sector
+	* @param max_range maximum range of points considered, points beyond are put in the last bin
+	* @param sensor_height height of the sensor above ground, used to seed the first ground line of each sector
+	*/
+	GroundSegmenter(int num_sectors=360, int num_bins=80, double max_range=80.0, double sensor_height=1.73):
+		_num_sectors(num_sectors), _num_bins(num_bins), _max_range(max_range), _sensor_height(sensor_height),
+		_max_slope(0.15), _max_fit_error(0.05), _max_start_height(0.3), _dist_thresh(0.2) {}
+
+	/**
+	* @brief set parameters used to fit ground lines
+	*
+	* @param max_slope maximum absolute slope of a ground line
+	* @param max_fit_error maximum root mean square error of prototype points from a ground line
+	* @param max_start_height maximum distance of the first prototype of a new line from the previous ground line (or from the
+	* sensor height for the first line of a sector)
+	*/
+	void set_line_params(double max_slope, double max_fit_error, double max_start_height)
+	{
+		_max_slope = max_slope;
+		_max_fit_error = max_fit_error;
+		_max_start_height = max_start_height;
+	}
+
+	/**
+	* @brief set maximum vertical distance of a ground point from the local ground line
+	*/
+	void set_dist_thresh(double dist_thresh)
+	{
+		_dist_thresh = dist_thresh;
+	}
+
+	/**
+	* @brief segment pointcloud into ground and other points
+	*
+	* @param pointvec vector of points in sensor frame (z up)
+	* @return returns pair of vector of points of form {ground points, other points}
+	*/
+	std::pair< std::vector< Point<3, T> >, std::vector< Point<3, T> > > segment(std::vector< Point<3, T> >& pointvec)
+	{
+		std::vector<char> is_ground;
+		segment(pointvec, is_ground);
+		std::vector< Point<3, T> > ground_points;
+		std::vector< Point<3, T> > other_points;
+		for(int i=0; i<pointvec.size(); ++i)
+		{
+			if(is_ground[i]) ground_points.push_back(pointvec[i]);
+			else other_points.push_back(pointvec[i]);
+		}
+		return {ground_points, other_points};
+	}
+
+	/**
+	* @overload
+	*
+	* @param is_ground computed label for every point, 1 if the point is ground else 0
+	*/
+	void segment(std::vector< Point<3, T> >& pointvec, std::vector<char>& is_ground)
+	{
+		int n = pointvec.size();
+		int ncells = _num_sectors*_num_bins;
+		is_ground.assign(n, 0);
+		_cell.resize(n);
+		_range.resize(n);
+		_prototype_r.assign(ncells, 0);
+		_prototype_z.assign(ncells, std::numeric_limits<T>::max());
+		_line_m.assign(ncells, 0);
+		_line_b.assign(ncells, std::numeric_limits<T>::quiet_NaN());
+
+		// bin points and keep lowest point of every bin as prototype
+		const double sector_size = 2.0*M_PI/_num_sectors;
+		const double bin_size = _max_range/_num_bins;
+		#pragma omp parallel for schedule(static)
+		for(int i=0; i<n; ++i)
+		{
+			const Point<3, T>& p = pointvec[i];
+			double r = std::sqrt(p[0]*p[0] + p[1]*p[1]);
+			int s = std::min(_num_sectors-1, static_cast<int>((std::atan2(p[1], p[0]) + M_PI)/sector_size));
+			int b = std::min(_num_bins-1, static_cast<int>(r/bin_size));
+			_cell[i] = s*_num_bins+b;
+			_range[i] = r;
+		}
+		for(int i=0; i<n; ++i)
+		{
+			int c = _cell[i];
+			T z = pointvec[i][2];
+			if(z < _prototype_z[c])
+			{
+				_prototype_z[c] = z;
+				_prototype_r[c] = _range[i];
+			}
+		}
+
+		// fit piecewise ground lines in every sector independently
+		#pragma omp parallel for schedule(dynamic, 8)
+		for(int s=0; s<_num_sectors; ++s) fit_sector(s);
+
+		// label points against ground line of their bin
+		#pragma omp parallel for schedule(static)
+		for(int i=0; i<n; ++i)
+		{
+			int c = _cell[i];
+			// NaN intercept, no ground line covers this bin
+			if(_line_b[c]!=_line_b[c]) continue;
+			is_ground[i] = (std::abs(pointvec[i][2] - (_line_m[c]*_range[i] + _line_b[c])) <= _dist_thresh);
+		}
+	}
+
+private:
+	/// @brief number of polar sectors
+	int _num_sectors;
+
+	/// @brief number of range bins per sector
+	int _num_bins;
+
+	/// @brief maximum range of the bins
+	double _max_range;
+
+	/// @brief sensor height above ground
+	double _sensor_height;
+
+	/// @brief maximum absolute slope of a ground line
+	double _max_slope;
+
+	/// @brief maximum rms error of a ground line fit
+	double _max_fit_error;
+
+	/// @brief maximum distance of the first prototype of a line from the previous ground estimate
+	double _max_start_height;
+
+	/// @brief maximum vertical distance of a ground point from the ground line
+	double _dist_thresh;
+
+	/// @brief bin index and range of every point
+	std::vector<int> _cell;
+	std::vector<T> _range;
+
+	/// @brief range and height of the lowest point of every bin
+	std::vector<T> _prototype_r, _prototype_z;
+
+	/// @brief slope and intercept of the ground line of every bin, intercept is NaN if no ground line covers the bin
+	std::vector<T> _line_m, _line_b;
+
+	/**
+	* @brief least squares line fit with running sums
+	*/
+	struct LineFit
+	{
+		double sr, sz, srr, srz, szz;
+		int count;
+
+		LineFit(): sr(0), sz(0), srr(0), srz(0), szz(0), count(0) {}
+
+		void add(double r, double z)
+		{
+			sr += r; sz += z; srr += r*r; srz += r*z; szz += z*z;
+			++count;
+		}
+
+		/// @brief compute slope m, intercept b and rms error of the fit
+		void solve(double& m, double& b, double& rms) const
+		{
+			double den = count*srr - sr*sr;
+			if(count < 2 || std::abs(den) < 1e-12)
+			{
+				m = 0;
+				b = sz/count;
+			}
+			else
+			{
+				m = (count*srz - sr*sz)/den;
+				b = (sz - m*sr)/count;
+			}
+			// sum of squared residuals expanded in terms of the running sums
+			double sse = szz - 2*m*srz - 2*b*sz + m*m*srr + 2*m*b*sr + count*b*b;
+			rms = std::sqrt(std::max(0.0, sse)/count);
+		}
+	};
+
+	/**
+	* @brief fit piecewise ground lines to the prototypes of a sector and assign a ground line to its bins
+	*/
+	void fit_sector(int s)
+	{
+		LineFit line;
+		double m = 0, b = -_sensor_height;
+		bool has_line = false;
+		int last_ground_bin = -1;
+		for(int k=0; k<_num_bins; ++k)
+		{
+			int c = s*_num_bins+k;
+			if(_prototype_z[c]==std::numeric_limits<T>::max()) continue;
+			double r = _prototype_r[c], z = _prototype_z[c];
+
+			bool accepted = false;
+			if(has_line)
+			{
+				// try extending the current line with this prototype
+				LineFit candidate = line;
+				candidate.add(r, z);
+				double cm, cb, rms;
+				candidate.solve(cm, cb, rms);
+				if(std::abs(cm) <= _max_slope && rms <= _max_fit_error && std::abs(z-(m*r+b)) <= _max_start_height)
+				{
+					line = candidate;
+					m = cm;
+					b = cb;
+					accepted = true;
+				}
+			}
+			if(!accepted && std::abs(z-(m*r+b)) <= _max_start_height)
+			{
+				// start a new line at this prototype, continuing from the previous ground estimate
+				line = LineFit();
+				if(last_ground_bin >= 0)
+				{
+					int lc = s*_num_bins+last_ground_bin;
+					line.add(_prototype_r[lc], _line_m[lc]*_prototype_r[lc] + _line_b[lc]);
+				}
+				line.add(r, z);
+				double rms;
+				line.solve(m, b, rms);
+				if(std::abs(m) > _max_slope)
+				{
+					m = 0;
+					b = z;
+				}
+				has_line = true;
+				accepted = true;
+			}
+			if(accepted) last_ground_bin = k;
+			// bins whose prototype is far above the ground line (obstacles) use extrapolation of the current line
+			if(has_line)
+			{
+				_line_m[c] = m;
+				_line_b[c] = b;
+			}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef __ICP_H__
+#define __ICP_H__
+
+#include "pointcloud_lib/normal_estimator.h"
+#include "common/parallel_utils.h"
+#include <chrono>
+
+/**
+* @brief error metrics minimized by ICP
+*
+* - POINT_TO_POINT: sum of squared distances between corresponding points, solved in closed form with SVD (Kabsch/Umeyama)
+* - POINT_TO_PLANE: sum of squared distances of source points to the tangent planes of their target correspondences,
+*   solved with Gauss-Newton on the linearized rotation
+*/
+enum class IcpMethod
+{
+	POINT_TO_POINT,
+	POINT_TO_PLANE
+};
+
+/**
+* @brief Iterative closest point registration of a source pointcloud to a target pointcloud
+*
+* The target KDTree (and target normals for point-to-plane) are built once in `set_target` and reused for every `align` call,
+* so for scan-to-scan odometry each frame is indexed once, as target, after being aligned as source.
+* Every iteration transforms the source points, searches correspondences in parallel, rejects correspondences farther than
+* `max_correspondence_dist` and computes the transform update. Iterations stop early once the update is below the convergence thresholds
+*/
+template<class T>
+class IterativeClosestPoint
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param method error metric to minimize
+	* @param max_iterations maximum number of iterations
+	* @param max_correspondence_dist maximum distance between corresponding points
+	*/
+	IterativeClosestPoint(IcpMethod method=IcpMethod::POINT_TO_PLANE, int max_iterations=30, double max_correspondence_dist=1.0):
+		_method(method), _max_iterations(max_iterations), _max_correspondence_dist(max_correspondence_dist),
+		_translation_eps(1e-4), _rotation_eps(1e-5), _normal_radius(0.5), _num_iterations(0), _fitness(0.0), _converged(false) {}
+
+	/// @brief set error metric to minimize
+	void set_method(IcpMethod method)
+	{
+		_method = method;
+	}
+
+	/// @brief set maximum number of iterations
+	void set_max_iterations(int max_iterations)
+	{
+		_max_iterations = max_iterations;
+	}
+
+	/// @brief set maximum distance between corresponding points
+	void set_max_correspondence_dist(double max_correspondence_dist)
+	{
+		_max_correspondence_dist = max_correspondence_dist;
+	}
+
+	/**
+	* @brief set convergence thresholds, ICP stops when translation and rotation of an update are both below them
+	*
+	* @param translation_eps translation threshold (in meters)
+	* @param rotation_eps rotation threshold (in radians)
+	*/
+	void set_convergence(double translation_eps, double rotation_eps)
+	{
+		_translation_eps = translation_eps;
+		_rotation_eps = rotation_eps;
+	}
+
+	/// @brief set radius used to estimate target normals for point-to-plane ICP when they are not passed to `set_target`
+	void set_normal_radius(double normal_radius)
+	{
+		_normal_radius = normal_radius;
+	}
+
+	/**
+	* @brief set target pointcloud and build its KDTree
+	*
+	* normals are estimated with `NormalEstimator` if method is point-to-plane
+	*
+	* @param pointvec target points
+	*/
+	void set_target(std::vector< Point<3, T> >& pointvec)
+	{
+		std::vector< Point<3, T> > normalvec;
+		if(_method==IcpMethod::POINT_TO_PLANE)
+		{
+			NormalEstimator<3, T> ne;
+			ne.set_pointcloud(pointvec);
+			normalvec = ne.get_normals(_normal_radius);
+		}
+		set_target(pointvec, normalvec);
+	}
+
+	/**
+	* @overload
+	*
+	* @param normalvec normals of target points, zero normals are ignored by point-to-plane ICP
+	*/
+	void set_target(std::vector< Point<3, T> >& pointvec, std::vector< Point<3, T> >& normalvec)
+	{
+		int n = pointvec.size();
+		_target.resize(n, 3);
+		for(int i=0; i<n; ++i) for(int k=0; k<3; ++k) _target(i, k) = pointvec[i][k];
+		_target_normals.resize(normalvec.size(), 3);
+		for(int i=0; i<normalvec.size(); ++i) for(int k=0; k<3; ++k) _target_normals(i, k) = normalvec[i][k];
+		_tree = KDTree<3, T>();
+		_tree.build(pointvec);
+	}
+
+	/**
+	* @brief align source pointcloud to the target pointcloud
+	*
+	* @param source source points
+	* @param initial_guess initial transform from source to target frame
+	* @return returns transform from source to target frame as a 4x4 homogeneous matrix
+	*/
+	Eigen::Matrix4d align(std::vector< Point<3, T> >& source, const Eigen::Matrix4d& initial_guess=Eigen::Matrix4d::Identity())
+	{
+		int n = source.size();
+		Eigen::Matrix<double, Eigen::Dynamic, 3> src(n, 3);
+		for(int i=0; i<n; ++i) for(int k=0; k<3; ++k) src(i, k) = source[i][k];
+
+		bool point_to_plane = (_method==IcpMethod::POINT_TO_PLANE && _target_normals.rows()==_target.rows());
+		Eigen::Matrix4d transform = initial_guess;
+		_correspondences.resize(n);
+		_iteration_times.clear();
+		_converged = false;
+		_num_iterations = 0;
+		int nchunks = std::max(1, std::min(4*get_max_threads(), n));
+
+		for(int iter=0; iter<_max_iterations; ++iter)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			Eigen::Matrix3d R = transform.block<3, 3>(0, 0);
+			Eigen::Vector3d t = transform.block<3, 1>(0, 3);
+
+			// parallel correspondence search, -1 if no target point within max_correspondence_dist
+			#pragma omp parallel for schedule(dynamic, 1)
+			for(int c=0; c<nchunks; ++c)
+			{
+				Point<3, T> query;
+				int end = static_cast<long long>(n)*(c+1)/nchunks;
+				for(int i=static_cast<long long>(n)*c/nchunks; i<end; ++i)
+				{
+					Eigen::Vector3d p = R*src.row(i).transpose() + t;
+					for(int k=0; k<3; ++k) query[k] = p(k);
+					auto node = _tree.search(query, 0);
+					_correspondences[i] = (node!=nullptr && node->point.distance_to(query) <= _max_correspondence_dist)?node->index:-1;
+					if(point_to_plane && _correspondences[i]>=0 && _target_normals.row(_correspondences[i]).isZero()) _correspondences[i] = -1;
+				}
+			}
+
+			Eigen::Matrix4d update = point_to_plane?point_to_plane_update(src, R, t):point_to_point_update(src, R, t);
+			transform = update*transform;
+			++_num_iterations;
+
+			std::chrono::duration<double> duration = std::chrono::high_resolution_clock::now()-start;
+			_iteration_times.push_back(duration.count());
+
+			double translation = update.block<3, 1>(0, 3).norm();
+			double rotation = std::acos(std::min(1.0, std::max(-1.0, (update.block<3, 3>(0, 0).trace()-1.0)/2.0)));
+			if(translation < _translation_eps && rotation < _rotation_eps)
+			{
+				_converged = true;
+				break;
+			}
+		}
+		return transform;
+	}
+
+	/// @brief number of iterations of the last `align` call
+	int get_num_iterations()
+	{
+		return _num_iterations;
+	}
+
+	/// @brief duration (in seconds) of every iteration of the last `align` call
+	const std::vector<double>& get_iteration_times()
+	{
+		return _iteration_times;
+	}
+
+	/// @brief mean squared error of the correspondences in the last iteration of the last `align` call
+	double get_fitness()
+	{
+		return _fitness;
+	}
+
+	/// @brief true if the last `align` call stopped because the update was below convergence thresholds
+	bool has_converged()
+	{
+		return _converged;
+	}
+
+private:
+	/// @brief error metric
+	IcpMethod _method;
+
+	/// @brief maximum number of iterations
+	int _max_iterations;
+
+	/// @brief maximum correspondence distance
+	double _max_correspondence_dist;
+
+	/// @brief convergence thresholds
+	double _translation_eps, _rotation_eps;
+
+	/// @brief radius to estimate target normals
+	double _normal_radius;
+
+	/// @brief KDTree of target points
+	KDTree<3, T> _tree;
+
+	/// @brief target points and normals as nx3 matrices
+	Eigen::Matrix<double, Eigen::Dynamic, 3> _target, _target_normals;
+
+	/// @brief index of target point corresponding to every source point, -1 if there is none
+	std::vector<int> _correspondences;
+
+	/// @brief statistics of the last align call
+	int _num_iterations;
+	std::vector<double> _iteration_times;
+	double _fitness;
+	bool _converged;
+
+	/**
+	* @brief closed form update minimizing point-to-point error using SVD of cross covariance matrix
+	*/
+	Eigen::Matrix4d point_to_point_update(const Eigen::Matrix<double, Eigen::Dynamic, 3>& src, const Eigen::Matrix3d& R, const Eigen::Vector3d& t)
+	{
+		int n = src.rows();
+		Eigen::Vector3d src_mean = Eigen::Vector3d::Zero(), tgt_mean = Eigen::Vector3d::Zero();
+		Eigen::Matrix3d cross = Eigen::Matrix3d::Zero();
+		double sq_error = 0.0;
+		int count = 0;
+		// single pass accumulation of sums, cross covariance = sum(p*q^T) - count*mean_p*mean_q^T
+		for(int i=0; i<n; ++i)
+		{
+			int j = _correspondences[i];
+			if(j<0) continue;
+			Eigen::Vector3d p = R*src.row(i).transpose() + t;
+			Eigen::Vector3d q = _target.row(j).transpose();
+			src_mean += p;
+			tgt_mean += q;
+			cross += p*q.transpose();
+			sq_error += (p-q).squaredNorm();
+			++count;
+		}
+		Eigen::Matrix4d update = Eigen::Matrix4d::Identity();
+		_fitness = (count>0)?sq_error/count:0.0;
+		if(count < 3) return update;
+		src_mean /= count;
+		tgt_mean /= count;
+		cross -= count*src_mean*tgt_mean.transpose();
+
+		Eigen::JacobiSVD<Eigen::Matrix3d> svd(cross, Eigen::ComputeFullU | Eigen::ComputeFullV);
+		Eigen::Matrix3d V = svd.matrixV(), U = svd.matrixU();
+		// avoid reflections
+		Eigen::Matrix3d D = Eigen::Matrix3d::Identity();
+		if((V*U.transpose()).determinant() < 0) D(2, 2) = -1;
+		Eigen::Matrix3d dR = V*D*U.transpose();
+		update.block<3, 3>(0, 0) = dR;
+		update.block<3, 1>(0, 3) = tgt_mean - dR*src_mean;
+		return update;
+	}
+
+	/**
+	* @brief Gauss-Newton update minimizing point-to-plane error
+	*
+	* for a correspondence (p, q, n) the residual is \f$n^T(p-q)\f$ and with small rotation \f$\omega\f$ and translation \f$\tau\f$
+	* its jacobian is \f$[(p \times n)^T, n^T]\f$. Normal equations are accumulated in parallel and solved with LDLT
+	*/
+	Eigen::Matrix4d point_to_plane_update(const Eigen::Matrix<double, Eigen::Dynamic, 3>& src, const Eigen::Matrix3d& R, const Eigen::Vector3d& t)
+	{
+		int n = src.rows();
+		typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+		typedef Eigen::Matrix<double, 6, 1> Vector6d;
+		int nthreads = get_max_threads();
+		std::vector<Matrix6d, Eigen::aligned_allocator<Matrix6d> > thread_A(nthreads, Matrix6d::Zero());
+		std::vector<Vector6d, Eigen::aligned_allocator<Vector6d> > thread_b(nthreads, Vector6d::Zero());
+		std::vector<double> thread_error(nthreads, 0.0);
+		std::vector<int> thread_count(nthreads, 0);
+
+		#pragma omp parallel for schedule(static, 1) num_threads(nthreads)
+		for(int c=0; c<nthreads; ++c)
+		{
+			int end = static_cast<long long>(n)*(c+1)/nthreads;
+			for(int i=static_cast<long long>(n)*c/nthreads; i<end; ++i)
+			{
+				int j = _correspondences[i];
+				if(j<0) continue;
+				Eigen::Vector3d p = R*src.row(i).transpose() + t;
+				Eigen::Vector3d q = _target.row(j).transpose();
+				Eigen::Vector3d normal = _target_normals.row(j).transpose();
+				double r = normal.dot(p-q);
+				Vector6d J;
+				J.head<3>() = p.cross(normal);
+				J.tail<3>() = normal;
+				thread_A[c] += J*J.transpose();
+				thread_b[c] -= J*r;
+				thread_error[c] += r*r;
+				++thread_count[c];
+			}
+		}
+
+		Matrix6d A = Matrix6d::Zero();
+		Vector6d b = Vector6d::Zero();
+		double sq_error = 0.0;
+		int count = 0;
+		for(int c=0; c<nthreads; ++c)
+		{
+			A += thread_A[c];
+			b += thread_b[c];
+			sq_error += thread_error[c];
+			count += thread_count[c];
+		}
+		Eigen::Matrix4d update = Eigen::Matrix4d::Identity();
+		_fitness = (count>0)?sq_error/count:0.0;
+		if(count < 6) return update;
+
+		Vector6d x = A.ldlt().solve(b);
+		Eigen::Vector3d omega = x.head<3>();
+		double angle = omega.norm();
+		if(angle > 0) update.block<3, 3>(0, 0) = Eigen::AngleAxisd(angle, omega/angle).toRotationMatrix();
+		update.block<3, 1>(0, 3) = x.tail<3>();
+		return update;
+	}
+};
+
+#endif
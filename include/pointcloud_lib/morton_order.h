@@ -0,0 +1,111 @@
+#ifndef __MORTON_ORDER_H__
+#define __MORTON_ORDER_H__
+
+#include "data_structures/point_types.h"
+#include "common/radix_sort.h"
+#include <limits>
+
+/**
+* @brief spread the lower 21 bits of v so that there are 2 zero bits between consecutive bits
+*/
+inline uint64_t morton_spread_bits(uint64_t v)
+{
+	v &= 0x1fffff;
+	v = (v | (v<<32)) & 0x1f00000000ffffULL;
+	v = (v | (v<<16)) & 0x1f0000ff0000ffULL;
+	v = (v | (v<<8)) & 0x100f00f00f00f00fULL;
+	v = (v | (v<<4)) & 0x10c30c30c30c30c3ULL;
+	v = (v | (v<<2)) & 0x1249249249249249ULL;
+	return v;
+}
+
+/**
+* @brief Morton (Z-order) code of a 3d cell index, interleaves the lower 21 bits of x, y and z
+*/
+inline uint64_t morton_encode(uint32_t x, uint32_t y, uint32_t z)
+{
+	return morton_spread_bits(x) | (morton_spread_bits(y)<<1) | (morton_spread_bits(z)<<2);
+}
+
+/**
+* @brief compute Morton keys of points
+*
+* the bounding box of the points is divided into a \f$2^{21}\f$ cells grid along its largest extent, and every point gets the
+* Morton code of its cell. Sorting points by these keys places points that are close in space close in memory
+*
+* @param pointvec vector of points
+* @param keys computed Morton key of every point
+*/
+template<class T>
+void compute_morton_keys(std::vector< Point<3, T> >& pointvec, std::vector<uint64_t>& keys)
+{
+	int n = pointvec.size();
+	keys.resize(n);
+	if(n==0) return;
+	T min_p[3], max_p[3];
+	for(int k=0; k<3; ++k)
+	{
+		min_p[k] = std::numeric_limits<T>::max();
+		max_p[k] = std::numeric_limits<T>::lowest();
+	}
+	for(int i=0; i<n; ++i)
+	{
+		for(int k=0; k<3; ++k)
+		{
+			min_p[k] = std::min(min_p[k], pointvec[i][k]);
+			max_p[k] = std::max(max_p[k], pointvec[i][k]);
+		}
+	}
+	double extent = std::max(max_p[0]-min_p[0], std::max(max_p[1]-min_p[1], max_p[2]-min_p[2]));
+	const double max_cell = (1<<21)-1;
+	double scale = (extent>0)?max_cell/extent:0.0;
+	#pragma omp parallel for schedule(static)
+	for(int i=0; i<n; ++i)
+	{
+		uint32_t c[3];
+		for(int k=0; k<3; ++k) c[k] = static_cast<uint32_t>((pointvec[i][k]-min_p[k])*scale);
+		keys[i] = morton_encode(c[0], c[1], c[2]);
+	}
+}
+
+/**
+* @brief permutation that sorts points in Morton order
+*
+* @param pointvec vector of points
+* @param order computed permutation, `order[i]` is the index in pointvec of the \f$i^{th}\f$ point in Morton order
+*/
+template<class T>
+void morton_order(std::vector< Point<3, T> >& pointvec, std::vector<int>& order)
+{
+	std::vector<uint64_t> keys;
+	compute_morton_keys(pointvec, keys);
+	radix_sort(keys, order, 63);
+}
+
+/**
+* @brief reorder points in place in Morton order
+*
+* @param pointvec vector of points, reordered in place
+* @param order computed permutation, `order[i]` is the index in the input vector of the \f$i^{th}\f$ point after reordering,
+* can be used to map results computed on reordered points back to the input order
+*/
+template<class T>
+void morton_reorder(std::vector< Point<3, T> >& pointvec, std::vector<int>& order)
+{
+	morton_order(pointvec, order);
+	std::vector< Point<3, T> > reordered(pointvec.size());
+	for(int i=0; i<order.size(); ++i) reordered[i] = std::move(pointvec[order[i]]);
+	pointvec.swap(reordered);
+}
+
+/**
+* @overload
+*/
+template<class T>
+void morton_reorder(std::vector< Point<3, T> >& pointvec)
+{
+	std::vector<int> order;
+	morton_reorder(pointvec, order);
+}
+
+#endif
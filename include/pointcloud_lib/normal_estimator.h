@@ -2,7 +2,44 @@
 #define __NORMAL_ESTIMATOR_H__
 
 #include "data_structures/kdtree.h"
+#include "data_structures/compact_kdtree.h"
+#include "data_structures/neighborhood_graph.h"
 #include "pointcloud_lib/point_utils.h"
+#include "pointcloud_lib/morton_order.h"
+
+/**
+* @brief per-point geometric features derived from the eigenvalues of the local covariance matrix
+*
+* Features are stored as a structure of arrays, i.e. `planarity[i]` is the planarity of the \f$i^{th}\f$ point.  
+* With eigenvalues sorted as \f$\lambda_1 \geq \lambda_2 \geq \lambda_3\f$,  
+* curvature (surface variation) \f$= \frac{\lambda_3}{\lambda_1+\lambda_2+\lambda_3}\f$,
+* linearity \f$= \frac{\lambda_1-\lambda_2}{\lambda_1}\f$,
+* planarity \f$= \frac{\lambda_2-\lambda_3}{\lambda_1}\f$ and
+* sphericity \f$= \frac{\lambda_3}{\lambda_1}\f$  
+* Points with less than 3 neighbors have all features set to 0
+*/
+template<class T>
+struct GeometricFeatures
+{
+	/// @brief eigenvalues of local covariance matrix in descending order
+	std::vector<T> lambda1, lambda2, lambda3;
+	std::vector<T> curvature;
+	std::vector<T> linearity;
+	std::vector<T> planarity;
+	std::vector<T> sphericity;
+
+	/// @brief resize all feature buffers to n elements, set to 0
+	void assign(size_t n)
+	{
+		for(auto buf: {&lambda1, &lambda2, &lambda3, &curvature, &linearity, &planarity, &sphericity}) buf->assign(n, 0);
+	}
+
+	/// @brief number of points the features are stored for
+	size_t size() const
+	{
+		return curvature.size();
+	}
+};
 
 /**
 * @brief Normal estimator class
@@ -29,7 +66,8 @@ class NormalEstimator
 	static_assert(d==3 && (std::is_same<T, float>::value || std::is_same<T, double>::value), "only supports 3 dimensional float and double points");
 public:
 	/// @brief Default constructor
-	NormalEstimator(): _has_normals(false) {}
+	NormalEstimator(): _graph(nullptr), _spatial_reorder(false), _quantize(false), _quantization_mode(QuantizationMode::FIXED16),
+		_quantization_resolution(0.005), _has_normals(false), _has_features(false) {}
 
 	/**
 	* @brief set input point cloud to process
@@ -40,6 +78,53 @@ public:
 	{
 		_pointvec = pointvec;
 		_has_normals = false;
+		_has_features = false;
+	}
+
+	/**
+	* @brief set neighborhood graph to take local neighborhoods from instead of KDTree radius queries
+	*
+	* when a graph is set, `search_radius` of `get_normals` and `get_features` is ignored
+	*
+	* @param graph neighborhood graph built from the set point vector (e.g. shared with a segmentation stage), nullptr to use KDTree queries
+	*/
+	void set_neighborhood_graph(const NeighborhoodGraph<d, T>* graph)
+	{
+		_graph = graph;
+		_has_normals = false;
+		_has_features = false;
+	}
+
+	/**
+	* @brief process points in Morton order
+	*
+	* points in scan order make consecutive neighborhood queries hit unrelated parts of the KDTree, with reordering enabled
+	* points are visited in Morton order so consecutive queries touch the same nodes. Results are still returned in the order of the set point vector
+	*
+	* @param spatial_reorder true to process points in Morton order
+	*/
+	void set_spatial_reorder(bool spatial_reorder)
+	{
+		_spatial_reorder = spatial_reorder;
+	}
+
+	/**
+	* @brief search neighborhoods in a CompactKDTree over quantized points instead of a KDTree
+	*
+	* reduces memory of the search structure for large pointclouds, neighbors are decoded on the fly and differ from the
+	* input points by the quantization error
+	*
+	* @param quantize true to use quantized points
+	* @param mode encoding of coordinates
+	* @param resolution quantization step of FIXED16 mode
+	*/
+	void set_quantization(bool quantize, QuantizationMode mode=QuantizationMode::FIXED16, double resolution=0.005)
+	{
+		_quantize = quantize;
+		_quantization_mode = mode;
+		_quantization_resolution = resolution;
+		_has_normals = false;
+		_has_features = false;
 	}
 
 	/**
@@ -49,10 +134,24 @@ public:
 	*/
 	std::vector< Point<d, T> > get_normals(const double& search_radius)
 	{
-		if(!_has_normals) compute_normals(search_radius);
+		if(!_has_normals) compute_normals(search_radius, false);
 		return _normalvec;
 	}
 
+	/**
+	* @brief return geometric features for each point in the set point vector
+	*
+	* features are computed in the same neighborhood query and decomposition as the normals,
+	* so calling `get_normals` after this method doesn't need another pass over the pointcloud
+	*
+	* @param search_radius radius to get neighborhood points for calculating local covariance matrix
+	*/
+	const GeometricFeatures<T>& get_features(const double& search_radius)
+	{
+		if(!_has_features) compute_normals(search_radius, true);
+		return _features;
+	}
+
 private:
 	/// @brief point vector to process
 	std::vector< Point<d, T> > _pointvec;
@@ -60,25 +159,68 @@ private:
 	/// @brief vector local normals for each point in the points vector
 	std::vector< Point<d, T> > _normalvec;
 
+	/// @brief geometric features for each point in the points vector
+	GeometricFeatures<T> _features;
+
+	/// @brief optional neighborhood graph of the points vector
+	const NeighborhoodGraph<d, T>* _graph;
+
+	/// @brief whether points are processed in Morton order
+	bool _spatial_reorder;
+
+	/// @brief whether neighborhoods are searched in quantized points
+	bool _quantize;
+
+	QuantizationMode _quantization_mode;
+
+	double _quantization_resolution;
+
 	bool _has_normals;
 
+	bool _has_features;
+
 	/**
 	* @brief method to compute normals based on SVD of local covariance matrix
+	*
+	* @param search_radius radius to get neighborhood points
+	* @param with_features if true, geometric features are also computed from the singular values of the same decomposition
 	*/
-	void compute_normals(const double& search_radius)
+	void compute_normals(const double& search_radius, bool with_features)
 	{
 		// O(nlogn) -> KDTree retreives neighbors in average O(logn) time
-		if(_has_normals) return;
+		if(_has_normals && (_has_features || !with_features)) return;
 
-		_normalvec = std::vector< Point<d, T> >();
+		int n = _pointvec.size();
+		_normalvec.assign(n, Point<d, T>());
+		if(with_features) _features.assign(n);
+		// order in which points are visited, order[j] is the index of the j-th visited point
+		std::vector<int> order;
+		if(_spatial_reorder) morton_order(_pointvec, order);
+		else
+		{
+			order.resize(n);
+			for(int k=0; k<n; ++k) order[k] = k;
+		}
 		// build KDTree from points vector
-		auto _tmpvec = _pointvec;
 		KDTree<d, T> _tree;
-		_tree.build(_tmpvec);
+		CompactKDTree<T> compact_tree(_quantization_mode, _quantization_resolution);
+		if(_graph==nullptr && _quantize) compact_tree.build(_pointvec);
+		else if(_graph==nullptr) _tree.build(_pointvec);
 		// for each point retreive points in local neighborhood and compute normals based on SVD of local covariance matrix
-		for(auto p: _pointvec)
+		std::vector< Point<d, T> > pneighbors;
+		for(int j=0; j<n; ++j)
 		{
-			auto pneighbors = _tree.neighborhood(p, search_radius);
+			int k = order[j];
+			auto& p = _pointvec[k];
+			if(_graph==nullptr && _quantize) compact_tree.neighborhood(p, search_radius, pneighbors);
+			else if(_graph==nullptr) pneighbors = _tree.neighborhood(p, search_radius);
+			else
+			{
+				// graph neighborhoods don't include the point itself
+				pneighbors.clear();
+				pneighbors.push_back(p);
+				for(const int* it=_graph->neighbors_begin(k); it!=_graph->neighbors_end(k); ++it) pneighbors.push_back(_pointvec[*it]);
+			}
 			if(pneighbors.size()>=3)
 			{
 				// compute covariance matrix
@@ -95,11 +237,36 @@ private:
 				// assume normals point towards origin
 				normal = (normal.dot(-p)>0)?normal:-normal;
 
-				_normalvec.push_back(normal);
+				_normalvec[k] = normal;
+
+				// covariance matrix is symmetric positive semi-definite, singular values are its eigenvalues in descending order
+				if(with_features) set_features(k, svd.singularValues());
 			}
-			else _normalvec.push_back(Point<d, T>());
 		}
 		_has_normals = true;
+		_has_features = _has_features || with_features;
+	}
+
+	/**
+	* @brief fill geometric features of the \f$k^{th}\f$ point from eigenvalues of its local covariance matrix
+	*
+	* @param k point index
+	* @param lambdas eigenvalues sorted in descending order
+	*/
+	void set_features(int k, const Eigen::Matrix<T, d, 1>& lambdas)
+	{
+		T l1 = lambdas(0), l2 = lambdas(1), l3 = lambdas(2);
+		_features.lambda1[k] = l1;
+		_features.lambda2[k] = l2;
+		_features.lambda3[k] = l3;
+		T sum = l1+l2+l3;
+		if(sum > 0) _features.curvature[k] = l3/sum;
+		if(l1 > 0)
+		{
+			_features.linearity[k] = (l1-l2)/l1;
+			_features.planarity[k] = (l2-l3)/l1;
+			_features.sphericity[k] = l3/l1;
+		}
 	}
 };
 
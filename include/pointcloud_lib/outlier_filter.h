@@ -0,0 +1,176 @@
+#ifndef __OUTLIER_FILTER_H__
+#define __OUTLIER_FILTER_H__
+
+#include "data_structures/kdtree.h"
+#include "common/parallel_utils.h"
+
+/**
+* @brief Statistical outlier filter
+*
+* For every point the mean distance to its k nearest neighbors is computed. A point is an outlier if its mean distance is larger than
+* \f$\mu + \alpha\sigma\f$, where \f$\mu\f$ and \f$\sigma\f$ are mean and standard deviation of the mean distances over the pointcloud
+* and \f$\alpha\f$ is `stddev_mult`.
+* Neighbor statistics are computed in parallel batches of points, each batch reusing its query buffers. The filter outputs a keep mask
+* instead of a filtered copy of the pointcloud
+*/
+template<class T>
+class StatisticalOutlierFilter
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param k number of nearest neighbors used for the mean distance
+	* @param stddev_mult multiplier of the standard deviation in the distance threshold
+	*/
+	StatisticalOutlierFilter(int k=10, double stddev_mult=1.0): _k(k), _stddev_mult(stddev_mult) {}
+
+	/**
+	* @brief compute keep mask of a pointcloud represented as vector of points
+	*
+	* @param pointvec vector of points
+	* @param keep computed mask, 1 if the point is an inlier else 0
+	*/
+	void filter(std::vector< Point<3, T> >& pointvec, std::vector<char>& keep)
+	{
+		KDTree<3, T> tree;
+		tree.build(pointvec);
+		filter(pointvec, tree, keep);
+	}
+
+	/**
+	* @overload
+	*
+	* @param tree KDTree built from pointvec
+	*/
+	void filter(std::vector< Point<3, T> >& pointvec, KDTree<3, T>& tree, std::vector<char>& keep)
+	{
+		int n = pointvec.size();
+		keep.assign(n, 1);
+		_mean_dists.resize(n);
+		int nbatches = std::max(1, std::min(4*get_max_threads(), n));
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int b=0; b<nbatches; ++b)
+		{
+			std::vector<int> indices;
+			std::vector<double> dists;
+			int end = static_cast<long long>(n)*(b+1)/nbatches;
+			for(int i=static_cast<long long>(n)*b/nbatches; i<end; ++i)
+			{
+				// query point itself is returned as its closest neighbor
+				tree.k_nearest_indices(pointvec[i], _k+1, indices, dists);
+				double sum = 0.0;
+				for(int j=1; j<dists.size(); ++j) sum += dists[j];
+				_mean_dists[i] = (dists.size()>1)?sum/(dists.size()-1):0.0;
+			}
+		}
+
+		double mean = 0.0, sq_mean = 0.0;
+		for(int i=0; i<n; ++i)
+		{
+			mean += _mean_dists[i];
+			sq_mean += _mean_dists[i]*_mean_dists[i];
+		}
+		if(n==0) return;
+		mean /= n;
+		double stddev = std::sqrt(std::max(0.0, sq_mean/n - mean*mean));
+		double thresh = mean + _stddev_mult*stddev;
+		for(int i=0; i<n; ++i) keep[i] = (_mean_dists[i] <= thresh);
+	}
+
+	/// @brief mean distance of every point to its k nearest neighbors, computed in the last call to `filter`
+	const std::vector<double>& get_mean_distances()
+	{
+		return _mean_dists;
+	}
+
+private:
+	/// @brief number of nearest neighbors
+	int _k;
+
+	/// @brief multiplier of standard deviation
+	double _stddev_mult;
+
+	/// @brief mean distance to k nearest neighbors of every point
+	std::vector<double> _mean_dists;
+};
+
+/**
+* @brief Radius outlier filter
+*
+* A point is an outlier if it has less than `min_neighbors` other points within `radius`.
+* Neighbors are counted in parallel batches of points, each batch reusing its query buffer. The filter outputs a keep mask
+* instead of a filtered copy of the pointcloud
+*/
+template<class T>
+class RadiusOutlierFilter
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param radius search radius
+	* @param min_neighbors minimum number of neighbors within radius of an inlier, not counting the point itself
+	*/
+	RadiusOutlierFilter(double radius=0.5, int min_neighbors=2): _radius(radius), _min_neighbors(min_neighbors) {}
+
+	/**
+	* @brief compute keep mask of a pointcloud represented as vector of points
+	*
+	* @param pointvec vector of points
+	* @param keep computed mask, 1 if the point is an inlier else 0
+	*/
+	void filter(std::vector< Point<3, T> >& pointvec, std::vector<char>& keep)
+	{
+		KDTree<3, T> tree;
+		tree.build(pointvec);
+		filter(pointvec, tree, keep);
+	}
+
+	/**
+	* @overload
+	*
+	* @param tree KDTree built from pointvec
+	*/
+	void filter(std::vector< Point<3, T> >& pointvec, KDTree<3, T>& tree, std::vector<char>& keep)
+	{
+		int n = pointvec.size();
+		keep.assign(n, 1);
+		int nbatches = std::max(1, std::min(4*get_max_threads(), n));
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int b=0; b<nbatches; ++b)
+		{
+			std::vector<int> indices;
+			int end = static_cast<long long>(n)*(b+1)/nbatches;
+			for(int i=static_cast<long long>(n)*b/nbatches; i<end; ++i)
+			{
+				tree.neighborhood_indices(pointvec[i], _radius, indices);
+				// neighborhood includes the point itself
+				keep[i] = (static_cast<int>(indices.size())-1 >= _min_neighbors);
+			}
+		}
+	}
+
+private:
+	/// @brief search radius
+	double _radius;
+
+	/// @brief minimum number of neighbors of an inlier
+	int _min_neighbors;
+};
+
+/**
+* @brief convert a keep mask to the list of indices of kept points
+*/
+inline std::vector<int> mask_to_indices(const std::vector<char>& keep)
+{
+	std::vector<int> indices;
+	for(int i=0; i<keep.size(); ++i) if(keep[i]) indices.push_back(i);
+	return indices;
+}
+
+#endif
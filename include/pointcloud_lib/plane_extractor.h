@@ -2,14 +2,35 @@
 #define __PLANE_EXTRACTOR_H__
 
 #include "data_structures/point_types.h"
-#include <unordered_set>
-#include <ctime>
-#include <cstdlib>
+#include "common/parallel_utils.h"
+#include <eigen3/Eigen/Dense>
+#include <algorithm>
+#include <random>
+
+/**
+* @brief RANSAC strategies for generating and verifying plane hypotheses
+*
+* - STANDARD: uniform sampling, every hypothesis is scored against all points
+* - TDD: randomized T(d,d) pre-test, a hypothesis is scored against all points only if d randomly drawn points are all inliers
+* - PREEMPTIVE: preemptive RANSAC, a fixed set of hypotheses is scored on blocks of randomly ordered points and
+*   the worse half is dropped after each block
+* - PROSAC: progressive sampling from the points with highest quality (see `PlaneExtractor::set_point_quality`),
+*   the sampling set grows towards the full pointcloud with iterations
+*/
+enum class RansacStrategy
+{
+	STANDARD,
+	TDD,
+	PREEMPTIVE,
+	PROSAC
+};
 
 /**
 * @brief PlaneExtractor class to extract maximum plane for a point cloud
 *
-* maximum plane is the plane that passes through maximum number of points in the current point cloud
+* maximum plane is the plane that passes through maximum number of points in the current point cloud  
+* RANSAC hypotheses are evaluated in parallel batches (one hypothesis per thread), each batch slot drawing samples
+* from its own random engine seeded from `set_seed`, so results are reproducible for a given seed and thread count
 */
 template<class T>
 class PlaneExtractor
@@ -20,7 +41,51 @@ public:
 	/**
 	* @brief Default constructor
 	*/
-	PlaneExtractor() {}
+	PlaneExtractor(): _num_iterations(0), _seed(std::mt19937::default_seed), _strategy(RansacStrategy::STANDARD), 
+		_tdd_points(1), _preemptive_block_size(100) {}
+
+	/**
+	* @brief set strategy used to generate and verify RANSAC hypotheses
+	*/
+	void set_strategy(RansacStrategy strategy)
+	{
+		_strategy = strategy;
+	}
+
+	/**
+	* @brief set number of points d used in the T(d,d) pre-test of `RansacStrategy::TDD`
+	*/
+	void set_tdd_points(int d)
+	{
+		_tdd_points = d;
+	}
+
+	/**
+	* @brief set number of points scored per block in `RansacStrategy::PREEMPTIVE`
+	*/
+	void set_preemptive_block_size(int block_size)
+	{
+		_preemptive_block_size = block_size;
+	}
+
+	/**
+	* @brief set per point quality scores for `RansacStrategy::PROSAC`, points with higher quality are sampled first
+	*
+	* @param quality vector of scores with same size as the pointcloud passed to `extract_plane`, 
+	* for example planarity or agreement of local normal with expected plane normal
+	*/
+	void set_point_quality(const std::vector<T>& quality)
+	{
+		_quality = quality;
+	}
+
+	/**
+	* @brief set seed for the random engines used to sample RANSAC hypotheses
+	*/
+	void set_seed(unsigned int seed)
+	{
+		_seed = seed;
+	}
 
 	/**
 	* @brief method to extract plane from pointcloud represented as vector of points
@@ -28,23 +93,117 @@ public:
 	* @param pointvec vector of points
 	* @param max_iterations maximum iterations for RANSAC
 	* @param dist_thresh distance threshold from plane to say a point is on the plane
+	* @param confidence probability of having drawn at least one outlier free sample, used to stop RANSAC before `max_iterations`
 	* @return returns pair of vector of points of form {plane points, other points}
 	*/
-	std::pair< std::vector< Point<3, T> >, std::vector< Point<3, T> > > extract_plane(std::vector< Point<3, T> >& pointvec, int max_iterations, double dist_thresh)
+	std::pair< std::vector< Point<3, T> >, std::vector< Point<3, T> > > extract_plane(std::vector< Point<3, T> >& pointvec, int max_iterations, double dist_thresh, double confidence=0.99)
 	{
-		// get plane inlier indices using RANSAC
-		auto inliers = extract_plane_ransac(pointvec, max_iterations, dist_thresh);
+		// get plane inlier mask using RANSAC
+		auto inliers = extract_plane_ransac(pointvec, max_iterations, dist_thresh, confidence);
 		// differentiate inliers and other points into 2 point vectors
 		std::vector< Point<3, T> > plane_points;
 		std::vector< Point<3, T> > other_points;
 		for(int i=0; i<pointvec.size(); ++i)
 		{
-			if(inliers.find(i)==inliers.end()) other_points.push_back(pointvec[i]);
-			else plane_points.push_back(pointvec[i]);
+			if(inliers[i]) plane_points.push_back(pointvec[i]);
+			else other_points.push_back(pointvec[i]);
 		}
 		return {plane_points, other_points};
-	} 
+	}
+
+	/**
+	* @brief method to sequentially extract multiple planes from pointcloud represented as vector of points
+	*
+	* planes are extracted one after the other from a shrinking list of indices of the points not yet assigned to a plane, 
+	* each plane is refined by least squares fit on its RANSAC inliers before its inliers are assigned.
+	* Extraction stops after `max_planes` planes or when the best plane has less than `min_support` points
+	*
+	* @param pointvec vector of points
+	* @param max_planes maximum number of planes to extract
+	* @param min_support minimum number of points on a plane
+	* @param max_iterations maximum iterations for RANSAC per plane
+	* @param dist_thresh distance threshold from plane to say a point is on the plane
+	* @param labels per point index of the plane the point belongs to, -1 if the point is not on any of the extracted planes
+	* @param confidence probability of having drawn at least one outlier free sample, used to stop RANSAC before `max_iterations`
+	* @return returns coefficients (a, b, c, d) with unit normal (a, b, c) of the extracted planes, in order of extraction
+	*/
+	std::vector< Point<4, T> > extract_planes(std::vector< Point<3, T> >& pointvec, int max_planes, int min_support, int max_iterations, double dist_thresh, 
+		std::vector<int>& labels, double confidence=0.99)
+	{
+		int n = pointvec.size();
+		labels.assign(n, -1);
+		std::vector< Point<4, T> > planes;
+		T thresh = dist_thresh;
+
+		// indices of points not assigned to any plane yet
+		std::vector<int> indices(n);
+		for(int i=0; i<n; ++i) indices[i] = i;
+
+		int total_iterations = 0;
+		while(planes.size() < max_planes && indices.size() >= std::max(3, min_support))
+		{
+			set_coordinate_buffers(pointvec, indices);
+			Point<4, T> coefs;
+			int count = ransac(max_iterations, thresh, confidence, coefs);
+			total_iterations += _num_iterations;
+			if(count < min_support || count < 3) break;
+			refine_plane(coefs, thresh);
+
+			// refined plane can lose support, stop before labelling if it fell below min_support (or to nothing, which
+			// would extract the same plane again)
+			int plane_id = planes.size();
+			int m = indices.size();
+			int support = 0;
+			for(int j=0; j<m; ++j)
+			{
+				if(std::abs(coefs[0]*_x[j] + coefs[1]*_y[j] + coefs[2]*_z[j] + coefs[3]) <= thresh) ++support;
+			}
+			if(support==0 || support < min_support) break;
+
+			// assign inliers of the refined plane and shrink the index list
+			int k = 0;
+			for(int j=0; j<m; ++j)
+			{
+				if(std::abs(coefs[0]*_x[j] + coefs[1]*_y[j] + coefs[2]*_z[j] + coefs[3]) <= thresh) labels[indices[j]] = plane_id;
+				else indices[k++] = indices[j];
+			}
+			indices.resize(k);
+			planes.push_back(coefs);
+		}
+		_num_iterations = total_iterations;
+		return planes;
+	}
+
+	/// @brief number of RANSAC hypotheses evaluated in the last call to `extract_plane` or `extract_planes`
+	int get_num_iterations()
+	{
+		return _num_iterations;
+	}
 private:
+	/// @brief number of RANSAC hypotheses evaluated in the last run
+	int _num_iterations;
+
+	/// @brief seed for the per batch slot random engines
+	unsigned int _seed;
+
+	/// @brief strategy to generate and verify hypotheses
+	RansacStrategy _strategy;
+
+	/// @brief number of points in the T(d,d) pre-test
+	int _tdd_points;
+
+	/// @brief number of points scored per block in preemptive RANSAC
+	int _preemptive_block_size;
+
+	/// @brief per point quality scores for PROSAC
+	std::vector<T> _quality;
+
+	/// @brief contiguous x, y and z coordinate buffers of the points being processed
+	std::vector<T> _x, _y, _z;
+
+	/// @brief quality scores of the points being processed, empty if no quality is set
+	std::vector<T> _q;
+
 	/**
 	* @brief estimate plane passing through 3 points
 	*
@@ -68,35 +227,357 @@ private:
 	}
 
 	/**
-	* @brief extract indices of points that a maximum plane will fit using RANSAC
+	* @brief copy point coordinates into contiguous buffers for vectorized scoring
+	*/
+	void set_coordinate_buffers(std::vector< Point<3, T> >& pointvec)
+	{
+		std::vector<int> indices(pointvec.size());
+		for(int i=0; i<indices.size(); ++i) indices[i] = i;
+		set_coordinate_buffers(pointvec, indices);
+	}
+
+	/**
+	* @overload
+	*
+	* copies only the points at the given indices, in order
+	*/
+	void set_coordinate_buffers(std::vector< Point<3, T> >& pointvec, const std::vector<int>& indices)
+	{
+		int n = indices.size();
+		_x.resize(n);
+		_y.resize(n);
+		_z.resize(n);
+		for(int i=0; i<n; ++i)
+		{
+			auto& p = pointvec[indices[i]];
+			_x[i] = p[0];
+			_y[i] = p[1];
+			_z[i] = p[2];
+		}
+		_q.clear();
+		if(_quality.size()==pointvec.size())
+		{
+			_q.resize(n);
+			for(int i=0; i<n; ++i) _q[i] = _quality[indices[i]];
+		}
+	}
+
+	/**
+	* @brief refine plane by least squares fit on its inliers in the coordinate buffers
+	*
+	* plane passes through the centroid of the inliers, normal is the eigenvector of the least eigenvalue of the inliers' covariance matrix
 	*/
-	std::unordered_set<int> extract_plane_ransac(std::vector< Point<3, T> >& pointvec, int max_iterations, double dist_thresh)
+	void refine_plane(Point<4, T>& coefs, T dist_thresh)
 	{
-		std::unordered_set<int> inliers;
-		srand(time(NULL));
+		int n = _x.size();
+		Eigen::Matrix<double, 3, 1> mean = Eigen::Matrix<double, 3, 1>::Zero();
+		Eigen::Matrix<double, 3, 3> cov = Eigen::Matrix<double, 3, 3>::Zero();
+		int count = 0;
+		for(int j=0; j<n; ++j)
+		{
+			if(std::abs(coefs[0]*_x[j] + coefs[1]*_y[j] + coefs[2]*_z[j] + coefs[3]) > dist_thresh) continue;
+			Eigen::Matrix<double, 3, 1> p(_x[j], _y[j], _z[j]);
+			mean += p;
+			cov += p*p.transpose();
+			++count;
+		}
+		if(count < 3) return;
+		mean /= count;
+		cov = cov/count - mean*mean.transpose();
+		Eigen::SelfAdjointEigenSolver< Eigen::Matrix<double, 3, 3> > solver(cov);
+		Eigen::Matrix<double, 3, 1> normal = solver.eigenvectors().col(0);
+		// keep orientation of the RANSAC plane
+		if(normal(0)*coefs[0] + normal(1)*coefs[1] + normal(2)*coefs[2] < 0) normal = -normal;
+		for(int i=0; i<3; ++i) coefs[i] = normal(i);
+		coefs[3] = -normal.dot(mean);
+	}
+
+	/**
+	* @brief compute plane with unit normal through 3 points of the coordinate buffers
+	*
+	* @return returns false if the points are degenerate (collinear)
+	*/
+	bool plane_through(int i0, int i1, int i2, Point<4, T>& coefs)
+	{
+		coefs = estimate_plane_through({Point<3, T>({_x[i0], _y[i0], _z[i0]}), Point<3, T>({_x[i1], _y[i1], _z[i1]}), Point<3, T>({_x[i2], _y[i2], _z[i2]})});
+		// normalize once so that point to plane distance is |a*x + b*y + c*z + d|
+		T norm = std::sqrt(coefs[0]*coefs[0] + coefs[1]*coefs[1] + coefs[2]*coefs[2]);
+		if(norm==0) return false;
+		for(int i=0; i<4; ++i) coefs[i] /= norm;
+		return true;
+	}
 
+	/**
+	* @brief sample 3 distinct points uniformly and compute plane through them
+	*
+	* @return returns false if the sampled points are degenerate (collinear)
+	*/
+	bool sample_plane(std::mt19937& gen, Point<4, T>& coefs)
+	{
+		int n = _x.size();
+		std::uniform_int_distribution<int> distrib(0, n-1);
+		int i0 = distrib(gen);
+		int i1 = distrib(gen);
+		while(i0==i1) i1 = distrib(gen);
+		int i2 = distrib(gen);
+		while(i0==i2 || i1==i2) i2 = distrib(gen);
+		return plane_through(i0, i1, i2, coefs);
+	}
+
+	/**
+	* @brief PROSAC sample, 3 distinct points from the top n points ordered by quality
+	*
+	* @param order point indices sorted by decreasing quality
+	* @param n size of the current sampling set
+	* @param include_nth if true, the n-th point is always part of the sample and the other 2 are drawn from the top n-1 points
+	*/
+	bool sample_plane_prosac(std::mt19937& gen, const std::vector<int>& order, int n, bool include_nth, Point<4, T>& coefs)
+	{
+		int m = include_nth?n-1:n;
+		std::uniform_int_distribution<int> distrib(0, m-1);
+		int i0 = distrib(gen);
+		int i1 = distrib(gen);
+		while(i0==i1) i1 = distrib(gen);
+		int i2 = n-1;
+		if(!include_nth)
+		{
+			i2 = distrib(gen);
+			while(i0==i2 || i1==i2) i2 = distrib(gen);
+		}
+		return plane_through(order[i0], order[i1], order[i2], coefs);
+	}
+
+	/**
+	* @brief count points in [begin, end) within dist_thresh of the plane (with unit normal) without storing them
+	*/
+	int count_inliers(const Point<4, T>& coefs, T dist_thresh, const T* x, const T* y, const T* z, int begin, int end)
+	{
+		const T a = coefs[0], b = coefs[1], c = coefs[2], d = coefs[3];
+		int count = 0;
+		#pragma omp simd reduction(+:count)
+		for(int j=begin; j<end; ++j) count += (std::abs(a*x[j] + b*y[j] + c*z[j] + d) <= dist_thresh);
+		return count;
+	}
+
+	/**
+	* @overload
+	*
+	* counts inliers over all points in the coordinate buffers
+	*/
+	int count_inliers(const Point<4, T>& coefs, T dist_thresh)
+	{
+		return count_inliers(coefs, dist_thresh, _x.data(), _y.data(), _z.data(), 0, _x.size());
+	}
+
+	/**
+	* @brief randomized T(d,d) pre-test, checks if d randomly drawn points are inliers of the plane
+	*/
+	bool tdd_test(std::mt19937& gen, const Point<4, T>& coefs, T dist_thresh)
+	{
+		std::uniform_int_distribution<int> distrib(0, _x.size()-1);
+		for(int k=0; k<_tdd_points; ++k)
+		{
+			int j = distrib(gen);
+			if(std::abs(coefs[0]*_x[j] + coefs[1]*_y[j] + coefs[2]*_z[j] + coefs[3]) > dist_thresh) return false;
+		}
+		return true;
+	}
+
+	/**
+	* @brief number of iterations needed to draw an outlier free sample of 3 points with the given confidence
+	*
+	* \f$N = \frac{\log(1-p)}{\log(1-w^s)}\f$, where w is the inlier ratio, p is the confidence and s is the sample size (3 for plane)
+	*/
+	int adaptive_iterations(double inlier_ratio, double confidence, int max_iterations, int sample_size=3)
+	{
+		double ws = std::pow(inlier_ratio, sample_size);
+		if(ws >= 1.0) return 1;
+		if(ws <= 0.0) return max_iterations;
+		double n = std::log(1.0-confidence)/std::log(1.0-ws);
+		if(!(n < max_iterations)) return max_iterations;
+		return std::max(1, static_cast<int>(std::ceil(n)));
+	}
+
+	/**
+	* @brief extract mask of points that a maximum plane will fit using RANSAC
+	*
+	* hypotheses are only scored by inlier count, the inlier mask is materialized once for the best plane.
+	* Number of iterations is adapted from the best inlier ratio found so far and the target confidence
+	*/
+	std::vector<bool> extract_plane_ransac(std::vector< Point<3, T> >& pointvec, int max_iterations, double dist_thresh, double confidence)
+	{
 		int n = pointvec.size();
-		for(int i=0; i<max_iterations; ++i)
+		std::vector<bool> inliers(n, false);
+		_num_iterations = 0;
+		if(n < 3) return inliers;
+
+		set_coordinate_buffers(pointvec);
+		T thresh = dist_thresh;
+
+		Point<4, T> best_coefs;
+		int best_count = ransac(max_iterations, thresh, confidence, best_coefs);
+
+		if(best_count==0) return inliers;
+		const T a = best_coefs[0], b = best_coefs[1], c = best_coefs[2], d = best_coefs[3];
+		for(int j=0; j<n; ++j) inliers[j] = std::abs(a*_x[j] + b*_y[j] + c*_z[j] + d) <= thresh;
+		return inliers;
+	}
+
+	/**
+	* @brief run RANSAC with the selected strategy on the points in the coordinate buffers
+	*
+	* @return returns inlier count of the best plane, coefficients are stored in best_coefs
+	*/
+	int ransac(int max_iterations, T dist_thresh, double confidence, Point<4, T>& best_coefs)
+	{
+		_num_iterations = 0;
+		if(_x.size() < 3) return 0;
+		if(_strategy==RansacStrategy::PREEMPTIVE) return preemptive_ransac(max_iterations, dist_thresh, best_coefs);
+		return adaptive_ransac(max_iterations, dist_thresh, confidence, best_coefs);
+	}
+
+	/**
+	* @brief RANSAC with adaptive number of iterations, used by `STANDARD`, `TDD` and `PROSAC` strategies
+	*
+	* @return returns inlier count of the best plane, coefficients are stored in best_coefs
+	*/
+	int adaptive_ransac(int max_iterations, T dist_thresh, double confidence, Point<4, T>& best_coefs)
+	{
+		int n = _x.size();
+		// one random engine and one hypothesis per batch slot
+		int batch_size = get_max_threads();
+		std::vector<std::mt19937> engines;
+		for(int t=0; t<batch_size; ++t) engines.push_back(std::mt19937(_seed+t));
+		std::vector< Point<4, T> > batch_coefs(batch_size);
+		std::vector<int> batch_counts(batch_size, 0);
+
+		// PROSAC sampling schedule, size of the sampling set grows as in Chum and Matas, "Matching with PROSAC"
+		bool prosac = (_strategy==RansacStrategy::PROSAC && _q.size()==n);
+		std::vector<int> order;
+		std::vector<int> batch_n(batch_size, n);
+		std::vector<char> batch_include_nth(batch_size, 0);
+		int prosac_n = 3;
+		double prosac_tn = max_iterations;
+		int prosac_tn_prime = 1;
+		if(prosac)
 		{
-			std::unordered_set<int> inliers_this_iteration;
-			int i0 = rand()%n;
-			int i1 = rand()%n;
-			while(i0==i1) i1 = rand()%n;
-			int i2 = rand()%n;
-			while(i0==i2 || i1==i2) i2 = rand()%n;
-			auto coefs = estimate_plane_through({pointvec[i0], pointvec[i1], pointvec[i2]});
-			for(int j=0; j<n; ++j)
+			order.resize(n);
+			for(int i=0; i<n; ++i) order[i] = i;
+			std::sort(order.begin(), order.end(), [this](int a, int b){
+				return _q[a] > _q[b];
+			});
+			for(int i=0; i<3; ++i) prosac_tn *= static_cast<double>(3-i)/(n-i);
+		}
+
+		// T(d,d) pre-test adds d points to the sample that needs to be outlier free
+		int sample_size = (_strategy==RansacStrategy::TDD)?3+_tdd_points:3;
+
+		int best_count = 0;
+		int num_iterations = max_iterations;
+		while(_num_iterations < num_iterations)
+		{
+			int batch = std::min(batch_size, num_iterations-_num_iterations);
+			if(prosac)
+			{
+				// schedule is sequential in the hypothesis index, so it is computed before dispatching the batch
+				for(int t=0; t<batch; ++t)
+				{
+					int iteration = _num_iterations+t+1;
+					if(iteration==prosac_tn_prime && prosac_n<n)
+					{
+						++prosac_n;
+						double tn = prosac_tn*(prosac_n)/(prosac_n-3);
+						prosac_tn_prime += static_cast<int>(std::ceil(tn-prosac_tn));
+						prosac_tn = tn;
+					}
+					batch_n[t] = prosac_n;
+					batch_include_nth[t] = (prosac_tn_prime >= iteration && prosac_n > 3);
+				}
+			}
+			#pragma omp parallel for num_threads(batch) schedule(static, 1)
+			for(int t=0; t<batch; ++t)
+			{
+				batch_counts[t] = 0;
+				bool valid = prosac?sample_plane_prosac(engines[t], order, batch_n[t], batch_include_nth[t], batch_coefs[t]):sample_plane(engines[t], batch_coefs[t]);
+				if(valid && _strategy==RansacStrategy::TDD) valid = tdd_test(engines[t], batch_coefs[t], dist_thresh);
+				if(valid) batch_counts[t] = count_inliers(batch_coefs[t], dist_thresh);
+			}
+			_num_iterations += batch;
+			// reduce in slot order to keep results independent of thread scheduling
+			for(int t=0; t<batch; ++t)
 			{
-				if(i0==j || i1==j || i2==j) inliers_this_iteration.insert(j);
-				else
+				if(best_count < batch_counts[t])
 				{
-					double dist = std::abs(coefs[0]*pointvec[j][0] + coefs[1]*pointvec[j][1] + coefs[2]*pointvec[j][2] + coefs[3])/std::sqrt(coefs[0]*coefs[0] + coefs[1]*coefs[1] + coefs[2]*coefs[2]);
-					if(dist <= dist_thresh) inliers_this_iteration.insert(j);
+					best_count = batch_counts[t];
+					best_coefs = batch_coefs[t];
+					num_iterations = adaptive_iterations(static_cast<double>(best_count)/n, confidence, max_iterations, sample_size);
 				}
 			}
-			if(inliers.size() < inliers_this_iteration.size()) inliers = inliers_this_iteration;
 		}
-		return inliers;
+		return best_count;
+	}
+
+	/**
+	* @brief preemptive RANSAC (Nister, "Preemptive RANSAC for live structure and motion estimation")
+	*
+	* max_iterations hypotheses are generated up front and scored on blocks of randomly ordered points.
+	* After each block only the better half of the hypotheses is kept, until one hypothesis is left or all points are scored
+	*
+	* @return returns inlier count of the best plane, coefficients are stored in best_coefs
+	*/
+	int preemptive_ransac(int max_iterations, T dist_thresh, Point<4, T>& best_coefs)
+	{
+		int n = _x.size();
+		std::mt19937 gen(_seed);
+
+		// random order of points, so that each block is a random subset of the pointcloud
+		std::vector<int> order(n);
+		for(int i=0; i<n; ++i) order[i] = i;
+		std::shuffle(order.begin(), order.end(), gen);
+		std::vector<T> px(n), py(n), pz(n);
+		for(int i=0; i<n; ++i)
+		{
+			px[i] = _x[order[i]];
+			py[i] = _y[order[i]];
+			pz[i] = _z[order[i]];
+		}
+
+		// generate hypotheses
+		std::vector< Point<4, T> > hypotheses;
+		hypotheses.reserve(max_iterations);
+		for(int i=0; i<max_iterations; ++i)
+		{
+			Point<4, T> coefs;
+			if(sample_plane(gen, coefs)) hypotheses.push_back(coefs);
+		}
+		_num_iterations = max_iterations;
+		int m = hypotheses.size();
+		if(m==0) return 0;
+
+		std::vector<int> scores(m, 0);
+		std::vector<int> alive(m);
+		for(int i=0; i<m; ++i) alive[i] = i;
+		int block_size = std::max(1, _preemptive_block_size);
+		for(int begin=0; begin<n && alive.size()>1; begin+=block_size)
+		{
+			int end = std::min(n, begin+block_size);
+			int num_alive = alive.size();
+			#pragma omp parallel for schedule(static)
+			for(int k=0; k<num_alive; ++k) scores[alive[k]] += count_inliers(hypotheses[alive[k]], dist_thresh, px.data(), py.data(), pz.data(), begin, end);
+			// keep the better half
+			int keep = std::max(1, num_alive/2);
+			std::nth_element(alive.begin(), alive.begin()+keep-1, alive.end(), [&scores](int a, int b){
+				if(scores[a]==scores[b]) return a<b;
+				return scores[a]>scores[b];
+			});
+			alive.resize(keep);
+		}
+		int best = *std::min_element(alive.begin(), alive.end(), [&scores](int a, int b){
+			if(scores[a]==scores[b]) return a<b;
+			return scores[a]>scores[b];
+		});
+		best_coefs = hypotheses[best];
+		return count_inliers(best_coefs, dist_thresh);
 	}
 };
 
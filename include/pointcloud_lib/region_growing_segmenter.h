@@ -0,0 +1,168 @@
+#ifndef __REGION_GROWING_SEGMENTER_H__
+#define __REGION_GROWING_SEGMENTER_H__
+
+#include "pointcloud_lib/normal_estimator.h"
+#include "common/radix_sort.h"
+#include <cstring>
+#include <limits>
+
+/**
+* @brief Normal based region growing segmenter
+*
+* Segments a pointcloud into smooth surfaces. Points are visited in order of increasing curvature, every unlabelled point
+* starts a new region which grows to neighbors whose normals are within `angle_thresh` of the normal of the current point.
+* Only neighbors with curvature below `curvature_thresh` are used to grow the region further.
+* A single NeighborhoodGraph is built per pointcloud, and is used both for normal estimation and for growing, so the KDTree is
+* queried once per point. Seeds are ordered with a radix sort, so apart from building the graph segmentation is linear in number of points
+*/
+template<class T>
+class RegionGrowingSegmenter
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param search_radius radius of the neighborhoods used for normals and growing
+	* @param angle_thresh maximum angle (in radians) between normals of neighboring points in a region
+	* @param curvature_thresh maximum curvature of a point to continue growing from it
+	*/
+	RegionGrowingSegmenter(double search_radius=0.3, double angle_thresh=0.1, double curvature_thresh=0.05):
+		_search_radius(search_radius), _angle_thresh(angle_thresh), _curvature_thresh(curvature_thresh),
+		_min_region_size(1), _max_region_size(std::numeric_limits<int>::max()) {}
+
+	/// @brief set maximum angle (in radians) between normals of neighboring points in a region
+	void set_angle_thresh(double angle_thresh)
+	{
+		_angle_thresh = angle_thresh;
+	}
+
+	/// @brief set maximum curvature of a point to continue growing from it
+	void set_curvature_thresh(double curvature_thresh)
+	{
+		_curvature_thresh = curvature_thresh;
+	}
+
+	/// @brief set minimum and maximum number of points in a region
+	void set_region_size(int min_region_size, int max_region_size)
+	{
+		_min_region_size = min_region_size;
+		_max_region_size = max_region_size;
+	}
+
+	/**
+	* @brief segment a pointcloud represented as vector of points into smooth regions
+	*
+	* @param pointvec vector of points
+	* @param labels computed region index of every point, -1 if the point is not part of a region within the size limits
+	* @return returns number of regions
+	*/
+	int segment(std::vector< Point<3, T> >& pointvec, std::vector<int>& labels)
+	{
+		_graph.build(pointvec, _search_radius);
+		NormalEstimator<3, T> ne;
+		ne.set_pointcloud(pointvec);
+		ne.set_neighborhood_graph(&_graph);
+		const GeometricFeatures<T>& features = ne.get_features(_search_radius);
+		std::vector< Point<3, T> > normalvec = ne.get_normals(_search_radius);
+		return segment(normalvec, features.curvature, _graph, labels);
+	}
+
+	/**
+	* @overload
+	*
+	* segments using precomputed normals, curvatures and neighborhood graph
+	*
+	* @param normalvec unit normal of every point, zero vector if normal is not defined
+	* @param curvature curvature of every point
+	* @param graph neighborhood graph of the points
+	*/
+	int segment(std::vector< Point<3, T> >& normalvec, const std::vector<T>& curvature, const NeighborhoodGraph<3, T>& graph, std::vector<int>& labels)
+	{
+		int n = normalvec.size();
+		labels.assign(n, -1);
+
+		// contiguous normals
+		std::vector<T> nx(n), ny(n), nz(n);
+		std::vector<char> has_normal(n);
+		for(int i=0; i<n; ++i)
+		{
+			nx[i] = normalvec[i][0];
+			ny[i] = normalvec[i][1];
+			nz[i] = normalvec[i][2];
+			has_normal[i] = (nx[i]!=0 || ny[i]!=0 || nz[i]!=0);
+		}
+
+		// seed order by increasing curvature, bit patterns of non-negative floats sort like the floats
+		std::vector<uint64_t> keys(n);
+		for(int i=0; i<n; ++i)
+		{
+			float c = std::max(0.0f, static_cast<float>(curvature[i]));
+			uint32_t bits;
+			std::memcpy(&bits, &c, sizeof(bits));
+			keys[i] = bits;
+		}
+		std::vector<int> order;
+		radix_sort(keys, order, 32);
+
+		T cos_thresh = std::cos(_angle_thresh);
+		std::vector<int> queue;
+		std::vector<int> region_sizes;
+		for(int seed: order)
+		{
+			if(labels[seed]!=-1 || !has_normal[seed]) continue;
+			int label = region_sizes.size();
+			labels[seed] = label;
+			queue.clear();
+			queue.push_back(seed);
+			int size = 1;
+			for(int q=0; q<queue.size(); ++q)
+			{
+				int i = queue[q];
+				for(const int* it=graph.neighbors_begin(i); it!=graph.neighbors_end(i); ++it)
+				{
+					int j = *it;
+					if(labels[j]!=-1 || !has_normal[j]) continue;
+					// normals have consistent orientation only up to sign
+					if(std::abs(nx[i]*nx[j] + ny[i]*ny[j] + nz[i]*nz[j]) < cos_thresh) continue;
+					labels[j] = label;
+					++size;
+					if(curvature[j] < _curvature_thresh) queue.push_back(j);
+				}
+			}
+			region_sizes.push_back(size);
+		}
+
+		// discard regions outside size limits and renumber remaining ones
+		std::vector<int> new_label(region_sizes.size(), -1);
+		int nregions = 0;
+		for(int r=0; r<region_sizes.size(); ++r)
+		{
+			if(region_sizes[r] >= _min_region_size && region_sizes[r] <= _max_region_size) new_label[r] = nregions++;
+		}
+		for(int i=0; i<n; ++i) if(labels[i]!=-1) labels[i] = new_label[labels[i]];
+		return nregions;
+	}
+
+private:
+	/// @brief radius of neighborhoods
+	double _search_radius;
+
+	/// @brief maximum angle between normals in a region
+	double _angle_thresh;
+
+	/// @brief maximum curvature of a point to grow from it
+	double _curvature_thresh;
+
+	/// @brief minimum number of points in a region
+	int _min_region_size;
+
+	/// @brief maximum number of points in a region
+	int _max_region_size;
+
+	/// @brief neighborhood graph, kept to reuse its buffers across frames
+	NeighborhoodGraph<3, T> _graph;
+};
+
+#endif
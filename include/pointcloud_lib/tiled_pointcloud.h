@@ -0,0 +1,521 @@
+#ifndef __TILED_POINTCLOUD_H__
+#define __TILED_POINTCLOUD_H__
+
+#include "pointcloud_lib/normal_estimator.h"
+#include "pointcloud_lib/outlier_filter.h"
+#include <array>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <unordered_map>
+
+/**
+* @brief Out-of-core pointcloud split into square spatial tiles on disk
+*
+* Space is divided in xy into square tiles of size `tile_size`. Every point is stored as a core point of the tile containing it
+* and as a margin point of every other tile whose box expanded by `margin` contains it, so a tile loaded alone has all points
+* within `margin` (in xy) of its core points. Algorithms with a neighborhood radius up to `margin` therefore give the same result
+* for core points of a tile as on the whole pointcloud, and every point is processed exactly once as a core point.
+*
+* Points are streamed in with `add_points`, and are buffered in memory up to a budget before being appended to the tile files.
+* `finalize` recursively splits tiles into quadrants until every tile (core and margin points) fits in the memory limit,
+* and writes an index file so the tiles can be reopened later with `open`. Tiles are fixed after `finalize` or `open`, points can
+* only be added again after `clear`.
+* Every tile is stored as two files `<prefix>_<file id>_core.bin` and `<prefix>_<file id>_margin.bin` of records
+* {x, y, z, id}, where id is the index of the point in the order points were added
+*/
+template<class T>
+class TiledPointCloud
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/// @brief on-disk point record
+	struct Record
+	{
+		T xyz[3];
+		uint64_t id;
+	};
+
+	/// @brief square tile with lower left corner (x0, y0)
+	struct Tile
+	{
+		int file_id;
+		double x0, y0, size;
+		uint64_t num_core, num_margin;
+	};
+
+	/**
+	* @brief approximate peak memory in bytes per point while a tile is processed (points, KDTree nodes and results),
+	* used to convert the memory limit to a maximum number of points per tile. This is an estimate of the per-tile working
+	* set, not an enforced cap
+	*/
+	static const size_t bytes_per_point = 512;
+
+	/**
+	* @brief Constructor
+	*
+	* @param prefix path prefix of the tile and index files
+	* @param tile_size size of the initial tiles, tiles are split into smaller ones if they exceed the memory limit
+	* @param margin overlap margin around every tile, should be at least the neighborhood radius of the algorithms run on the tiles
+	*/
+	TiledPointCloud(const std::string& prefix, double tile_size=20.0, double margin=1.0):
+		_prefix(prefix), _tile_size(tile_size), _margin(margin), _num_points(0), _next_file_id(0), _num_buffered(0), _finalized(false)
+	{
+		if(tile_size <= 0 || margin < 0 || 2*margin >= tile_size) throw std::domain_error("tile size must be positive and larger than twice the margin");
+		set_memory_limit(1ULL<<30);
+	}
+
+	/**
+	* @brief set memory limit
+	*
+	* while tiling, read chunks and write buffers are kept within the limit. While processing, the limit is converted
+	* to a maximum number of points per tile with `bytes_per_point`, so it is a working set heuristic there
+	*
+	* @param bytes memory limit in bytes
+	*/
+	void set_memory_limit(size_t bytes)
+	{
+		_memory_limit = bytes;
+		_max_tile_points = std::max<size_t>(1, bytes/bytes_per_point);
+		// write buffers get an eighth of the budget, their capacity can be twice their size
+		_max_buffered = std::max<size_t>(1, bytes/8/sizeof(Record));
+		// read chunks get a quarter
+		_max_chunk = std::max<size_t>(1, bytes/4/sizeof(Record));
+	}
+
+	/// @brief maximum number of points (core and margin) of a tile under the memory limit
+	size_t get_max_tile_points()
+	{
+		return _max_tile_points;
+	}
+
+	/**
+	* @brief append points to the tiled pointcloud
+	*
+	* @param pointvec chunk of points, ids continue from the previous chunk
+	* @throws std::logic_error if the tiles were finalized or opened
+	*/
+	void add_points(const std::vector< Point<3, T> >& pointvec)
+	{
+		if(_finalized) throw std::logic_error("points can't be added to finalized tiles, clear them first");
+		for(const Point<3, T>& p: pointvec)
+		{
+			Record r = {{p[0], p[1], p[2]}, _num_points++};
+			long long ix = static_cast<long long>(std::floor(r.xyz[0]/_tile_size));
+			long long iy = static_cast<long long>(std::floor(r.xyz[1]/_tile_size));
+			for(int dx=-1; dx<=1; ++dx)
+			{
+				for(int dy=-1; dy<=1; ++dy)
+				{
+					double x0 = (ix+dx)*_tile_size, y0 = (iy+dy)*_tile_size;
+					bool core = (dx==0 && dy==0);
+					if(!core && !in_box(r, x0, y0, _tile_size, _margin)) continue;
+					int t = grid_tile(ix+dx, iy+dy);
+					append(t, r, core);
+				}
+			}
+			if(_num_buffered > _max_buffered) flush_all();
+		}
+	}
+
+	/**
+	* @brief tile a binary file of float points
+	*
+	* @param binfile file of points stored as consecutive floats, e.g. KITTI velodyne scans with values_per_point=4
+	* @param values_per_point number of floats per point, the first 3 are x, y and z
+	* @param chunk_size maximum number of points read at a time, fewer if a chunk would exceed a quarter of the memory limit
+	*/
+	void build_from_bin(const std::string& binfile, int values_per_point=4, int chunk_size=1<<16)
+	{
+		clear();
+		std::ifstream f(binfile.c_str(), std::ios::binary);
+		if(!f) throw std::runtime_error("could not open "+binfile);
+		size_t chunk_bytes = values_per_point*sizeof(float) + sizeof(Point<3, T>);
+		chunk_size = static_cast<int>(std::max<size_t>(1, std::min<size_t>(chunk_size, _memory_limit/4/chunk_bytes)));
+		std::vector<float> data(static_cast<size_t>(values_per_point)*chunk_size);
+		std::vector< Point<3, T> > chunk;
+		while(true)
+		{
+			f.read((char *)data.data(), data.size()*sizeof(float));
+			int npoints = f.gcount()/(values_per_point*sizeof(float));
+			if(npoints==0) break;
+			chunk.resize(npoints);
+			for(int i=0; i<npoints; ++i) for(int k=0; k<3; ++k) chunk[i][k] = data[static_cast<size_t>(i)*values_per_point+k];
+			add_points(chunk);
+		}
+		finalize();
+	}
+
+	/**
+	* @brief flush buffered points, split tiles exceeding the memory limit and write the index file
+	*
+	* tiles are not split below twice the margin, such tiles may exceed the memory limit
+	*/
+	void finalize()
+	{
+		flush_all();
+		std::deque<int> queue;
+		for(int t=0; t<_tiles.size(); ++t) queue.push_back(t);
+		std::vector<Tile> done;
+		while(!queue.empty())
+		{
+			Tile tile = _tiles[queue.front()];
+			queue.pop_front();
+			if(tile.num_core==0) remove_files(tile);
+			else if(tile.num_core+tile.num_margin <= _max_tile_points || tile.size/2 < 2*_margin) done.push_back(tile);
+			else for(int child: split(tile)) queue.push_back(child);
+		}
+		_tiles = done;
+		_buffers.clear();
+		_grid.clear();
+		_finalized = true;
+		write_index();
+	}
+
+	/**
+	* @brief open tiles written before with the same prefix
+	*
+	* @return returns false if there is no index file with the prefix
+	*/
+	bool open()
+	{
+		std::ifstream f((_prefix+"_index.txt").c_str());
+		if(!f) return false;
+		size_t ntiles;
+		f>>_num_points>>_tile_size>>_margin>>_next_file_id>>ntiles;
+		_tiles.resize(ntiles);
+		for(Tile& tile: _tiles) f>>tile.file_id>>tile.x0>>tile.y0>>tile.size>>tile.num_core>>tile.num_margin;
+		_buffers.clear();
+		_grid.clear();
+		_finalized = true;
+		return static_cast<bool>(f);
+	}
+
+	/// @brief remove all tile files and the index file
+	void clear()
+	{
+		for(const Tile& tile: _tiles) remove_files(tile);
+		std::remove((_prefix+"_index.txt").c_str());
+		_tiles.clear();
+		_buffers.clear();
+		_grid.clear();
+		_num_points = 0;
+		_next_file_id = 0;
+		_num_buffered = 0;
+		_finalized = false;
+	}
+
+	/// @brief number of points
+	uint64_t size()
+	{
+		return _num_points;
+	}
+
+	/// @brief overlap margin
+	double get_margin()
+	{
+		return _margin;
+	}
+
+	/// @brief number of tiles
+	int num_tiles()
+	{
+		return _tiles.size();
+	}
+
+	/// @brief \f$t^{th}\f$ tile
+	const Tile& tile(int t)
+	{
+		return _tiles[t];
+	}
+
+	/**
+	* @brief load points of a tile
+	*
+	* @param t tile index
+	* @param pointvec loaded points, the first `tile(t).num_core` points are the core points followed by the margin points
+	* @param ids loaded point ids
+	*/
+	void load_tile(int t, std::vector< Point<3, T> >& pointvec, std::vector<uint64_t>& ids)
+	{
+		const Tile& tile = _tiles[t];
+		pointvec.resize(tile.num_core+tile.num_margin);
+		ids.resize(pointvec.size());
+		std::vector<Record> records;
+		size_t offset = 0;
+		for(bool core: {true, false})
+		{
+			read_records(file_name(tile, core), records);
+			for(const Record& r: records)
+			{
+				for(int k=0; k<3; ++k) pointvec[offset][k] = r.xyz[k];
+				ids[offset++] = r.id;
+			}
+		}
+	}
+
+private:
+	/// @brief path prefix of tile files
+	std::string _prefix;
+
+	/// @brief initial tile size
+	double _tile_size;
+
+	/// @brief overlap margin
+	double _margin;
+
+	/// @brief number of points added
+	uint64_t _num_points;
+
+	/// @brief next unused file id
+	int _next_file_id;
+
+	/// @brief maximum number of points of a tile
+	size_t _max_tile_points;
+
+	/// @brief memory limit in bytes
+	size_t _memory_limit;
+
+	/// @brief maximum number of buffered records before flushing
+	size_t _max_buffered;
+
+	/// @brief maximum number of records read at a time while splitting
+	size_t _max_chunk;
+
+	/// @brief number of buffered records
+	size_t _num_buffered;
+
+	/// @brief whether tiles were finalized or opened, the initial grid and write buffers are gone then
+	bool _finalized;
+
+	/// @brief tiles
+	std::vector<Tile> _tiles;
+
+	/// @brief write buffers of core and margin records, indexed by tile
+	std::vector< std::array<std::vector<Record>, 2> > _buffers;
+
+	/// @brief tile index of initial grid tiles while adding points
+	std::unordered_map<uint64_t, int> _grid;
+
+	/// @brief check if a record is in a tile box expanded by margin
+	static bool in_box(const Record& r, double x0, double y0, double size, double margin)
+	{
+		return r.xyz[0] >= x0-margin && r.xyz[0] < x0+size+margin && r.xyz[1] >= y0-margin && r.xyz[1] < y0+size+margin;
+	}
+
+	/// @brief index of the initial grid tile (ix, iy), created if it doesn't exist
+	int grid_tile(long long ix, long long iy)
+	{
+		uint64_t key = (static_cast<uint64_t>(ix+(1LL<<31))<<32) | static_cast<uint32_t>(iy+(1LL<<31));
+		auto it = _grid.find(key);
+		if(it!=_grid.end()) return it->second;
+		int t = new_tile(ix*_tile_size, iy*_tile_size, _tile_size);
+		_grid[key] = t;
+		return t;
+	}
+
+	/// @brief create an empty tile
+	int new_tile(double x0, double y0, double size)
+	{
+		Tile tile = {_next_file_id++, x0, y0, size, 0, 0};
+		_tiles.push_back(tile);
+		_buffers.emplace_back();
+		// truncate leftovers of an earlier run with the same prefix
+		for(bool core: {true, false}) std::ofstream(file_name(tile, core).c_str(), std::ios::binary | std::ios::trunc);
+		return _tiles.size()-1;
+	}
+
+	/// @brief buffer a record of a tile
+	void append(int t, const Record& r, bool core)
+	{
+		_buffers[t][core?0:1].push_back(r);
+		if(core) ++_tiles[t].num_core;
+		else ++_tiles[t].num_margin;
+		++_num_buffered;
+	}
+
+	/// @brief append all buffered records to tile files
+	void flush_all()
+	{
+		for(int t=0; t<_buffers.size(); ++t)
+		{
+			for(int c=0; c<2; ++c)
+			{
+				std::vector<Record>& buf = _buffers[t][c];
+				if(buf.empty()) continue;
+				std::ofstream f(file_name(_tiles[t], c==0).c_str(), std::ios::binary | std::ios::app);
+				f.write((char *)buf.data(), buf.size()*sizeof(Record));
+				// release memory, not only clear
+				std::vector<Record>().swap(buf);
+			}
+		}
+		_num_buffered = 0;
+	}
+
+	/**
+	* @brief split a tile into quadrants, streaming its files in chunks
+	*
+	* the expanded box of a quadrant is inside the expanded box of the tile, so its core and margin points are all in the tile files
+	*
+	* @return returns indices of the quadrant tiles
+	*/
+	std::vector<int> split(const Tile& tile)
+	{
+		double half = tile.size/2;
+		std::vector<int> children;
+		for(int q=0; q<4; ++q) children.push_back(new_tile(tile.x0+(q&1)*half, tile.y0+(q>>1)*half, half));
+		std::vector<Record> records;
+		for(bool core: {true, false})
+		{
+			std::ifstream f(file_name(tile, core).c_str(), std::ios::binary);
+			while(read_chunk(f, records))
+			{
+				for(const Record& r: records)
+				{
+					// quadrant of a core point is chosen by comparison with the tile center, so it has exactly one
+					int core_child = core?(r.xyz[0] >= tile.x0+half) + 2*(r.xyz[1] >= tile.y0+half):-1;
+					for(int q=0; q<4; ++q)
+					{
+						const Tile& child = _tiles[children[q]];
+						if(q==core_child || in_box(r, child.x0, child.y0, child.size, _margin)) append(children[q], r, q==core_child);
+					}
+				}
+				if(_num_buffered > _max_buffered) flush_all();
+			}
+		}
+		flush_all();
+		remove_files(tile);
+		return children;
+	}
+
+	/// @brief read the next chunk of records of a file, returns false at end of file
+	bool read_chunk(std::ifstream& f, std::vector<Record>& records)
+	{
+		records.resize(std::min<size_t>(_max_chunk, 1<<16));
+		f.read((char *)records.data(), records.size()*sizeof(Record));
+		records.resize(f.gcount()/sizeof(Record));
+		return !records.empty();
+	}
+
+	/// @brief read all records of a file
+	void read_records(const std::string& filename, std::vector<Record>& records)
+	{
+		std::ifstream f(filename.c_str(), std::ios::binary | std::ios::ate);
+		records.resize(static_cast<size_t>(f.tellg())/sizeof(Record));
+		f.seekg(0);
+		f.read((char *)records.data(), records.size()*sizeof(Record));
+	}
+
+	/// @brief name of core or margin file of a tile
+	std::string file_name(const Tile& tile, bool core)
+	{
+		return _prefix+"_"+std::to_string(tile.file_id)+(core?"_core.bin":"_margin.bin");
+	}
+
+	void remove_files(const Tile& tile)
+	{
+		for(bool core: {true, false}) std::remove(file_name(tile, core).c_str());
+	}
+
+	void write_index()
+	{
+		std::ofstream f((_prefix+"_index.txt").c_str());
+		f.precision(17);
+		f<<_num_points<<" "<<_tile_size<<" "<<_margin<<" "<<_next_file_id<<" "<<_tiles.size()<<"\n";
+		for(const Tile& tile: _tiles)
+		{
+			f<<tile.file_id<<" "<<tile.x0<<" "<<tile.y0<<" "<<tile.size<<" "<<tile.num_core<<" "<<tile.num_margin<<"\n";
+		}
+	}
+};
+
+/**
+* @brief stream tiles through a per-tile function and stitch the results of core points into a file
+*
+* tiles are processed one at a time, so peak memory is bounded by the largest tile; the function itself may run in parallel.
+* The output file holds one `Result` per point in id order, every point is written once, from the tile where it is a core point
+*
+* @param cloud tiled pointcloud
+* @param outfile output file
+* @param func function called as `func(pointvec, num_core, results)` with the points of a tile (core points first),
+* it must fill `results` (already sized `num_core`) with the results of the core points
+*/
+template<class Result, class T, class Func>
+void process_tiles(TiledPointCloud<T>& cloud, const std::string& outfile, Func func)
+{
+	static_assert(std::is_trivially_copyable<Result>::value, "results are written as raw bytes");
+	{
+		// allocate the output file
+		std::ofstream f(outfile.c_str(), std::ios::binary | std::ios::trunc);
+		Result zero = Result();
+		if(cloud.size() > 0)
+		{
+			f.seekp((cloud.size()-1)*sizeof(Result));
+			f.write((char *)&zero, sizeof(Result));
+		}
+	}
+	std::fstream f(outfile.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+	std::vector< Point<3, T> > pointvec;
+	std::vector<uint64_t> ids;
+	std::vector<Result> results;
+	for(int t=0; t<cloud.num_tiles(); ++t)
+	{
+		cloud.load_tile(t, pointvec, ids);
+		int num_core = cloud.tile(t).num_core;
+		results.assign(num_core, Result());
+		func(pointvec, num_core, results);
+		// write runs of consecutive ids at once
+		for(int i=0; i<num_core; )
+		{
+			int j = i+1;
+			while(j<num_core && ids[j]==ids[j-1]+1) ++j;
+			f.seekp(ids[i]*sizeof(Result));
+			f.write((char *)&results[i], (j-i)*sizeof(Result));
+			i = j;
+		}
+	}
+}
+
+/**
+* @brief estimate normals of a tiled pointcloud
+*
+* @param cloud tiled pointcloud, its margin must be at least `search_radius`
+* @param search_radius radius to get neighborhood points
+* @param outfile output file of 3 values of type T per point, in id order
+*/
+template<class T>
+void estimate_normals_tiled(TiledPointCloud<T>& cloud, double search_radius, const std::string& outfile)
+{
+	if(search_radius > cloud.get_margin()) throw std::domain_error("search radius larger than tile margin");
+	process_tiles< std::array<T, 3> >(cloud, outfile, [search_radius](std::vector< Point<3, T> >& pointvec, int num_core, std::vector< std::array<T, 3> >& results)
+	{
+		NormalEstimator<3, T> ne;
+		ne.set_pointcloud(pointvec);
+		std::vector< Point<3, T> > normalvec = ne.get_normals(search_radius);
+		for(int i=0; i<num_core; ++i) for(int k=0; k<3; ++k) results[i][k] = normalvec[i][k];
+	});
+}
+
+/**
+* @brief radius outlier filter of a tiled pointcloud
+*
+* @param cloud tiled pointcloud, its margin must be at least `radius`
+* @param radius search radius
+* @param min_neighbors minimum number of neighbors within radius of an inlier
+* @param outfile output keep mask file, one byte per point in id order
+*/
+template<class T>
+void radius_outlier_filter_tiled(TiledPointCloud<T>& cloud, double radius, int min_neighbors, const std::string& outfile)
+{
+	if(radius > cloud.get_margin()) throw std::domain_error("search radius larger than tile margin");
+	process_tiles<char>(cloud, outfile, [radius, min_neighbors](std::vector< Point<3, T> >& pointvec, int num_core, std::vector<char>& results)
+	{
+		RadiusOutlierFilter<T> filter(radius, min_neighbors);
+		std::vector<char> keep;
+		filter.filter(pointvec, keep);
+		std::copy(keep.begin(), keep.begin()+num_core, results.begin());
+	});
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef __VOXEL_GRID_FILTER_H__
+#define __VOXEL_GRID_FILTER_H__
+
+#include "data_structures/point_types.h"
+#include "common/parallel_utils.h"
+#include "common/radix_sort.h"
+#include <limits>
+
+/**
+* @brief Voxel grid filter to downsample a pointcloud
+*
+* Space is divided into cubic voxels of size `leaf_size`, and every occupied voxel is replaced by a single point, either the
+* centroid of the points in the voxel or the point in the voxel closest to that centroid.
+* Points are grouped by sorting 64 bit voxel keys (21 bits per dimension) with a parallel radix sort, so filtering runs in O(n)
+*/
+template<class T>
+class VoxelGridFilter
+{
+	// currently only support points with float and double values
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "only supports float and double points");
+public:
+	/**
+	* @brief Constructor
+	*
+	* @param leaf_size voxel size
+	*/
+	VoxelGridFilter(double leaf_size=0.1): _leaf_size(leaf_size), _use_centroid(true) {}
+
+	/// @brief set voxel size
+	void set_leaf_size(double leaf_size)
+	{
+		_leaf_size = leaf_size;
+	}
+
+	/**
+	* @brief select representative point of a voxel
+	*
+	* @param use_centroid if true (default) centroid of the points in a voxel is used, else the input point closest to the centroid is used
+	*/
+	void set_use_centroid(bool use_centroid)
+	{
+		_use_centroid = use_centroid;
+	}
+
+	/**
+	* @brief downsample pointcloud
+	*
+	* @param pointvec vector of points
+	* @return returns vector of points with one point per occupied voxel
+	*/
+	std::vector< Point<3, T> > filter(std::vector< Point<3, T> >& pointvec)
+	{
+		std::vector<int> point_to_voxel;
+		return filter(pointvec, point_to_voxel);
+	}
+
+	/**
+	* @overload
+	*
+	* @param point_to_voxel index of the output point (voxel) for every input point,
+	* can be used to map results computed on the downsampled pointcloud back to the input pointcloud
+	*/
+	std::vector< Point<3, T> > filter(std::vector< Point<3, T> >& pointvec, std::vector<int>& point_to_voxel)
+	{
+		int n = pointvec.size();
+		point_to_voxel.assign(n, -1);
+		if(n==0) return std::vector< Point<3, T> >();
+		if(_leaf_size <= 0) throw std::domain_error("leaf size must be positive");
+
+		// contiguous coordinates and bounds
+		std::vector<T> x(n), y(n), z(n);
+		T min_x = std::numeric_limits<T>::max(), min_y = min_x, min_z = min_x;
+		T max_x = std::numeric_limits<T>::lowest(), max_y = max_x, max_z = max_x;
+		for(int i=0; i<n; ++i)
+		{
+			x[i] = pointvec[i][0];
+			y[i] = pointvec[i][1];
+			z[i] = pointvec[i][2];
+			min_x = std::min(min_x, x[i]); max_x = std::max(max_x, x[i]);
+			min_y = std::min(min_y, y[i]); max_y = std::max(max_y, y[i]);
+			min_z = std::min(min_z, z[i]); max_z = std::max(max_z, z[i]);
+		}
+		const uint64_t max_cells = (1<<21);
+		if((max_x-min_x)/_leaf_size >= max_cells || (max_y-min_y)/_leaf_size >= max_cells || (max_z-min_z)/_leaf_size >= max_cells)
+			throw std::domain_error("leaf size too small for the extent of the pointcloud");
+
+		// voxel key per point, 21 bits per dimension
+		std::vector<uint64_t> keys(n);
+		double inv_leaf = 1.0/_leaf_size;
+		#pragma omp parallel for schedule(static)
+		for(int i=0; i<n; ++i)
+		{
+			uint64_t ix = static_cast<uint64_t>((x[i]-min_x)*inv_leaf);
+			uint64_t iy = static_cast<uint64_t>((y[i]-min_y)*inv_leaf);
+			uint64_t iz = static_cast<uint64_t>((z[i]-min_z)*inv_leaf);
+			keys[i] = (ix<<42) | (iy<<21) | iz;
+		}
+		std::vector<int> order;
+		radix_sort(keys, order, 63);
+
+		// start of each run of equal keys in sorted order is a voxel
+		std::vector<int> voxel_start;
+		for(int i=0; i<n; ++i)
+		{
+			if(i==0 || keys[order[i]]!=keys[order[i-1]]) voxel_start.push_back(i);
+		}
+		int nvoxels = voxel_start.size();
+		voxel_start.push_back(n);
+
+		std::vector< Point<3, T> > voxel_points(nvoxels);
+		#pragma omp parallel for schedule(static)
+		for(int v=0; v<nvoxels; ++v)
+		{
+			double cx = 0.0, cy = 0.0, cz = 0.0;
+			for(int k=voxel_start[v]; k<voxel_start[v+1]; ++k)
+			{
+				int i = order[k];
+				cx += x[i];
+				cy += y[i];
+				cz += z[i];
+				point_to_voxel[i] = v;
+			}
+			int count = voxel_start[v+1]-voxel_start[v];
+			cx /= count;
+			cy /= count;
+			cz /= count;
+			Point<3, T>& p = voxel_points[v];
+			if(_use_centroid)
+			{
+				p[0] = cx;
+				p[1] = cy;
+				p[2] = cz;
+			}
+			else
+			{
+				int best = order[voxel_start[v]];
+				double best_dist = std::numeric_limits<double>::max();
+				for(int k=voxel_start[v]; k<voxel_start[v+1]; ++k)
+				{
+					int i = order[k];
+					double dist = (x[i]-cx)*(x[i]-cx) + (y[i]-cy)*(y[i]-cy) + (z[i]-cz)*(z[i]-cz);
+					if(dist < best_dist)
+					{
+						best_dist = dist;
+						best = i;
+					}
+				}
+				p = pointvec[best];
+			}
+		}
+		return voxel_points;
+	}
+
+private:
+	/// @brief voxel size
+	double _leaf_size;
+
+	/// @brief use centroid of points in a voxel as the output point
+	bool _use_centroid;
+};
+
+#endif
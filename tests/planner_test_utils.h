@@ -0,0 +1,52 @@
+#ifndef __PLANNER_TEST_UTILS_H__
+#define __PLANNER_TEST_UTILS_H__
+
+#include "planning_lib/occupancy_grid2d.h"
+#include <vector>
+#include <random>
+#include <cassert>
+#include <cmath>
+
+/// @brief free map with random rectangular obstacles, scattered single cell obstacles and an occupied border
+inline std::vector<int> synthetic_cells(int width, int height, int nobstacles, int seed, int nscattered=0)
+{
+	std::mt19937 gen(seed);
+	std::vector<int> cells(width*height, 0);
+	std::uniform_int_distribution<> row(0, height-1), col(0, width-1), extent(5, 60);
+	for(int k=0; k<nobstacles; ++k)
+	{
+		int i0 = row(gen), j0 = col(gen), h = extent(gen), w = extent(gen);
+		for(int i=i0; i<std::min(height, i0+h); ++i) for(int j=j0; j<std::min(width, j0+w); ++j) cells[i*width+j] = 100;
+	}
+	for(int k=0; k<nscattered; ++k) cells[row(gen)*width+col(gen)] = 100;
+	for(int i=0; i<height; ++i) for(int j=0; j<width; ++j) if(i==0 || j==0 || i==height-1 || j==width-1) cells[i*width+j] = 100;
+	return cells;
+}
+
+/**
+* @brief path cost with the step costs of `AstarPlanner2d`, checking that consecutive waypoints are neighboring traversable cells
+*
+* @param clearance_scale clearance weight over 253, 0 for the path length in cells
+*/
+inline float path_cost(OccupancyGrid2d& map, std::vector<Point2f>& path, float clearance_scale=0)
+{
+	float cost = 0;
+	int pi = -1, pj = -1;
+	for(auto& point: path)
+	{
+		int i, j;
+		map.xy_to_ij(point[0]+0.5*map.get_resolution(), point[1]+0.5*map.get_resolution(), i, j);
+		assert(map.is_traversable(i, j));
+		if(pi >= 0)
+		{
+			assert(std::abs(i-pi)<=1 && std::abs(j-pj)<=1 && (i!=pi || j!=pj));
+			float step = (i!=pi && j!=pj)?1.41421356f:1.0f;
+			cost += (clearance_scale > 0)?step*(1 + clearance_scale*map.cost(i, j)):step;
+		}
+		pi = i;
+		pj = j;
+	}
+	return cost;
+}
+
+#endif
@@ -1,99 +1,314 @@
 #include "planning_lib/astar_planner.h"
+#include "planning_lib/bidirectional_astar_planner.h"
+#include "planning_lib/map_loader.h"
+#include "planner_test_utils.h"
 #include <iostream>
 #include <chrono>
 #include <fstream>
-#include <sstream>
+#include <cassert>
+#include <limits>
+#include <queue>
+#include <random>
 
-struct Map_Data
+void save_path_as_bin(std::vector<Point2f>& path, std::string outfile)
 {
-	std::vector<unsigned char> data;
-	int width;
-	int height;
-	int max_val;
-};
+	std::ofstream f(outfile.c_str(), std::ios::binary);
+
+	float* data = new float[2];
+	for(auto point: path)
+	{
+		for(int i=0; i<2; ++i) data[i] = point[i];
+		f.write((char *)data, 2*sizeof(float));
+	}
+	delete[] data;
+	f.close();
+}
 
-Map_Data read_pgm(std::string mapfile)
+void test_astar()
 {
-	Map_Data map_data;
+	OccupancyGrid2d map;
+	auto start_t = std::chrono::high_resolution_clock::now();
+	if(!load_map("../data/map.yaml", map))
+	{
+		std::cout<<"\tcould not load ../data/map.yaml"<<std::endl;
+		return;
+	}
+	auto end_t = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end_t-start_t;
+	std::cout<<"\tmap load time: "<<duration.count()<<"s"<<std::endl;
 
-	std::ifstream f(mapfile.c_str(), std::ios::binary);
-	std::stringstream ss;
-	std::string line = "";
+	AstarPlanner2d planner;
+	planner.set_map(std::move(map));
 
-	getline(f, line);
-	// std::cout<<line<<std::endl;
+	Point2f start({11.0, -9.4});
+	Point2f goal({7.0, -5.4});
+	start_t = std::chrono::high_resolution_clock::now();
+	auto path = planner.compute_plan(start, goal);
+	end_t = std::chrono::high_resolution_clock::now();
+	duration = end_t-start_t;
+	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
 
-	getline(f, line);
-	// std::cout<<line<<std::endl;
+	save_path_as_bin(path, "../data/map_path.bin");
+}
 
-	ss << f.rdbuf();
-	ss >> map_data.width >> map_data.height >> map_data.max_val;
-	
-	map_data.data.resize(map_data.width*map_data.height);
-	for(int i=0; i<map_data.height; ++i)
+/// @brief smallest distance to an obstacle along a path
+float path_clearance(OccupancyGrid2d& map, std::vector<Point2f>& path)
+{
+	float clearance = std::numeric_limits<float>::infinity();
+	for(auto& point: path)
 	{
-		for(int j=0; j<map_data.width; ++j)
-		{
-			ss >> map_data.data[i*map_data.width+j];
-		}
+		int i, j;
+		bool inside = map.xy_to_ij(point[0], point[1], i, j);
+		assert(inside);
+		clearance = std::min(clearance, map.distance(i, j));
 	}
+	return clearance;
+}
+
+void test_astar_inflation()
+{
+	std::cout<<"A* with inflation layer - synthetic 200x200 map, wall with a 1m gap"<<std::endl;
+	int width = 200, height = 200;
+	std::vector<int> cells(width*height, 0);
+	for(int j=0; j<width; ++j) if(j<90 || j>=110) for(int i=98; i<102; ++i) cells[i*width+j] = 100;
+
+	AstarPlanner2d planner;
+	planner.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	float robot_radius = 0.3;
+	auto start_t = std::chrono::high_resolution_clock::now();
+	planner.get_map().set_inflation(robot_radius, 1.0, 5.0);
+	auto end_t = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end_t-start_t;
+	std::cout<<"\tinflation time: "<<duration.count()<<"s"<<std::endl;
+
+	Point2f start({2.5, 1.0});
+	Point2f goal({7.5, 1.0});
+	auto path = planner.compute_plan(start, goal);
+	assert(!path.empty());
+	float clearance = path_clearance(planner.get_map(), path);
+	std::cout<<"\tpath with inflation: "<<path.size()<<" cells, clearance "<<clearance<<"m"<<std::endl;
+	assert(clearance >= robot_radius);
 
-	return map_data;
+	planner.set_clearance_weight(5.0);
+	start_t = std::chrono::high_resolution_clock::now();
+	auto safe_path = planner.compute_plan(start, goal);
+	end_t = std::chrono::high_resolution_clock::now();
+	duration = end_t-start_t;
+	assert(!safe_path.empty());
+	float safe_clearance = path_clearance(planner.get_map(), safe_path);
+	std::cout<<"\tpath with clearance cost: "<<safe_path.size()<<" cells, clearance "<<safe_clearance<<"m, compute time: "
+		<<duration.count()<<"s"<<std::endl;
+	assert(safe_clearance >= clearance);
+
+	// a robot wider than the gap has no path
+	planner.get_map().set_inflation(0.6, 1.0);
+	assert(planner.compute_plan(start, goal).empty());
 }
 
-std::vector<int> raw_pgm_to_occupancy_data(Map_Data& map_data, float occupied_thresh, float free_thresh)
+/// @brief shortest 8-connected path length in cells from Dijkstra's algorithm, -1 if there is no path
+float dijkstra_cost(std::vector<int>& cells, int width, int height, int start, int goal)
 {
-	std::vector<int> occ_data(map_data.width*map_data.height, -1);
-	for(int i=0; i<map_data.height; ++i)
+	std::vector<float> dist(cells.size(), std::numeric_limits<float>::infinity());
+	typedef std::pair<float, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > pq;
+	dist[start] = 0;
+	pq.push(Entry(0, start));
+	while(!pq.empty())
 	{
-		for(int j=0; j<map_data.width; ++j)
+		Entry cur = pq.top();
+		pq.pop();
+		if(cur.first > dist[cur.second]) continue;
+		if(cur.second==goal) return cur.first;
+		int ci = cur.second/width, cj = cur.second%width;
+		for(int di=-1; di<=1; ++di)
 		{
-			float prob = float(255-int(map_data.data[i*map_data.width+j]))/255.0;
-			if(prob > occupied_thresh) occ_data[i*map_data.width+j] = 100;
-			else if(prob < free_thresh) occ_data[i*map_data.width+j] = 0;
+			for(int dj=-1; dj<=1; ++dj)
+			{
+				int ni = ci+di, nj = cj+dj;
+				if((di==0 && dj==0) || ni<0 || nj<0 || ni>=height || nj>=width || cells[ni*width+nj]!=0) continue;
+				float d = cur.first + ((di!=0 && dj!=0)?1.41421356f:1.0f);
+				if(d < dist[ni*width+nj])
+				{
+					dist[ni*width+nj] = d;
+					pq.push(Entry(d, ni*width+nj));
+				}
+			}
 		}
 	}
-	return occ_data;
+	return -1;
 }
 
-void save_path_as_bin(std::vector<Point2f>& path, std::string outfile)
+/// @brief random pairs of free cells
+std::vector< std::pair<int, int> > random_free_pairs(std::vector<int>& cells, int npairs, int seed)
 {
-	std::ofstream f(outfile.c_str(), std::ios::binary);
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<> cell(0, cells.size()-1);
+	std::vector< std::pair<int, int> > pairs;
+	while(pairs.size() < npairs)
+	{
+		int a = cell(gen), b = cell(gen);
+		if(cells[a]==0 && cells[b]==0) pairs.push_back(std::make_pair(a, b));
+	}
+	return pairs;
+}
 
-	float* data = new float[2];
-	for(auto point: path)
+void test_astar_random_pairs()
+{
+	std::cout<<"A* - random start/goal pairs on a synthetic 1000x1000 map"<<std::endl;
+	int width = 1000, height = 1000;
+	std::vector<int> cells = synthetic_cells(width, height, 400, 0);
+	AstarPlanner2d planner;
+	planner.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	std::vector< std::pair<int, int> > pairs = random_free_pairs(cells, 20, 1);
+	double total = 0;
+	size_t expanded = 0;
+	int nfound = 0;
+	for(auto& pair: pairs)
 	{
-		for(int i=0; i<2; ++i) data[i] = point[i];
-		f.write((char *)data, 2*sizeof(float));
+		Point2f start, goal;
+		planner.get_map().ij_to_xy(pair.first/width, pair.first%width, start[0], start[1]);
+		planner.get_map().ij_to_xy(pair.second/width, pair.second%width, goal[0], goal[1]);
+		start = start + Point2f({0.025, 0.025});
+		goal = goal + Point2f({0.025, 0.025});
+		auto start_t = std::chrono::high_resolution_clock::now();
+		auto path = planner.compute_plan(start, goal);
+		auto end_t = std::chrono::high_resolution_clock::now();
+		total += std::chrono::duration<double>(end_t-start_t).count();
+		expanded += planner.get_num_expanded();
+		float expected = dijkstra_cost(cells, width, height, pair.first, pair.second);
+		if(expected < 0)
+		{
+			assert(path.empty());
+			continue;
+		}
+		++nfound;
+		float cost = path_cost(planner.get_map(), path);
+		assert(std::abs(cost-expected) < 1e-3*expected+1e-3);
 	}
-	delete[] data;
-	f.close();
+	std::cout<<"\t"<<nfound<<" paths, mean compute time: "<<total/pairs.size()<<"s, mean expanded cells: "
+		<<expanded/pairs.size()<<std::endl;
 }
 
-void test_astar()
+/// @brief warehouse-like map, rows of shelves separated by aisles, with cross aisles every 250 cells
+std::vector<int> warehouse_cells(int width, int height)
 {
-	Map_Data map_data = read_pgm("../data/map.pgm");
-	float occupied_thresh = 0.65, free_thresh = 0.196;
-	auto occ_data = raw_pgm_to_occupancy_data(map_data, occupied_thresh, free_thresh);
+	std::vector<int> cells(width*height, 0);
+	for(int i=0; i<height; ++i)
+	{
+		for(int j=0; j<width; ++j)
+		{
+			bool border = (i==0 || j==0 || i==height-1 || j==width-1);
+			bool shelf = (i%20 >= 12) && (j%250 >= 10) && (j%250 < 240);
+			if(border || shelf) cells[i*width+j] = 100;
+		}
+	}
+	return cells;
+}
 
-	AstarPlanner2d planner;
+void test_bidirectional_astar()
+{
+	std::cout<<"bidirectional A* vs A* - synthetic 1000x1000 map and random pairs"<<std::endl;
+	int width = 1000, height = 1000;
+	std::vector<int> cells = synthetic_cells(width, height, 400, 0);
+	AstarPlanner2d astar;
+	BidirectionalAstarPlanner2d bidirectional;
+	astar.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	bidirectional.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	size_t random_expanded[2] = {0, 0};
+	for(auto& pair: random_free_pairs(cells, 20, 2))
+	{
+		Point2f start, goal;
+		astar.get_map().ij_to_xy(pair.first/width, pair.first%width, start[0], start[1]);
+		astar.get_map().ij_to_xy(pair.second/width, pair.second%width, goal[0], goal[1]);
+		start = start + Point2f({0.025, 0.025});
+		goal = goal + Point2f({0.025, 0.025});
+		auto path = astar.compute_plan(start, goal);
+		auto bidirectional_path = bidirectional.compute_plan(start, goal);
+		random_expanded[0] += astar.get_num_expanded();
+		random_expanded[1] += bidirectional.get_num_expanded();
+		assert(path.empty()==bidirectional_path.empty());
+		if(path.empty()) continue;
+		float cost = path_cost(astar.get_map(), path), bidirectional_cost = path_cost(astar.get_map(), bidirectional_path);
+		assert(std::abs(cost-bidirectional_cost) < 1e-3*cost+1e-3);
+	}
 
-	float resolution = 0.02;
-	Point2f origin({-33.0, -39.4});
-	planner.set_map(occ_data, resolution, map_data.width, map_data.height, origin);
+	std::cout<<"\tmean expanded cells: "<<random_expanded[0]/20<<" A*, "<<random_expanded[1]/20<<" bidirectional A*"<<std::endl;
 
-	Point2f start({11.0, -9.4});
-	Point2f goal({7.0, -5.4});
-	auto start_t = std::chrono::high_resolution_clock::now();
-	auto path = planner.compute_plan(start, goal);
-	auto end_t = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> duration = end_t-start_t;
-	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
+	// same with clearance costs, moves cost the same in both directions
+	astar.get_map().set_inflation(0.1, 0.5);
+	bidirectional.get_map().set_inflation(0.1, 0.5);
+	astar.set_clearance_weight(2.0);
+	bidirectional.set_clearance_weight(2.0);
+	for(auto& pair: random_free_pairs(cells, 20, 3))
+	{
+		Point2f start, goal;
+		astar.get_map().ij_to_xy(pair.first/width, pair.first%width, start[0], start[1]);
+		astar.get_map().ij_to_xy(pair.second/width, pair.second%width, goal[0], goal[1]);
+		start = start + Point2f({0.025, 0.025});
+		goal = goal + Point2f({0.025, 0.025});
+		auto path = astar.compute_plan(start, goal);
+		auto bidirectional_path = bidirectional.compute_plan(start, goal);
+		assert(path.empty()==bidirectional_path.empty());
+		if(path.empty()) continue;
+		// path costs with clearance weight, summed per move into a cell
+		float costs[2] = {0, 0};
+		std::vector<Point2f>* paths[2] = {&path, &bidirectional_path};
+		for(int p=0; p<2; ++p)
+		{
+			for(size_t k=1; k<paths[p]->size(); ++k)
+			{
+				int i0, j0, i1, j1;
+				astar.get_map().xy_to_ij((*paths[p])[k-1][0]+0.025, (*paths[p])[k-1][1]+0.025, i0, j0);
+				astar.get_map().xy_to_ij((*paths[p])[k][0]+0.025, (*paths[p])[k][1]+0.025, i1, j1);
+				float step = (i0!=i1 && j0!=j1)?1.41421356f:1.0f;
+				costs[p] += step*(1+2.0f/253*astar.get_map().cost(i1, j1));
+			}
+		}
+		assert(std::abs(costs[0]-costs[1]) < 1e-3*costs[0]+1e-3);
+	}
 
-	save_path_as_bin(path, "../data/map_path.bin");
+	std::cout<<"bidirectional A* vs A* - long aisle to aisle queries on a 1000x1000 warehouse map"<<std::endl;
+	cells = warehouse_cells(width, height);
+	astar.get_map().clear_inflation();
+	astar.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	bidirectional.get_map().clear_inflation();
+	bidirectional.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	double times[2] = {0, 0};
+	size_t expanded[2] = {0, 0};
+	int nqueries = 0;
+	for(int a=0; a<5; ++a)
+	{
+		// from an aisle in the top left part to an aisle in the bottom right part
+		int si = 5+20*a, sj = 100+37*a, gi = 985-20*a, gj = 880-29*a;
+		assert(cells[si*width+sj]==0 && cells[gi*width+gj]==0);
+		Point2f start, goal;
+		astar.get_map().ij_to_xy(si, sj, start[0], start[1]);
+		astar.get_map().ij_to_xy(gi, gj, goal[0], goal[1]);
+		start = start + Point2f({0.025, 0.025});
+		goal = goal + Point2f({0.025, 0.025});
+		AstarPlanner2d* planners[2] = {&astar, &bidirectional};
+		float costs[2];
+		for(int p=0; p<2; ++p)
+		{
+			auto start_t = std::chrono::high_resolution_clock::now();
+			auto path = planners[p]->compute_plan(start, goal);
+			auto end_t = std::chrono::high_resolution_clock::now();
+			times[p] += std::chrono::duration<double>(end_t-start_t).count();
+			expanded[p] += planners[p]->get_num_expanded();
+			assert(!path.empty());
+			costs[p] = path_cost(astar.get_map(), path);
+		}
+		assert(std::abs(costs[0]-costs[1]) < 1e-3*costs[0]);
+		++nqueries;
+	}
+	std::cout<<"\tA*: "<<times[0]/nqueries<<"s per query, "<<expanded[0]/nqueries<<" expanded cells"<<std::endl;
+	std::cout<<"\tbidirectional A*: "<<times[1]/nqueries<<"s per query, "<<expanded[1]/nqueries<<" expanded cells"<<std::endl;
 }
 
 int main(int argc, char** argv)
 {
 	test_astar();
+	test_astar_inflation();
+	test_astar_random_pairs();
+	test_bidirectional_astar();
 }
\ No newline at end of file
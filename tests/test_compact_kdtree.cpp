@@ -0,0 +1,168 @@
+#include "data_structures/kdtree.h"
+#include "data_structures/compact_kdtree.h"
+#include "pointcloud_lib/normal_estimator.h"
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cassert>
+#include <malloc.h>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+/// @brief bytes currently allocated on the heap
+size_t heap_bytes()
+{
+	return mallinfo2().uordblks;
+}
+
+void test_half_conversion()
+{
+	// exactly representable values round trip
+	for(float f: {0.0f, -0.0f, 1.0f, -2.5f, 0.000061035156f, 65504.0f, 5.9604645e-08f}) assert(half_to_float(float_to_half(f))==f);
+	// every half value round trips
+	for(int h=0; h<(1<<16); ++h)
+	{
+		float f = half_to_float(h);
+		if(f==f) assert(float_to_half(f)==h);
+	}
+	// relative rounding error of normal values
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<float> distrib(-1000.0, 1000.0);
+	for(int i=0; i<10000; ++i)
+	{
+		float f = distrib(gen);
+		if(std::abs(f) < 1e-3f) continue;
+		assert(std::abs(half_to_float(float_to_half(f))-f) <= std::abs(f)/2048);
+	}
+	std::cout<<"half float conversion test passed"<<std::endl;
+}
+
+void test_compact_kdtree_random()
+{
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<float> distrib(-50.0, 50.0);
+	int npoints = 20000;
+	std::vector<Point3f> pointvec;
+	for(int i=0; i<npoints; ++i) pointvec.push_back(Point3f({distrib(gen), distrib(gen), distrib(gen)/10.0f}));
+
+	for(QuantizationMode mode: {QuantizationMode::FIXED16, QuantizationMode::HALF})
+	{
+		CompactKDTree<float> tree(mode, 0.002);
+		tree.build(pointvec);
+		double err = tree.get_max_error();
+		assert(mode!=QuantizationMode::FIXED16 || err <= 0.001+1e-5);
+
+		std::vector<int> indices, knn;
+		std::vector<double> dists;
+		double radius = 2.0;
+		for(int q=0; q<100; ++q)
+		{
+			Point3f qpoint({distrib(gen), distrib(gen), distrib(gen)/10.0f});
+			tree.neighborhood_indices(qpoint, radius, indices);
+			std::vector<char> found(npoints, 0);
+			for(int i: indices) found[i] = 1;
+			// stored points differ by at most err per coordinate from the input points
+			double slack = std::sqrt(3.0)*err;
+			for(int i=0; i<npoints; ++i)
+			{
+				double dist = pointvec[i].distance_to(qpoint);
+				if(dist <= radius-slack) assert(found[i]);
+				if(dist > radius+slack) assert(!found[i]);
+			}
+
+			tree.k_nearest_indices(qpoint, 8, knn, dists);
+			assert(knn.size()==8);
+			for(int i=1; i<dists.size(); ++i) assert(dists[i-1] <= dists[i]);
+			std::vector<double> all(npoints);
+			for(int i=0; i<npoints; ++i) all[i] = pointvec[i].distance_to(qpoint);
+			std::nth_element(all.begin(), all.begin()+7, all.end());
+			assert(std::abs(dists[7]-all[7]) <= 2*slack);
+		}
+	}
+	std::cout<<"compact kdtree neighborhood and k nearest test passed"<<std::endl;
+}
+
+void test_compact_kdtree_kitti()
+{
+	std::cout<<"compact kdtree - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+	int n = pointvec.size();
+	std::cout<<"\t"<<n<<" points, "<<n*3*sizeof(float)<<" bytes of float coordinates"<<std::endl;
+
+	double radius = 0.2;
+	std::vector<int> indices;
+	size_t before = heap_bytes();
+	KDTree<3, float> tree;
+	tree.build(pointvec);
+	size_t tree_bytes = heap_bytes()-before;
+	auto start = std::chrono::high_resolution_clock::now();
+	size_t total_neighbors = 0;
+	for(int i=0; i<n; i+=4)
+	{
+		tree.neighborhood_indices(pointvec[i], radius, indices);
+		total_neighbors += indices.size();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tKDTree: "<<tree_bytes<<" bytes ("<<static_cast<double>(tree_bytes)/n<<" per point), "
+		<<(n/4)/duration.count()<<" radius queries/s, "<<total_neighbors<<" neighbors"<<std::endl;
+
+	for(QuantizationMode mode: {QuantizationMode::FIXED16, QuantizationMode::HALF})
+	{
+		before = heap_bytes();
+		CompactKDTree<float> compact_tree(mode, 0.005);
+		compact_tree.build(pointvec);
+		size_t compact_bytes = heap_bytes()-before;
+		start = std::chrono::high_resolution_clock::now();
+		size_t compact_neighbors = 0;
+		for(int i=0; i<n; i+=4)
+		{
+			compact_tree.neighborhood_indices(pointvec[i], radius, indices);
+			compact_neighbors += indices.size();
+		}
+		end = std::chrono::high_resolution_clock::now();
+		duration = end-start;
+		std::cout<<"\tCompactKDTree ("<<(mode==QuantizationMode::FIXED16?"fixed16":"half")<<"): "<<compact_bytes<<" bytes ("
+			<<static_cast<double>(compact_bytes)/n<<" per point, "<<compact_tree.points().memory_bytes()<<" bytes of coordinates), "
+			<<(n/4)/duration.count()<<" radius queries/s, "<<compact_neighbors<<" neighbors, max error "<<compact_tree.get_max_error()<<std::endl;
+		assert(compact_tree.points().memory_bytes()*2==n*3*sizeof(float));
+		assert(compact_bytes < tree_bytes);
+	}
+
+	// normals from quantized neighborhoods
+	NormalEstimator<3, float> ne;
+	ne.set_pointcloud(pointvec);
+	ne.set_quantization(true);
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<Point3f> normalvec = ne.get_normals(0.1);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tnormal estimation with quantized neighborhoods time: "<<duration.count()<<"s"<<std::endl;
+	assert(normalvec.size()==n);
+}
+
+int main(int argc, char** argv)
+{
+	test_half_conversion();
+	test_compact_kdtree_random();
+	test_compact_kdtree_kitti();
+}
@@ -0,0 +1,184 @@
+#include "planning_lib/dstar_lite_planner.h"
+#include "planning_lib/astar_planner.h"
+#include "planner_test_utils.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cassert>
+
+/**
+* @brief drive a robot towards the goal while obstacles appear on its path ahead and disappear elsewhere, replanning with
+* D* Lite after every change and checking path costs against A* on the same map
+*
+* @param inflation use an inflation layer with clearance weight, changes are then taken from the dirty region of the map
+*/
+void drive_and_replan(std::vector<int>& cells, int width, int height, int nsteps, bool inflation)
+{
+	DStarLitePlanner2d dstar;
+	AstarPlanner2d astar;
+	dstar.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	astar.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	float clearance_scale = 0;
+	if(inflation)
+	{
+		dstar.get_map().set_inflation(0.1, 0.4);
+		astar.get_map().set_inflation(0.1, 0.4);
+		dstar.set_clearance_weight(2);
+		astar.set_clearance_weight(2);
+		clearance_scale = 2/253.0f;
+	}
+	OccupancyGrid2d& map = dstar.get_map();
+	map.clear_dirty_region();
+
+	float half = 0.5*map.get_resolution();
+	int si = 0, sj = 0, gi = 0, gj = 0;
+	for(int d=1; !map.is_traversable(si, sj); ++d) si = sj = d;
+	for(int d=1; !map.is_traversable(gi, gj); ++d)
+	{
+		gi = height-1-d;
+		gj = width-1-d;
+	}
+	Point2f start, goal;
+	map.ij_to_xy(si, sj, start[0], start[1]);
+	map.ij_to_xy(gi, gj, goal[0], goal[1]);
+	start = start + Point2f({half, half});
+	goal = goal + Point2f({half, half});
+
+	auto start_t = std::chrono::high_resolution_clock::now();
+	auto path = dstar.compute_plan(start, goal);
+	auto end_t = std::chrono::high_resolution_clock::now();
+	double initial_time = std::chrono::duration<double>(end_t-start_t).count();
+	size_t initial_expanded = dstar.get_num_expanded();
+	assert(!path.empty());
+
+	std::mt19937 gen(3);
+	std::uniform_int_distribution<> row(1, height-2), col(1, width-2);
+	double replan_time = 0, astar_time = 0;
+	size_t replan_expanded = 0, astar_expanded = 0;
+	int nreplans = 0;
+	for(int step=0; step<nsteps && path.size() > 40; ++step)
+	{
+		// move 10 cells along the path
+		start = path[10] + Point2f({half, half});
+		int ri, rj;
+		map.xy_to_ij(start[0], start[1], ri, rj);
+
+		// an obstacle appears on the path 25 cells ahead, another one is removed somewhere
+		std::vector<Point2i> changed;
+		int oi, oj;
+		map.xy_to_ij(path[35][0]+half, path[35][1]+half, oi, oj);
+		for(int i=oi-3; i<=oi+3; ++i) for(int j=oj-3; j<=oj+3; ++j)
+		{
+			if(i>0 && j>0 && i<height-1 && j<width-1 && std::max(std::abs(i-gi), std::abs(j-gj)) > 5) changed.push_back(Point2i({i, j}));
+		}
+		size_t nblocked = changed.size();
+		int fi = row(gen), fj = col(gen);
+		for(int i=fi; i<std::min(height-1, fi+10); ++i) for(int j=fj; j<std::min(width-1, fj+10); ++j) changed.push_back(Point2i({i, j}));
+		for(size_t k=0; k<changed.size(); ++k)
+		{
+			int8_t value = (k < nblocked)?100:0;
+			map.set_cell(changed[k][0], changed[k][1], value);
+			astar.get_map().set_cell(changed[k][0], changed[k][1], value);
+			if(inflation && (k+1==nblocked || k+1==changed.size()))
+			{
+				// one dirty region per change, a single box around both would cover much of the map
+				map.update_inflation_incremental();
+				astar.get_map().update_inflation_incremental();
+				dstar.update_from_dirty_region();
+			}
+		}
+		if(!inflation) dstar.update_cells(changed);
+		if(!map.is_traversable(ri, rj)) break;
+
+		start_t = std::chrono::high_resolution_clock::now();
+		path = dstar.compute_plan(start, goal);
+		end_t = std::chrono::high_resolution_clock::now();
+		replan_time += std::chrono::duration<double>(end_t-start_t).count();
+		replan_expanded += dstar.get_num_expanded();
+		start_t = std::chrono::high_resolution_clock::now();
+		auto astar_path = astar.compute_plan(start, goal);
+		end_t = std::chrono::high_resolution_clock::now();
+		astar_time += std::chrono::duration<double>(end_t-start_t).count();
+		astar_expanded += astar.get_num_expanded();
+		++nreplans;
+
+		assert(path.empty()==astar_path.empty());
+		if(path.empty()) break;
+		float cost = path_cost(map, path, clearance_scale), astar_cost = path_cost(astar.get_map(), astar_path, clearance_scale);
+		assert(std::abs(cost-astar_cost) < 1e-3*astar_cost+1e-3);
+	}
+	assert(nreplans > 0);
+
+	// same query on the final map from scratch
+	dstar.reset();
+	start_t = std::chrono::high_resolution_clock::now();
+	dstar.compute_plan(start, goal);
+	end_t = std::chrono::high_resolution_clock::now();
+	double fresh_time = std::chrono::duration<double>(end_t-start_t).count();
+
+	std::cout<<"\tinitial search: "<<initial_time<<"s, "<<initial_expanded<<" expanded"<<std::endl;
+	std::cout<<"\t"<<nreplans<<" replans: "<<replan_time/nreplans<<"s, "<<replan_expanded/nreplans<<" expanded per replan"<<std::endl;
+	std::cout<<"\tA* from scratch: "<<astar_time/nreplans<<"s, "<<astar_expanded/nreplans<<" expanded per query"<<std::endl;
+	std::cout<<"\tD* Lite from scratch on the final map: "<<fresh_time<<"s, "<<dstar.get_num_expanded()<<" expanded"<<std::endl;
+}
+
+void test_dstar_lite()
+{
+	std::cout<<"D* Lite replanning on a synthetic 1000x1000 map with rectangular obstacles"<<std::endl;
+	int width = 1000, height = 1000;
+	std::vector<int> cells = synthetic_cells(width, height, 300, 0);
+	drive_and_replan(cells, width, height, 40, false);
+
+	std::cout<<"D* Lite replanning on a synthetic 400x400 map with inflation layer and clearance weight"<<std::endl;
+	std::vector<int> small = synthetic_cells(400, 400, 15, 1);
+	drive_and_replan(small, 400, 400, 20, true);
+}
+
+/**
+* @brief wall the goal off and open it again, the planner must report no path and then find one
+*/
+void test_dstar_lite_disconnect()
+{
+	std::cout<<"D* Lite with the goal walled off and reopened"<<std::endl;
+	int width = 100, height = 100;
+	std::vector<int> cells(width*height, 0);
+	DStarLitePlanner2d dstar;
+	dstar.set_map(cells, 0.1, width, height, Point2f({0, 0}));
+	OccupancyGrid2d& map = dstar.get_map();
+	Point2f start({0.55, 0.55}), goal({8.05, 8.05});
+	auto path = dstar.compute_plan(start, goal);
+	assert(!path.empty());
+
+	std::vector<Point2i> wall;
+	for(int k=70; k<100; ++k)
+	{
+		wall.push_back(Point2i({70, k}));
+		wall.push_back(Point2i({k, 70}));
+	}
+	for(auto& cell: wall) map.set_cell(cell[0], cell[1], 100);
+	dstar.update_cells(wall);
+	path = dstar.compute_plan(start, goal);
+	assert(path.empty());
+
+	std::vector<Point2i> gap({Point2i({70, 85})});
+	map.set_cell(70, 85, 0);
+	dstar.update_cells(gap);
+	start = Point2f({2.05, 5.05});
+	path = dstar.compute_plan(start, goal);
+	assert(!path.empty());
+	bool through_gap = false;
+	for(auto& point: path)
+	{
+		int i, j;
+		map.xy_to_ij(point[0]+0.05, point[1]+0.05, i, j);
+		if(i==70 && j==85) through_gap = true;
+	}
+	assert(through_gap);
+	std::cout<<"\tok"<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_dstar_lite();
+	test_dstar_lite_disconnect();
+}
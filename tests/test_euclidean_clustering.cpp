@@ -0,0 +1,85 @@
+#include "pointcloud_lib/euclidean_cluster_extractor.h"
+#include "pointcloud_lib/ground_segmenter.h"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+void test_clustering_blobs()
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	std::uniform_real_distribution<float> distrib(-0.5, 0.5);
+
+	// 3 dense blobs far apart and a few isolated points
+	std::vector<Point3f> pointvec;
+	std::vector<Point3f> centers = {Point3f({0, 0, 0}), Point3f({5, 0, 0}), Point3f({0, 5, 0})};
+	for(auto& center: centers)
+	{
+		for(int i=0; i<200; ++i) pointvec.push_back(Point3f({center[0]+distrib(gen), center[1]+distrib(gen), center[2]+distrib(gen)}));
+	}
+	for(int i=0; i<3; ++i) pointvec.push_back(Point3f({10.0f+5*i, 10, 10}));
+
+	EuclideanClusterExtractor<float> ce(0.5, 10);
+	std::vector<int> labels;
+	auto boxes = ce.extract(pointvec, labels);
+	assert(boxes.size()==3);
+	for(int i=0; i<3; ++i)
+	{
+		for(int j=0; j<200; ++j) assert(labels[i*200+j]==i);
+	}
+	for(int i=600; i<603; ++i) assert(labels[i]==-1);
+	std::cout<<"euclidean clustering test for separated blobs passed"<<std::endl;
+}
+
+void test_clustering_kitti()
+{
+	std::cout<<"euclidean clustering - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+
+	GroundSegmenter<float> gs;
+	auto points_pair = gs.segment(pointvec);
+	std::vector<Point3f>& other_points = points_pair.second;
+	std::cout<<"\t"<<other_points.size()<<" non-ground points"<<std::endl;
+
+	EuclideanClusterExtractor<float> ce(0.5, 20, 20000);
+	std::vector<int> labels;
+	auto start = std::chrono::high_resolution_clock::now();
+	auto boxes = ce.extract(other_points, labels);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
+	std::cout<<"\t"<<boxes.size()<<" clusters"<<std::endl;
+
+	std::string outfile = "../data/0000000000_cluster_labels.bin";
+	std::ofstream f(outfile.c_str(), std::ios::binary);
+	f.write((char *)labels.data(), labels.size()*sizeof(int));
+	f.close();
+	std::cout<<"\tcluster labels saved to "<<outfile<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_clustering_blobs();
+	test_clustering_kitti();
+}
@@ -0,0 +1,175 @@
+#include "pointcloud_lib/ground_segmenter.h"
+#include "pointcloud_lib/plane_extractor.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+template<unsigned int d, class T>
+void save_bin(const std::vector< Point<d, T> >& pointvec, std::string outfile)
+{
+	std::ofstream f(outfile.c_str(), std::ios::binary);
+
+	T *data = new T[d];
+	for(auto point: pointvec)
+	{
+		for(int i=0; i<d; ++i) data[i] = point[i];
+		f.write((char *)data, d*sizeof(T));
+	}
+
+	delete[] data;
+	f.close();
+}
+
+void test_ground_segmentation()
+{
+	std::cout<<"ground segmentation - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+	std::cout<<"\t"<<pointvec.size()<<" points"<<std::endl;
+
+	GroundSegmenter<float> gs;
+	std::vector<char> is_ground;
+	auto start = std::chrono::high_resolution_clock::now();
+	gs.segment(pointvec, is_ground);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tground segmenter compute time: "<<duration.count()<<"s"<<std::endl;
+
+	// reference labels from RANSAC plane extraction
+	PlaneExtractor<float> pe;
+	start = std::chrono::high_resolution_clock::now();
+	auto points_pair = pe.extract_plane(pointvec, 100, 0.3);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tRANSAC plane extraction compute time: "<<duration.count()<<"s"<<std::endl;
+
+	// plane points are a subsequence of the input points, so labels can be recovered in a single merge pass
+	std::vector<char> is_plane(pointvec.size(), 0);
+	int k = 0;
+	for(int i=0; i<pointvec.size() && k<points_pair.first.size(); ++i)
+	{
+		if(pointvec[i].is_equal_to(points_pair.first[k]))
+		{
+			is_plane[i] = 1;
+			++k;
+		}
+	}
+
+	int ground = 0, agree = 0;
+	for(int i=0; i<pointvec.size(); ++i)
+	{
+		ground += is_ground[i];
+		agree += (is_ground[i]==is_plane[i]);
+	}
+	std::cout<<"\tground points: "<<ground<<", RANSAC plane points: "<<points_pair.first.size()<<std::endl;
+	std::cout<<"\tlabel agreement: "<<100.0*agree/pointvec.size()<<"%"<<std::endl;
+
+	auto ground_pair = gs.segment(pointvec);
+	std::string outfile = "../data/0000000000_ground_points.bin";
+	save_bin(ground_pair.first, outfile);
+	std::cout<<"\tground points saved to "<<outfile<<std::endl;
+
+	outfile = "../data/0000000000_nonground_points.bin";
+	save_bin(ground_pair.second, outfile);
+	std::cout<<"\tother points saved to "<<outfile<<std::endl;
+}
+
+/// @brief ground height of the synthetic scene, flat with a ramp of slope 0.1 between 20m and 40m in the first quadrant
+float synthetic_ground(float r, float angle)
+{
+	float z = -1.73;
+	if(angle >= 0 && angle < 0.5*M_PI) z += 0.1*std::min(20.0f, std::max(0.0f, r-20));
+	return z;
+}
+
+void test_ground_segmentation_slope()
+{
+	std::cout<<"ground segmentation - synthetic scene with a ramp, boxes and points below ground"<<std::endl;
+	// 0: ground, 1: box points well above ground, 2: points far below ground
+	std::vector<Point3f> pointvec;
+	std::vector<int> kind;
+	auto add = [&pointvec, &kind](float r, float angle, float z, int k) {
+		pointvec.push_back(Point3f({r*std::cos(angle), r*std::sin(angle), z}));
+		kind.push_back(k);
+	};
+	// boxes as (min angle, max angle, min range, max range, height), one on the flat part and one on the ramp
+	float boxes[2][5] = {{-2.0, -1.8, 10, 12, 1.0}, {0.6, 0.7, 30, 32, 1.5}};
+	for(int a=0; a<720; ++a)
+	{
+		float angle = (a+0.5)*M_PI/360 - M_PI;
+		for(float r=3; r<60; r+=0.2)
+		{
+			bool under_box = false;
+			for(auto& box: boxes) under_box |= (angle>=box[0] && angle<box[1] && r>=box[2] && r<box[3]);
+			if(!under_box) add(r, angle, synthetic_ground(r, angle), 0);
+		}
+		// multipath returns far below ground
+		if(a%10==0) add(25, angle, synthetic_ground(25, angle)-1.0, 2);
+		for(auto& box: boxes)
+		{
+			if(angle<box[0] || angle>=box[1]) continue;
+			// near face and top of the box
+			for(float h=0.1; h<=box[4]; h+=0.1) add(box[2], angle, synthetic_ground(box[2], angle)+h, (h > 0.4)?1:-1);
+			for(float r=box[2]; r<box[3]; r+=0.2) add(r, angle, synthetic_ground(r, angle)+box[4], 1);
+		}
+	}
+
+	GroundSegmenter<float> gs;
+	std::vector<char> is_ground;
+	gs.segment(pointvec, is_ground);
+	// the running line fit lags for a few bins after a slope break, ground points there may be missed
+	int counts[3] = {0, 0, 0}, ground[3] = {0, 0, 0}, ramp = 0, ramp_ground = 0, near_break = 0, near_break_ground = 0;
+	for(int i=0; i<pointvec.size(); ++i)
+	{
+		if(kind[i] < 0) continue;
+		float r = std::sqrt(pointvec[i][0]*pointvec[i][0] + pointvec[i][1]*pointvec[i][1]);
+		bool on_ramp_side = pointvec[i][0] > 0 && pointvec[i][1] > 0;
+		if(kind[i]==0 && on_ramp_side && ((r >= 20 && r < 23) || (r >= 40 && r < 43)))
+		{
+			++near_break;
+			near_break_ground += is_ground[i];
+			continue;
+		}
+		++counts[kind[i]];
+		ground[kind[i]] += is_ground[i];
+		if(kind[i]==0 && on_ramp_side && r >= 23 && r < 40)
+		{
+			++ramp;
+			ramp_ground += is_ground[i];
+		}
+	}
+	std::cout<<"\tground points labelled ground: "<<ground[0]<<" of "<<counts[0]<<", on the ramp: "<<ramp_ground<<" of "<<ramp
+		<<", within 3m after a slope break: "<<near_break_ground<<" of "<<near_break<<std::endl;
+	std::cout<<"\tbox points labelled ground: "<<ground[1]<<" of "<<counts[1]<<std::endl;
+	std::cout<<"\tpoints below ground labelled ground: "<<ground[2]<<" of "<<counts[2]<<std::endl;
+	assert(ramp > 0 && ramp_ground==ramp);
+	assert(ground[0]==counts[0]);
+	assert(near_break_ground >= 0.8*near_break);
+	assert(ground[1]==0);
+	assert(ground[2]==0);
+}
+
+int main(int argc, char** argv)
+{
+	test_ground_segmentation();
+	test_ground_segmentation_slope();
+}
@@ -0,0 +1,233 @@
+#include "planning_lib/hpa_planner.h"
+#include "planning_lib/astar_planner.h"
+#include "planning_lib/map_loader.h"
+#include "planner_test_utils.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cassert>
+
+/// @brief random pairs of traversable cell centers
+std::vector< std::pair<Point2f, Point2f> > random_pairs(OccupancyGrid2d& map, int npairs, int seed)
+{
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<> row(0, map.get_height()-1), col(0, map.get_width()-1);
+	float half = 0.5*map.get_resolution();
+	std::vector< std::pair<Point2f, Point2f> > pairs;
+	for(int k=0; k<npairs; ++k)
+	{
+		int si, sj, gi, gj;
+		do { si = row(gen); sj = col(gen); } while(!map.is_traversable(si, sj));
+		do { gi = row(gen); gj = col(gen); } while(!map.is_traversable(gi, gj));
+		Point2f start, goal;
+		map.ij_to_xy(si, sj, start[0], start[1]);
+		map.ij_to_xy(gi, gj, goal[0], goal[1]);
+		pairs.push_back(std::make_pair(start + Point2f({half, half}), goal + Point2f({half, half})));
+	}
+	return pairs;
+}
+
+/**
+* @brief plan between random pairs with A* and HPA*, checking that HPA* finds a path whenever A* does and reporting how much
+* longer its paths are
+*/
+void compare_planners(OccupancyGrid2d& map, int npairs)
+{
+	AstarPlanner2d astar;
+	HpaPlanner2d hpa;
+	astar.set_map(OccupancyGrid2d(map));
+	hpa.set_map(OccupancyGrid2d(map));
+
+	auto start_t = std::chrono::high_resolution_clock::now();
+	hpa.build_abstract_graph();
+	auto end_t = std::chrono::high_resolution_clock::now();
+	std::cout<<"\tabstract graph: "<<hpa.get_num_abstract_nodes()<<" nodes built in "
+		<<std::chrono::duration<double>(end_t-start_t).count()<<"s"<<std::endl;
+
+	double astar_time = 0, hpa_time = 0, total_ratio = 0, max_ratio = 1;
+	size_t hpa_expanded = 0;
+	int nfound = 0;
+	for(auto& pair: random_pairs(map, npairs, 1))
+	{
+		start_t = std::chrono::high_resolution_clock::now();
+		auto astar_path = astar.compute_plan(pair.first, pair.second);
+		end_t = std::chrono::high_resolution_clock::now();
+		astar_time += std::chrono::duration<double>(end_t-start_t).count();
+		start_t = std::chrono::high_resolution_clock::now();
+		auto hpa_path = hpa.compute_plan(pair.first, pair.second);
+		end_t = std::chrono::high_resolution_clock::now();
+		hpa_time += std::chrono::duration<double>(end_t-start_t).count();
+		hpa_expanded += hpa.get_num_expanded();
+
+		assert(astar_path.empty()==hpa_path.empty());
+		if(astar_path.empty()) continue;
+		++nfound;
+		float astar_cost = path_cost(map, astar_path), hpa_cost = path_cost(map, hpa_path);
+		assert(hpa_cost >= astar_cost-1e-3*astar_cost-1e-3);
+		double ratio = (astar_cost > 0)?hpa_cost/astar_cost:1;
+		total_ratio += ratio;
+		max_ratio = std::max(max_ratio, ratio);
+	}
+	std::cout<<"\t"<<nfound<<" of "<<npairs<<" pairs connected"<<std::endl;
+	std::cout<<"\tA*: "<<astar_time/npairs<<"s per query"<<std::endl;
+	std::cout<<"\tHPA*: "<<hpa_time/npairs<<"s per query, "<<hpa_expanded/npairs<<" abstract nodes expanded"<<std::endl;
+	if(nfound > 0)
+	{
+		std::cout<<"\tHPA* path length / A* path length: "<<total_ratio/nfound<<" mean, "<<max_ratio<<" max"<<std::endl;
+		assert(total_ratio/nfound < 1.1);
+	}
+}
+
+void test_hpa_known_map()
+{
+	std::cout<<"HPA* vs A* on known map"<<std::endl;
+	OccupancyGrid2d map;
+	if(!load_map("../data/map.yaml", map))
+	{
+		std::cout<<"\tcould not load ../data/map.yaml"<<std::endl;
+		return;
+	}
+	compare_planners(map, 200);
+}
+
+void test_hpa_synthetic()
+{
+	std::cout<<"HPA* vs A* on a synthetic 1000x1000 map with rectangular obstacles"<<std::endl;
+	int width = 1000, height = 1000;
+	std::vector<int> cells = synthetic_cells(width, height, 300, 0, 0);
+	OccupancyGrid2d map;
+	map.set(cells, 0.05, width, height, Point2f({0, 0}));
+	compare_planners(map, 100);
+
+	// single cell obstacles make many short entrances and diagonal crossings
+	std::cout<<"HPA* vs A* on a synthetic 1000x1000 map with rectangular and 20000 scattered obstacles"<<std::endl;
+	std::vector<int> cluttered = synthetic_cells(width, height, 300, 0, 20000);
+	OccupancyGrid2d cluttered_map;
+	cluttered_map.set(cluttered, 0.05, width, height, Point2f({0, 0}));
+	compare_planners(cluttered_map, 100);
+}
+
+/**
+* @brief change cells of the map, update the abstract graph and check that queries give the same paths as a planner whose
+* abstract graph is built from scratch on the changed map
+*
+* even rounds pass the changed cells to `update_cells`, odd rounds update from the dirty region after every change
+*/
+void test_hpa_update()
+{
+	std::cout<<"HPA* abstract graph update after map changes"<<std::endl;
+	int width = 1000, height = 1000;
+	std::vector<int> cells = synthetic_cells(width, height, 300, 0, 2000);
+	HpaPlanner2d hpa;
+	hpa.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	hpa.build_abstract_graph();
+	OccupancyGrid2d& map = hpa.get_map();
+	map.clear_dirty_region();
+
+	std::mt19937 gen(2);
+	std::uniform_int_distribution<> row(1, height-42), col(1, width-42);
+	for(int round=0; round<5; ++round)
+	{
+		// a wall appears and a block is cleared at independent positions
+		std::vector<Point2i> wall, block;
+		int i0 = row(gen), j0 = col(gen);
+		for(int j=j0; j<j0+40; ++j) wall.push_back(Point2i({i0, j}));
+		i0 = row(gen);
+		j0 = col(gen);
+		for(int i=i0; i<i0+20; ++i) for(int j=j0; j<j0+20; ++j) block.push_back(Point2i({i, j}));
+
+		// dirty region per change, a single box around both would cover the clusters between them
+		double update_time = 0;
+		auto update = [&]()
+		{
+			auto start_t = std::chrono::high_resolution_clock::now();
+			if(round%2==1) hpa.update_from_dirty_region();
+			else
+			{
+				std::vector<Point2i> changed(wall);
+				changed.insert(changed.end(), block.begin(), block.end());
+				hpa.update_cells(changed);
+				map.clear_dirty_region();
+			}
+			auto end_t = std::chrono::high_resolution_clock::now();
+			update_time += std::chrono::duration<double>(end_t-start_t).count();
+		};
+		for(auto& cell: wall) map.set_cell(cell[0], cell[1], 100);
+		if(round%2==1) update();
+		for(auto& cell: block) map.set_cell(cell[0], cell[1], 0);
+		update();
+
+		HpaPlanner2d fresh;
+		fresh.set_map(OccupancyGrid2d(map));
+		auto start_t = std::chrono::high_resolution_clock::now();
+		fresh.build_abstract_graph();
+		auto end_t = std::chrono::high_resolution_clock::now();
+		double build_time = std::chrono::duration<double>(end_t-start_t).count();
+		std::cout<<"\tround "<<round<<((round%2==0)?" (changed cells)":" (dirty region per change)")<<": update "<<update_time
+			<<"s, rebuild "<<build_time<<"s"<<std::endl;
+		assert(hpa.get_num_abstract_nodes()==fresh.get_num_abstract_nodes());
+
+		for(auto& pair: random_pairs(map, 20, round))
+		{
+			auto path = hpa.compute_plan(pair.first, pair.second);
+			auto fresh_path = fresh.compute_plan(pair.first, pair.second);
+			assert(path.size()==fresh_path.size());
+			if(!path.empty())
+			{
+				float cost = path_cost(map, path), fresh_cost = path_cost(map, fresh_path);
+				assert(std::abs(cost-fresh_cost) < 1e-3*cost+1e-3);
+			}
+		}
+	}
+}
+
+/// @brief check that queries of hpa give the paths of a planner built from scratch on its map
+void check_against_fresh(HpaPlanner2d& hpa, std::vector<int>& cells, int width, int height)
+{
+	HpaPlanner2d fresh;
+	fresh.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	for(auto& pair: random_pairs(hpa.get_map(), 20, width))
+	{
+		auto path = hpa.compute_plan(pair.first, pair.second);
+		auto fresh_path = fresh.compute_plan(pair.first, pair.second);
+		assert(path.size()==fresh_path.size());
+		if(!path.empty())
+		{
+			float cost = path_cost(hpa.get_map(), path), fresh_cost = path_cost(fresh.get_map(), fresh_path);
+			assert(std::abs(cost-fresh_cost) < 1e-3*cost+1e-3);
+		}
+	}
+	assert(hpa.get_num_abstract_nodes()==fresh.get_num_abstract_nodes());
+}
+
+/**
+* @brief replace the map after a query, with one of a different size and then with one of the same size followed by `reset`
+*/
+void test_hpa_replace_map()
+{
+	std::cout<<"HPA* after the map is replaced"<<std::endl;
+	HpaPlanner2d hpa;
+	std::vector<int> cells = synthetic_cells(400, 300, 40, 0, 500);
+	hpa.set_map(cells, 0.05, 400, 300, Point2f({0, 0}));
+	check_against_fresh(hpa, cells, 400, 300);
+
+	// different size, the abstract graph is rebuilt on the next query
+	cells = synthetic_cells(500, 500, 60, 1, 800);
+	hpa.set_map(cells, 0.05, 500, 500, Point2f({0, 0}));
+	check_against_fresh(hpa, cells, 500, 500);
+
+	// same size, the abstract graph must be dropped
+	cells = synthetic_cells(500, 500, 60, 2, 800);
+	hpa.set_map(cells, 0.05, 500, 500, Point2f({0, 0}));
+	hpa.reset();
+	check_against_fresh(hpa, cells, 500, 500);
+	std::cout<<"\tok"<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_hpa_known_map();
+	test_hpa_synthetic();
+	test_hpa_update();
+	test_hpa_replace_map();
+}
@@ -0,0 +1,95 @@
+#include "pointcloud_lib/icp.h"
+#include "pointcloud_lib/voxel_grid_filter.h"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+std::vector<Point3f> transform_points(std::vector<Point3f>& pointvec, const Eigen::Matrix4d& transform, std::mt19937& gen, float noise)
+{
+	std::normal_distribution<float> distrib(0.0, noise);
+	std::vector<Point3f> transformed;
+	for(auto& point: pointvec)
+	{
+		Eigen::Vector4d p(point[0], point[1], point[2], 1.0);
+		Eigen::Vector4d q = transform*p;
+		transformed.push_back(Point3f({float(q(0))+distrib(gen), float(q(1))+distrib(gen), float(q(2))+distrib(gen)}));
+	}
+	return transformed;
+}
+
+void test_icp_sequence(IcpMethod method, const std::string& name)
+{
+	std::cout<<"icp "<<name<<" - synthetic sequence from kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+
+	// sensor moves 0.5 m forward and turns 1 degree every frame, points of frame k are the static scene seen from pose k
+	Eigen::Matrix4d motion = Eigen::Matrix4d::Identity();
+	motion.block<3, 3>(0, 0) = Eigen::AngleAxisd(M_PI/180.0, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+	motion(0, 3) = 0.5;
+
+	std::mt19937 gen(0);
+	VoxelGridFilter<float> filter(0.3);
+	int nframes = 5;
+	std::vector< std::vector<Point3f> > frames;
+	Eigen::Matrix4d pose = Eigen::Matrix4d::Identity();
+	for(int k=0; k<nframes; ++k)
+	{
+		auto points = transform_points(pointvec, pose.inverse(), gen, 0.01);
+		frames.push_back(filter.filter(points));
+		pose = pose*motion;
+	}
+	std::cout<<"\t"<<nframes<<" frames, "<<frames[0].size()<<" points per frame"<<std::endl;
+
+	IterativeClosestPoint<float> icp(method, 50, 1.0);
+	double total_time = 0.0, iteration_time = 0.0;
+	int total_iterations = 0;
+	icp.set_target(frames[0]);
+	for(int k=1; k<nframes; ++k)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		Eigen::Matrix4d transform = icp.align(frames[k]);
+		// current frame is the target of the next one
+		icp.set_target(frames[k]);
+		auto end = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double> duration = end-start;
+		total_time += duration.count();
+		for(double t: icp.get_iteration_times()) iteration_time += t;
+		total_iterations += icp.get_num_iterations();
+
+		Eigen::Matrix4d error = motion.inverse()*transform;
+		double translation_error = error.block<3, 1>(0, 3).norm();
+		double rotation_error = std::acos(std::min(1.0, (error.block<3, 3>(0, 0).trace()-1.0)/2.0));
+		std::cout<<"\tframe "<<k<<" - iterations: "<<icp.get_num_iterations()<<", converged: "<<icp.has_converged()
+			<<", translation error: "<<translation_error<<"m, rotation error: "<<rotation_error*180.0/M_PI<<"deg"<<std::endl;
+		assert(translation_error < 0.1);
+	}
+	std::cout<<"\tmean iteration time: "<<iteration_time/total_iterations<<"s"<<std::endl;
+	std::cout<<"\tframes/sec (including target indexing): "<<(nframes-1)/total_time<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_icp_sequence(IcpMethod::POINT_TO_POINT, "point to point");
+	test_icp_sequence(IcpMethod::POINT_TO_PLANE, "point to plane");
+}
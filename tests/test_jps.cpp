@@ -0,0 +1,100 @@
+#include "planning_lib/jps_planner.h"
+#include "planning_lib/astar_planner.h"
+#include "planning_lib/map_loader.h"
+#include "planner_test_utils.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cassert>
+
+/**
+* @brief plan between random pairs of traversable cells with A* and JPS, checking that path costs are equal
+*/
+void compare_planners(OccupancyGrid2d& map, int npairs)
+{
+	AstarPlanner2d astar;
+	JpsPlanner2d jps;
+	astar.set_map(OccupancyGrid2d(map));
+	jps.set_map(OccupancyGrid2d(map));
+	int width = map.get_width(), height = map.get_height();
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<> row(0, height-1), col(0, width-1);
+	double astar_time = 0, jps_time = 0;
+	size_t astar_pushes = 0, jps_pushes = 0, astar_expanded = 0, jps_expanded = 0;
+	int nfound = 0;
+	float half = 0.5*map.get_resolution();
+	for(int k=0; k<npairs; ++k)
+	{
+		int si, sj, gi, gj;
+		do { si = row(gen); sj = col(gen); } while(!map.is_traversable(si, sj));
+		do { gi = row(gen); gj = col(gen); } while(!map.is_traversable(gi, gj));
+		Point2f start, goal;
+		map.ij_to_xy(si, sj, start[0], start[1]);
+		map.ij_to_xy(gi, gj, goal[0], goal[1]);
+		start = start + Point2f({half, half});
+		goal = goal + Point2f({half, half});
+
+		auto start_t = std::chrono::high_resolution_clock::now();
+		auto astar_path = astar.compute_plan(start, goal);
+		auto end_t = std::chrono::high_resolution_clock::now();
+		astar_time += std::chrono::duration<double>(end_t-start_t).count();
+		start_t = std::chrono::high_resolution_clock::now();
+		auto jps_path = jps.compute_plan(start, goal);
+		end_t = std::chrono::high_resolution_clock::now();
+		jps_time += std::chrono::duration<double>(end_t-start_t).count();
+		astar_pushes += astar.get_num_pushes();
+		jps_pushes += jps.get_num_pushes();
+		astar_expanded += astar.get_num_expanded();
+		jps_expanded += jps.get_num_expanded();
+
+		assert(astar_path.empty()==jps_path.empty());
+		if(astar_path.empty()) continue;
+		++nfound;
+		float astar_cost = path_cost(map, astar_path), jps_cost = path_cost(map, jps_path);
+		assert(std::abs(astar_cost-jps_cost) < 1e-3*astar_cost+1e-3);
+	}
+	std::cout<<"\t"<<nfound<<" of "<<npairs<<" pairs connected"<<std::endl;
+	std::cout<<"\tA*: "<<astar_time/npairs<<"s per query, "<<astar_pushes/npairs<<" heap pushes, "<<astar_expanded/npairs
+		<<" expanded"<<std::endl;
+	std::cout<<"\tJPS: "<<jps_time/npairs<<"s per query, "<<jps_pushes/npairs<<" heap pushes, "<<jps_expanded/npairs
+		<<" expanded"<<std::endl;
+}
+
+void test_jps_known_map()
+{
+	std::cout<<"JPS vs A* on known map"<<std::endl;
+	OccupancyGrid2d map;
+	if(!load_map("../data/map.yaml", map))
+	{
+		std::cout<<"\tcould not load ../data/map.yaml"<<std::endl;
+		return;
+	}
+	compare_planners(map, 200);
+}
+
+void test_jps_synthetic()
+{
+	std::cout<<"JPS vs A* on a synthetic 1000x1000 map with rectangular obstacles"<<std::endl;
+	int width = 1000, height = 1000;
+	std::vector<int> cells = synthetic_cells(width, height, 300, 0, 0);
+	OccupancyGrid2d map;
+	map.set(cells, 0.05, width, height, Point2f({0, 0}));
+	compare_planners(map, 100);
+
+	// many isolated obstacles create many jump points
+	std::cout<<"JPS vs A* on a synthetic 1000x1000 map with rectangular and 2000 scattered obstacles"<<std::endl;
+	std::vector<int> cluttered = synthetic_cells(width, height, 300, 0, 2000);
+	OccupancyGrid2d cluttered_map;
+	cluttered_map.set(cluttered, 0.05, width, height, Point2f({0, 0}));
+	compare_planners(cluttered_map, 100);
+
+	std::cout<<"JPS vs A* on a synthetic 1000x1000 map with inflation layer"<<std::endl;
+	map.set_inflation(0.1, 0.3);
+	compare_planners(map, 50);
+}
+
+int main(int argc, char** argv)
+{
+	test_jps_known_map();
+	test_jps_synthetic();
+}
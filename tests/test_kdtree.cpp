@@ -199,6 +199,65 @@ void test_3f_neigborhood()
 	std::cout<<"neighborhood search test for 3 dimensional float points passed"<<std::endl;
 }
 
+void test_3f_neighborhood_indices()
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+	// 3d float points
+	std::uniform_real_distribution<float> distrib(-10.0, 10.0);
+	int npoints = 10000;
+	std::vector<Point3f> point3f_vec;
+	for(int i=0; i<npoints; ++i) point3f_vec.push_back(Point3f({distrib(gen), distrib(gen), distrib(gen)/10.0f}));
+	Point3f qpoint({distrib(gen), distrib(gen), distrib(gen)/10.0f});
+	double radius=1.0;
+
+	std::vector<int> indices_bf;
+	for(int i=0; i<npoints; ++i) if(point3f_vec[i].distance_to(qpoint)<=radius) indices_bf.push_back(i);
+
+	KDTree<3, float> tree;
+	tree.build(point3f_vec);
+	std::vector<int> indices;
+	tree.neighborhood_indices(qpoint, radius, indices);
+	sort(indices.begin(), indices.end());
+
+	assert(indices_bf.size()==indices.size());
+	for(int i=0; i<indices_bf.size(); ++i) assert(indices_bf[i]==indices[i]);
+	std::cout<<"neighborhood indices search test for 3 dimensional float points passed"<<std::endl;
+}
+
+void test_3f_k_nearest()
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+	// 3d float points
+	std::uniform_real_distribution<float> distrib(-10.0, 10.0);
+	int npoints = 10000;
+	std::vector<Point3f> point3f_vec;
+	for(int i=0; i<npoints; ++i) point3f_vec.push_back(Point3f({distrib(gen), distrib(gen), distrib(gen)/10.0f}));
+	Point3f qpoint({distrib(gen), distrib(gen), distrib(gen)/10.0f});
+	int k = 15;
+
+	std::vector<double> dists_bf;
+	for(auto point: point3f_vec) dists_bf.push_back(point.distance_to(qpoint));
+	sort(dists_bf.begin(), dists_bf.end());
+
+	KDTree<3, float> tree;
+	tree.build(point3f_vec);
+	std::vector<int> indices;
+	std::vector<double> dists;
+	tree.k_nearest_indices(qpoint, k, indices, dists);
+
+	assert(indices.size()==k);
+	for(int i=0; i<k; ++i)
+	{
+		assert(dists[i]==dists_bf[i]);
+		assert(point3f_vec[indices[i]].distance_to(qpoint)==dists[i]);
+	}
+	std::cout<<"k nearest neighbors search test for 3 dimensional float points passed"<<std::endl;
+}
+
 int main(int argc, char** argv)
 {
 	test_2i_search();
@@ -206,4 +265,6 @@ int main(int argc, char** argv)
 
 	test_2i_neigborhood();
 	test_3f_neigborhood();
+	test_3f_neighborhood_indices();
+	test_3f_k_nearest();
 }
\ No newline at end of file
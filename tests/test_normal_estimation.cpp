@@ -2,6 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <cassert>
 
 template<unsigned int d, class T>
 std::vector< Point<d, T> > read_bin(const std::string& binfile)
@@ -98,6 +99,80 @@ void test_normal_estimation_sphere()
 	std::cout<<"\tnormals saved to "<<outfile<<std::endl;
 }
 
+void test_geometric_features_plane()
+{
+	std::cout<<"geometric features - plane"<<std::endl;
+	std::string binfile = "../data/plane.bin";
+	std::vector<Point3f> pointvec = read_bin<3, float>(binfile);
+	std::cout<<"\t"<<pointvec.size()<<" points"<<std::endl;
+
+	NormalEstimator<3, float> ne;
+	ne.set_pointcloud(pointvec);
+	double radius = 0.2;
+	auto start = std::chrono::high_resolution_clock::now();
+	const GeometricFeatures<float>& features = ne.get_features(radius);
+	// normals are computed in the same pass as features
+	std::vector<Point3f> normalvec = ne.get_normals(radius);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tcompute time (normals + features): "<<duration.count()<<"s"<<std::endl;
+
+	double mean_planarity = 0.0, mean_curvature = 0.0;
+	for(int i=0; i<features.size(); ++i)
+	{
+		mean_planarity += features.planarity[i];
+		mean_curvature += features.curvature[i];
+	}
+	mean_planarity /= features.size();
+	mean_curvature /= features.size();
+	std::cout<<"\tmean planarity: "<<mean_planarity<<", mean curvature: "<<mean_curvature<<std::endl;
+	assert(normalvec.size()==features.size());
+	assert(mean_planarity > mean_curvature);
+}
+
+void test_spatial_reorder_kitti()
+{
+	std::cout<<"normal estimation - kitti sample, scan order vs morton order"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+	std::cout<<"\t"<<pointvec.size()<<" points"<<std::endl;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<int> order;
+	std::vector<Point3f> reordered = pointvec;
+	morton_reorder(reordered, order);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tmorton reorder time: "<<duration.count()<<"s"<<std::endl;
+	for(int i=0; i<order.size(); ++i) for(int k=0; k<3; ++k) assert(reordered[i][k]==pointvec[order[i]][k]);
+
+	double radius = 0.1;
+	std::vector<Point3f> normalvec[2];
+	for(int reorder=0; reorder<2; ++reorder)
+	{
+		NormalEstimator<3, float> ne;
+		ne.set_pointcloud(pointvec);
+		ne.set_spatial_reorder(reorder);
+		start = std::chrono::high_resolution_clock::now();
+		normalvec[reorder] = ne.get_normals(radius);
+		end = std::chrono::high_resolution_clock::now();
+		duration = end-start;
+		std::cout<<"\tcompute time ("<<(reorder?"morton":"scan")<<" order): "<<duration.count()<<"s"<<std::endl;
+	}
+
+	// same neighborhoods, so normals are either both undefined or equal up to sign and rounding
+	int mismatches = 0;
+	for(int i=0; i<pointvec.size(); ++i)
+	{
+		Point3f& a = normalvec[0][i];
+		Point3f& b = normalvec[1][i];
+		float sq_norm = a.dot(a) + b.dot(b);
+		if(sq_norm > 0 && std::abs(a.dot(b)) < 0.99) ++mismatches;
+	}
+	std::cout<<"\tmismatched normals: "<<mismatches<<std::endl;
+	assert(mismatches==0);
+}
+
 void test_normal_estimation_kitti()
 {
 	std::cout<<"normal estimation - kitti sample"<<std::endl;
@@ -123,5 +198,7 @@ int main(int argc, char** argv)
 {
 	test_normal_estimation_plane();
 	test_normal_estimation_sphere();
+	test_geometric_features_plane();
+	test_spatial_reorder_kitti();
 	// test_normal_estimation_kitti();
 }
\ No newline at end of file
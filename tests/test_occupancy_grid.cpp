@@ -0,0 +1,564 @@
+#include "planning_lib/astar_planner.h"
+#include "planning_lib/map_loader.h"
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <cassert>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+
+/**
+* @brief write a synthetic map_server style map, free space with random rectangular obstacles and unknown border
+*
+* @return returns expected gray value of every pixel
+*/
+std::vector<unsigned char> write_synthetic_map(const std::string& name, int width, int height, int nobstacles)
+{
+	std::mt19937 gen(0);
+	std::vector<unsigned char> pixels(static_cast<size_t>(width)*height, 254);
+	std::uniform_int_distribution<> row(0, height-1), col(0, width-1), extent(5, 60);
+	for(int k=0; k<nobstacles; ++k)
+	{
+		int i0 = row(gen), j0 = col(gen), h = extent(gen), w = extent(gen);
+		for(int i=i0; i<std::min(height, i0+h); ++i) for(int j=j0; j<std::min(width, j0+w); ++j) pixels[static_cast<size_t>(i)*width+j] = 0;
+	}
+	for(int i=0; i<height; ++i)
+	{
+		for(int j=0; j<width; ++j)
+		{
+			if(i<2 || j<2 || i>=height-2 || j>=width-2) pixels[static_cast<size_t>(i)*width+j] = 205;
+		}
+	}
+
+	std::ofstream pgm((name+".pgm").c_str(), std::ios::binary);
+	pgm<<"P5\n# synthetic map\n"<<width<<" "<<height<<"\n255\n";
+	pgm.write((char *)pixels.data(), pixels.size());
+	std::ofstream yaml((name+".yaml").c_str());
+	size_t slash = name.find_last_of('/');
+	yaml<<"image: "<<name.substr(slash+1)<<".pgm\nresolution: 0.050000\norigin: [-10.000000, -20.000000, 0.000000]\nnegate: 0\n"
+		<<"occupied_thresh: 0.65\nfree_thresh: 0.196\n";
+	return pixels;
+}
+
+void test_map_loading()
+{
+	std::cout<<"map loading - synthetic 4000x4000 map"<<std::endl;
+	int width = 4000, height = 4000;
+	std::string name = "../data/synthetic_map";
+	std::vector<unsigned char> pixels = write_synthetic_map(name, width, height, 2000);
+
+	OccupancyGrid2d map;
+	auto start = std::chrono::high_resolution_clock::now();
+	bool loaded = load_map(name+".yaml", map);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	assert(loaded);
+	std::cout<<"\tload time: "<<duration.count()<<"s, "<<map.memory_bytes()<<" bytes ("
+		<<static_cast<size_t>(width)*height*sizeof(int)<<" bytes with int cells)"<<std::endl;
+	assert(map.get_width()==width && map.get_height()==height);
+	assert(map.get_resolution()==0.05f);
+	for(int i=0; i<height; ++i)
+	{
+		for(int j=0; j<width; ++j)
+		{
+			unsigned char p = pixels[static_cast<size_t>(i)*width+j];
+			int expected = (p==0)?100:(p==254)?0:-1;
+			assert(map(i, j)==expected);
+		}
+	}
+
+	// bitmap collision checks agree with the cells
+	start = std::chrono::high_resolution_clock::now();
+	map.set_use_bitmap(true);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tbitmap build time: "<<duration.count()<<"s, "<<map.memory_bytes()<<" bytes with bitmap"<<std::endl;
+	for(int i=0; i<height; i+=7) for(int j=0; j<width; ++j) assert(map.is_free(i, j)==(map(i, j)==0));
+
+	// hand off to a planner without copying
+	AstarPlanner2d planner;
+	start = std::chrono::high_resolution_clock::now();
+	planner.set_map(std::move(map));
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tset_map (move) time: "<<duration.count()<<"s"<<std::endl;
+	assert(planner.get_map().get_width()==width);
+
+	// int cells are converted, as before
+	std::vector<int> int_cells(static_cast<size_t>(width)*height, 0);
+	start = std::chrono::high_resolution_clock::now();
+	planner.set_map(int_cells, 0.05, width, height, Point2f({0, 0}));
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tset_map (int cells copy) time: "<<duration.count()<<"s"<<std::endl;
+
+	std::remove((name+".pgm").c_str());
+	std::remove((name+".yaml").c_str());
+}
+
+void test_distance_transform()
+{
+	std::cout<<"distance transform - random 120x90 map against brute force"<<std::endl;
+	int width = 120, height = 90;
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<> cell(0, 99);
+	std::vector<int> cells(width*height);
+	for(int& c: cells)
+	{
+		int r = cell(gen);
+		c = (r<3)?100:(r<4)?-1:0;
+	}
+	OccupancyGrid2d map;
+	map.set(cells, 0.05, width, height, Point2f({0, 0}));
+	map.set_inflation(0.1, 0.5);
+	for(int i=0; i<height; ++i)
+	{
+		for(int j=0; j<width; ++j)
+		{
+			// unknown cells count as obstacles, like in is_free
+			float best = std::numeric_limits<float>::infinity();
+			for(int c=0; c<width*height; ++c)
+			{
+				if(cells[c]==0) continue;
+				float di = i-c/width, dj = j-c%width;
+				best = std::min(best, std::sqrt(di*di+dj*dj));
+			}
+			assert(std::abs(map.distance(i, j)-best*0.05f) < 1e-5);
+			int site = map.nearest_obstacle(i, j);
+			assert(cells[site]!=0);
+			float d = map.distance(i, j);
+			uint8_t cost = map.cost(i, j);
+			if(cells[i*width+j]!=0) assert(cost==OccupancyGrid2d::obstacle_cost && !map.is_traversable(i, j));
+			else if(d < 0.1) assert(cost==OccupancyGrid2d::inscribed_cost && !map.is_traversable(i, j));
+			else if(d > 0.5) assert(cost==0 && map.is_traversable(i, j));
+			else assert(cost<=253 && map.is_traversable(i, j));
+		}
+	}
+
+	// no obstacles, every cell is infinitely far
+	std::vector<int> empty(width*height, 0);
+	map.set(empty, 0.05, width, height, Point2f({0, 0}));
+	assert(map.nearest_obstacle(10, 10)==-1 && std::isinf(map.distance(10, 10)) && map.cost(10, 10)==0);
+
+	std::cout<<"distance transform - synthetic 4000x4000 map"<<std::endl;
+	width = 4000;
+	height = 4000;
+	std::string name = "../data/synthetic_map";
+	write_synthetic_map(name, width, height, 2000);
+	bool loaded = load_map(name+".yaml", map);
+	assert(loaded);
+	auto start = std::chrono::high_resolution_clock::now();
+	map.set_inflation(0.3, 1.0);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tdistance transform and inflation time: "<<duration.count()<<"s, "<<map.memory_bytes()<<" bytes"<<std::endl;
+	// sampled brute force check around a few cells
+	std::uniform_int_distribution<> row(0, height-1), col(0, width-1);
+	for(int k=0; k<200; ++k)
+	{
+		int i = row(gen), j = col(gen);
+		float d = map.distance(i, j)/0.05f;
+		int r = static_cast<int>(d)+1;
+		float best = std::numeric_limits<float>::infinity();
+		for(int a=std::max(0, i-r); a<=std::min(height-1, i+r); ++a)
+		{
+			for(int b=std::max(0, j-r); b<=std::min(width-1, j+r); ++b)
+			{
+				if(!map.is_free(a, b)) best = std::min(best, std::sqrt(float((a-i)*(a-i)+(b-j)*(b-j))));
+			}
+		}
+		assert(std::abs(best-d) < 1e-3);
+	}
+	std::remove((name+".pgm").c_str());
+	std::remove((name+".yaml").c_str());
+}
+
+/// @brief largest difference in cells between the incrementally updated distances of map and a full recompute
+float max_distance_error(OccupancyGrid2d& map)
+{
+	int width = map.get_width(), height = map.get_height();
+	std::vector<int8_t> cells(static_cast<size_t>(width)*height);
+	for(int i=0; i<height; ++i) for(int j=0; j<width; ++j) cells[static_cast<size_t>(i)*width+j] = map(i, j);
+	OccupancyGrid2d full;
+	full.set(std::move(cells), map.get_resolution(), width, height, Point2f({0, 0}));
+	full.set_inflation(0.1, 0.5);
+	float max_error = 0;
+	for(int i=0; i<height; ++i)
+	{
+		for(int j=0; j<width; ++j)
+		{
+			float d = map.distance(i, j), expected = full.distance(i, j);
+			if(std::isinf(expected)) assert(std::isinf(d));
+			else max_error = std::max(max_error, (d-expected)/map.get_resolution());
+			assert(d >= expected-1e-5);
+			assert(map.is_free(i, j)==full.is_free(i, j));
+		}
+	}
+	return max_error;
+}
+
+void test_incremental_updates()
+{
+	std::cout<<"incremental updates - random obstacles added and removed on a 300x300 map"<<std::endl;
+	int width = 300, height = 300;
+	std::mt19937 gen(2);
+	std::uniform_int_distribution<> pos(0, width-1), extent(1, 20);
+	std::vector<int> cells(width*height, 0);
+	OccupancyGrid2d map;
+	map.set(cells, 0.05, width, height, Point2f({0, 0}));
+	map.set_inflation(0.1, 0.5);
+	float max_error = 0;
+	for(int round=0; round<30; ++round)
+	{
+		// a few rectangles toggled per round, obstacles appear and disappear
+		for(int k=0; k<3; ++k)
+		{
+			int i0 = pos(gen), j0 = pos(gen), h = extent(gen), w = extent(gen);
+			int8_t value = (gen()%3==0)?0:100;
+			for(int i=i0; i<std::min(height, i0+h); ++i) for(int j=j0; j<std::min(width, j0+w); ++j) map.set_cell(i, j, value);
+		}
+		// scattered single cells, where propagating nearest obstacles through neighbors is most likely to miss the exact one
+		for(int k=0; k<50; ++k) map.set_cell(pos(gen), pos(gen), (gen()%2)?100:0);
+		map.update_inflation_incremental();
+		max_error = std::max(max_error, max_distance_error(map));
+	}
+	std::cout<<"\tmax distance error against full recompute: "<<max_error<<" cells"<<std::endl;
+	// incremental distances are never smaller than exact ones and at most slightly larger
+	assert(max_error < 0.1);
+
+	std::cout<<"incremental updates - door opening and closing on a synthetic 4000x4000 map"<<std::endl;
+	width = 4000;
+	height = 4000;
+	std::string name = "../data/synthetic_map";
+	write_synthetic_map(name, width, height, 2000);
+	bool loaded = load_map(name+".yaml", map);
+	assert(loaded);
+	auto start = std::chrono::high_resolution_clock::now();
+	map.set_inflation(0.3, 1.0);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> full_duration = end-start;
+
+	// 1m wide door in a free area
+	int di = 2000, dj = 2000;
+	map.clear_dirty_region();
+	start = std::chrono::high_resolution_clock::now();
+	for(int i=di; i<di+4; ++i) for(int j=dj; j<dj+20; ++j) map.set_cell(i, j, 100);
+	map.update_inflation_incremental();
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> close_duration = end-start;
+	int i_min, j_min, i_max, j_max;
+	bool dirty = map.get_dirty_region(i_min, j_min, i_max, j_max);
+	assert(dirty);
+	std::cout<<"\tdirty region after closing: ["<<i_min<<", "<<i_max<<"] x ["<<j_min<<", "<<j_max<<"]"<<std::endl;
+	assert(i_min<=di && j_min<=dj && i_max>=di+3 && j_max>=dj+19);
+	assert(map.distance(di, dj)==0 && map.cost(di+1, dj+1)==OccupancyGrid2d::obstacle_cost);
+
+	start = std::chrono::high_resolution_clock::now();
+	for(int i=di; i<di+4; ++i) for(int j=dj; j<dj+20; ++j) map.set_cell(i, j, 0);
+	map.update_inflation_incremental();
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> open_duration = end-start;
+	std::cout<<"\tfull recompute: "<<full_duration.count()<<"s, close door: "<<close_duration.count()<<"s, open door: "
+		<<open_duration.count()<<"s"<<std::endl;
+	std::remove((name+".pgm").c_str());
+	std::remove((name+".yaml").c_str());
+}
+
+/// @brief range of a beam in a box shaped room centered at the origin with half size `half`
+float room_range(float angle, float half)
+{
+	float c = std::abs(std::cos(angle)), s = std::abs(std::sin(angle));
+	return std::min((c > 1e-6)?half/c:1e9f, (s > 1e-6)?half/s:1e9f);
+}
+
+void test_scan_integration()
+{
+	std::cout<<"scan integration - unknown 200x200 map, square room"<<std::endl;
+	int width = 200, height = 200;
+	std::vector<int> cells(width*height, -1);
+	OccupancyGrid2d map;
+	map.set(cells, 0.05, width, height, Point2f({-5, -5}));
+	map.set_inflation(0.1, 0.5);
+	float half = 3.0;
+	int nbeams = 720;
+	float increment = 2*M_PI/nbeams;
+	std::vector<float> ranges(nbeams);
+	for(int b=0; b<nbeams; ++b) ranges[b] = room_range(-M_PI+b*increment, half);
+	Point2f origin({0, 0});
+	auto start = std::chrono::high_resolution_clock::now();
+	int nscans = 5;
+	for(int k=0; k<nscans; ++k) map.integrate_scan(origin, 0, ranges, -M_PI, increment, 10.0);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\t"<<nscans<<" scans of "<<nbeams<<" beams: "<<duration.count()/nscans<<"s per scan"<<std::endl;
+
+	int i, j;
+	// sensor cell and the room inside are free, walls are occupied, outside stays unknown
+	map.xy_to_ij(0, 0, i, j);
+	assert(map(i, j)==0);
+	map.xy_to_ij(1.5, 0.5, i, j);
+	assert(map(i, j)==0);
+	map.xy_to_ij(half+0.01, 0.01, i, j);
+	assert(map(i, j)==100);
+	map.xy_to_ij(0.01, -half+0.01, i, j);
+	assert(map(i, j)==100);
+	map.xy_to_ij(4.5, 0, i, j);
+	assert(map(i, j)==-1);
+	float max_error = max_distance_error(map);
+	std::cout<<"\tmax distance error against full recompute: "<<max_error<<" cells"<<std::endl;
+	// incremental distances are never smaller than exact ones and at most slightly larger
+	assert(max_error < 0.1);
+}
+
+/// @brief world coordinates of the free cell nearest to (i,j) along its row, cell centers avoid rounding at cell borders
+Point2f free_cell_center(OccupancyGrid2d& map, int i, int j)
+{
+	while(!map.is_free(i, j)) ++j;
+	Point2f p;
+	map.ij_to_xy(i, j, p[0], p[1]);
+	float half = 0.5*map.get_resolution();
+	return Point2f({p[0]+half, p[1]+half});
+}
+
+void test_tiled_map()
+{
+	std::cout<<"tiled map - synthetic 4000x4000 map, 256x256 tiles, 8MB tile budget"<<std::endl;
+	int width = 4000, height = 4000;
+	std::string name = "../data/synthetic_map";
+	write_synthetic_map(name, width, height, 2000);
+	auto start = std::chrono::high_resolution_clock::now();
+	bool converted = convert_map_to_tiled(name+".yaml", name+".tmap", 256);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	assert(converted);
+	std::cout<<"\tconversion time: "<<duration.count()<<"s"<<std::endl;
+
+	OccupancyGrid2d dense;
+	bool loaded = load_map(name+".yaml", dense);
+	assert(loaded);
+	std::shared_ptr<MapTileStore> store(new MapTileStore(name+".tmap", 8*1024*1024));
+	OccupancyGrid2d tiled;
+	tiled.open_tiled(store);
+	assert(tiled.is_tiled() && tiled.get_width()==width && tiled.get_height()==height);
+	assert(tiled.get_resolution()==dense.get_resolution());
+	int i, j, ti, tj;
+	bool inside = dense.xy_to_ij(3.3, -7.1, i, j);
+	bool tiled_inside = tiled.xy_to_ij(3.3, -7.1, ti, tj);
+	assert(inside && tiled_inside && i==ti && j==tj);
+
+	// full row-major scans through is_free
+	size_t dense_free = 0, tiled_free = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for(int i=0; i<height; ++i) for(int j=0; j<width; ++j) dense_free += dense.is_free(i, j);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> dense_duration = end-start;
+	start = std::chrono::high_resolution_clock::now();
+	for(int i=0; i<height; ++i) for(int j=0; j<width; ++j) tiled_free += tiled.is_free(i, j);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tis_free scan: dense "<<dense_duration.count()<<"s, tiled "<<duration.count()<<"s, "<<store->num_loads()
+		<<" tile loads, "<<store->num_evictions()<<" evictions, "<<store->loaded_bytes()<<" bytes loaded"<<std::endl;
+	assert(dense_free==tiled_free);
+	assert(store->loaded_bytes() <= 8*1024*1024 && store->num_evictions() > 0);
+	for(int i=0; i<height; i+=3) for(int j=0; j<width; ++j) assert(tiled.value(i, j)==dense(i, j));
+
+	// writing a dense grid gives the same file as the streaming conversion
+	bool written = write_tiled_map(dense, name+"_dense.tmap", 256);
+	assert(written);
+	std::ifstream f1((name+".tmap").c_str(), std::ios::binary), f2((name+"_dense.tmap").c_str(), std::ios::binary);
+	std::string c1((std::istreambuf_iterator<char>(f1)), std::istreambuf_iterator<char>());
+	std::string c2((std::istreambuf_iterator<char>(f2)), std::istreambuf_iterator<char>());
+	assert(c1==c2);
+	std::remove((name+"_dense.tmap").c_str());
+	std::remove((name+".tmap").c_str());
+
+	std::cout<<"tiled map - A* planners sharing a store of a 1024x1024 map, 64x64 tiles"<<std::endl;
+	width = height = 1024;
+	write_synthetic_map(name, width, height, 300);
+	converted = convert_map_to_tiled(name+".yaml", name+".tmap", 64);
+	assert(converted);
+	loaded = load_map(name+".yaml", dense);
+	assert(loaded);
+	store.reset(new MapTileStore(name+".tmap", 256*1024));
+	AstarPlanner2d dense_planner, planner_a, planner_b;
+	dense_planner.set_map(std::move(dense));
+	planner_a.get_map().open_tiled(store);
+	planner_b.get_map().open_tiled(store);
+	Point2f p0 = free_cell_center(dense_planner.get_map(), 100, 100), p1 = free_cell_center(dense_planner.get_map(), 900, 850);
+
+	start = std::chrono::high_resolution_clock::now();
+	auto dense_path = dense_planner.compute_plan(p0, p1);
+	end = std::chrono::high_resolution_clock::now();
+	dense_duration = end-start;
+	start = std::chrono::high_resolution_clock::now();
+	auto path_a = planner_a.compute_plan(p0, p1);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	auto path_b = planner_b.compute_plan(p0, p1);
+	std::cout<<"\tA* path of "<<dense_path.size()<<" cells: dense "<<dense_duration.count()<<"s, tiled "<<duration.count()<<"s, "
+		<<store->num_loads()<<" tile loads"<<std::endl;
+	assert(!dense_path.empty());
+	assert(path_a.size()==dense_path.size() && path_b.size()==dense_path.size());
+	for(size_t k=0; k<dense_path.size(); ++k) assert(path_a[k][0]==dense_path[k][0] && path_a[k][1]==dense_path[k][1]);
+
+	// writes are copied into the writing grid only
+	OccupancyGrid2d& map_a = planner_a.get_map();
+	OccupancyGrid2d& map_b = planner_b.get_map();
+	map_b(500, 500) = 100;
+	map_b.set_cell(501, 500, 100);
+	assert(map_b.value(500, 500)==100 && !map_b.is_free(501, 500));
+	assert(map_a.value(500, 500)==dense_planner.get_map()(500, 500));
+	assert(map_a.value(501, 500)==dense_planner.get_map()(501, 500));
+	std::remove((name+".pgm").c_str());
+	std::remove((name+".yaml").c_str());
+	std::remove((name+".tmap").c_str());
+}
+
+/// @brief check every pyramid block against the cells it covers
+void check_pyramid(OccupancyGrid2d& map)
+{
+	int width = map.get_width(), height = map.get_height();
+	for(int k=1; k<=map.num_pyramid_levels(); ++k)
+	{
+		int size = 1<<k;
+		for(int bi=0; bi*size<height; ++bi)
+		{
+			for(int bj=0; bj*size<width; ++bj)
+			{
+				bool free = true;
+				for(int i=bi*size; i<std::min(height, (bi+1)*size); ++i)
+				{
+					for(int j=bj*size; j<std::min(width, (bj+1)*size); ++j) free = free && map.is_traversable(i, j);
+				}
+				assert(map.is_block_free(k, bi, bj)==free);
+			}
+		}
+	}
+}
+
+void test_pyramid()
+{
+	std::cout<<"pyramid - random 300x250 map against brute force"<<std::endl;
+	int width = 300, height = 250;
+	std::mt19937 gen(3);
+	std::uniform_int_distribution<> row(0, height-1), col(0, width-1), extent(1, 30);
+	std::vector<int> cells(width*height, 0);
+	for(int k=0; k<40; ++k)
+	{
+		int i0 = row(gen), j0 = col(gen), h = extent(gen), w = extent(gen);
+		for(int i=i0; i<std::min(height, i0+h); ++i) for(int j=j0; j<std::min(width, j0+w); ++j) cells[i*width+j] = 100;
+	}
+	OccupancyGrid2d map, plain;
+	map.set(cells, 0.05, width, height, Point2f({0, 0}));
+	plain.set(cells, 0.05, width, height, Point2f({0, 0}));
+	map.set_use_pyramid(true);
+	assert(map.num_pyramid_levels()==9);
+	check_pyramid(map);
+
+	// incremental updates of cells, then of the inflation layer
+	for(int k=0; k<200; ++k)
+	{
+		int i = row(gen), j = col(gen);
+		int8_t value = (gen()%2)?100:0;
+		map.set_cell(i, j, value);
+		plain.set_cell(i, j, value);
+	}
+	check_pyramid(map);
+	map.set_inflation(0.1, 0.3);
+	plain.set_inflation(0.1, 0.3);
+	check_pyramid(map);
+	for(int k=0; k<200; ++k)
+	{
+		int i = row(gen), j = col(gen);
+		int8_t value = (gen()%2)?100:0;
+		map.set_cell(i, j, value);
+		plain.set_cell(i, j, value);
+	}
+	map.update_inflation_incremental();
+	plain.update_inflation_incremental();
+	check_pyramid(map);
+
+	// ray casts with and without free block skipping hit the same cells
+	std::uniform_real_distribution<float> x(-0.5, height*0.05+0.5), y(-0.5, width*0.05+0.5);
+	int nblocked = 0;
+	for(int k=0; k<2000; ++k)
+	{
+		float x0 = x(gen), y0 = y(gen), x1 = x(gen), y1 = y(gen);
+		float t = map.ray_cast(x0, y0, x1, y1), t_plain = plain.ray_cast(x0, y0, x1, y1);
+		assert((t < 1)==(t_plain < 1) && std::abs(t-t_plain) < 1e-4);
+		nblocked += (t < 1);
+		// samples before the hit are in free cells, rays starting outside or in an obstacle stop at once
+		for(int s=0; t>0 && s<100; ++s)
+		{
+			float f = t*s/100.0f;
+			int i, j;
+			bool inside = map.xy_to_ij(x0+f*(x1-x0), y0+f*(y1-y0), i, j);
+			assert(inside && map.is_traversable(i, j));
+		}
+	}
+	std::cout<<"\t"<<nblocked<<" of 2000 rays blocked"<<std::endl;
+
+	std::cout<<"pyramid - ray casts on a synthetic 4000x4000 map"<<std::endl;
+	width = 4000;
+	height = 4000;
+	std::string name = "../data/synthetic_map";
+	write_synthetic_map(name, width, height, 300);
+	map.clear_inflation();
+	plain.clear_inflation();
+	plain.set_use_pyramid(false);
+	bool loaded = load_map(name+".yaml", map);
+	assert(loaded);
+	loaded = load_map(name+".yaml", plain);
+	assert(loaded);
+	auto start = std::chrono::high_resolution_clock::now();
+	map.set_use_pyramid(true);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tpyramid build time: "<<duration.count()<<"s, "<<map.num_pyramid_levels()<<" levels, "<<map.memory_bytes()
+		<<" bytes"<<std::endl;
+	// rays of up to 20m from random free cells
+	std::uniform_real_distribution<float> mx(-9.9, 189.9), my(-19.9, 179.9), offset(-20, 20);
+	std::vector<float> rays;
+	while(rays.size() < 4*10000)
+	{
+		float x0 = mx(gen), y0 = my(gen);
+		int i, j;
+		if(!map.xy_to_ij(x0, y0, i, j) || !map.is_free(i, j)) continue;
+		float values[4] = {x0, y0, x0+offset(gen), y0+offset(gen)};
+		rays.insert(rays.end(), values, values+4);
+	}
+	double sum = 0, sum_plain = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for(size_t r=0; r<rays.size(); r+=4) sum += map.ray_cast(rays[r], rays[r+1], rays[r+2], rays[r+3]);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	start = std::chrono::high_resolution_clock::now();
+	for(size_t r=0; r<rays.size(); r+=4) sum_plain += plain.ray_cast(rays[r], rays[r+1], rays[r+2], rays[r+3]);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> plain_duration = end-start;
+	std::cout<<"\t10000 rays: "<<duration.count()<<"s with pyramid, "<<plain_duration.count()<<"s cell by cell"<<std::endl;
+	assert(std::abs(sum-sum_plain) < 1e-2);
+
+	// a new obstacle blocks a ray that was free
+	map.set_cell(2000, 2000, 100);
+	float x0, y0;
+	map.ij_to_xy(2000, 1900, x0, y0);
+	bool free_before = true;
+	for(int j=1900; j<=2100; ++j) free_before = free_before && plain.is_free(2000, j);
+	if(free_before) assert(map.ray_cast(x0+0.025, y0+0.025, x0+0.025, y0+10.025) < 1);
+	std::remove((name+".pgm").c_str());
+	std::remove((name+".yaml").c_str());
+}
+
+int main(int argc, char** argv)
+{
+	test_map_loading();
+	test_distance_transform();
+	test_incremental_updates();
+	test_scan_integration();
+	test_tiled_map();
+	test_pyramid();
+}
@@ -0,0 +1,76 @@
+#include "pointcloud_lib/outlier_filter.h"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+void test_outlier_filters_synthetic()
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	std::uniform_real_distribution<float> distrib(-1.0, 1.0);
+
+	// dense cube of points and a few isolated points far away from it
+	std::vector<Point3f> pointvec;
+	for(int i=0; i<2000; ++i) pointvec.push_back(Point3f({distrib(gen), distrib(gen), distrib(gen)}));
+	for(int i=0; i<5; ++i) pointvec.push_back(Point3f({10.0f*(i+1), 10.0f, 10.0f}));
+
+	StatisticalOutlierFilter<float> sor(10, 1.0);
+	std::vector<char> keep;
+	sor.filter(pointvec, keep);
+	for(int i=2000; i<2005; ++i) assert(!keep[i]);
+
+	RadiusOutlierFilter<float> ror(0.5, 2);
+	ror.filter(pointvec, keep);
+	for(int i=0; i<2000; ++i) assert(keep[i]);
+	for(int i=2000; i<2005; ++i) assert(!keep[i]);
+	std::cout<<"outlier filters test for isolated points passed"<<std::endl;
+}
+
+void test_outlier_filters_kitti()
+{
+	std::cout<<"outlier filters - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+	std::cout<<"\t"<<pointvec.size()<<" points"<<std::endl;
+
+	StatisticalOutlierFilter<float> sor(10, 2.0);
+	std::vector<char> keep;
+	auto start = std::chrono::high_resolution_clock::now();
+	sor.filter(pointvec, keep);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tstatistical filter compute time: "<<duration.count()<<"s, "<<mask_to_indices(keep).size()<<" points kept"<<std::endl;
+
+	RadiusOutlierFilter<float> ror(0.3, 2);
+	start = std::chrono::high_resolution_clock::now();
+	ror.filter(pointvec, keep);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\tradius filter compute time: "<<duration.count()<<"s, "<<mask_to_indices(keep).size()<<" points kept"<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_outlier_filters_synthetic();
+	test_outlier_filters_kitti();
+}
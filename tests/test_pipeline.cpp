@@ -0,0 +1,225 @@
+#include "common/pipeline.h"
+#include "pointcloud_lib/voxel_grid_filter.h"
+#include "pointcloud_lib/plane_extractor.h"
+#include "pointcloud_lib/normal_estimator.h"
+#include "pointcloud_lib/euclidean_cluster_extractor.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+
+void read_kitti_bin(const std::string& binfile, std::vector<Point3f>& pointvec)
+{
+	pointvec.clear();
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+}
+
+void test_bounded_queue()
+{
+	BoundedQueue<int> queue(64);
+	int nproducers = 3, nconsumers = 3, per_producer = 20000;
+	std::atomic<long long> sum(0);
+	std::atomic<int> popped(0);
+	std::vector<std::thread> threads;
+	for(int p=0; p<nproducers; ++p)
+	{
+		threads.emplace_back([&queue, p, per_producer]() {
+			for(int i=1; i<=per_producer; ++i) queue.push(p*per_producer+i);
+		});
+	}
+	for(int c=0; c<nconsumers; ++c)
+	{
+		threads.emplace_back([&]() {
+			int value;
+			while(popped.load() < nproducers*per_producer)
+			{
+				if(queue.try_pop(value))
+				{
+					sum += value;
+					++popped;
+				}
+				else std::this_thread::yield();
+			}
+		});
+	}
+	for(std::thread& t: threads) t.join();
+	long long n = static_cast<long long>(nproducers)*per_producer;
+	assert(popped.load()==n);
+	assert(sum.load()==n*(n+1)/2);
+	std::cout<<"bounded queue multi-producer multi-consumer test passed"<<std::endl;
+}
+
+void test_bounded_queue_blocking()
+{
+	// small queue so that producers sleep while it is full and consumers while it is empty
+	BoundedQueue<int> queue(4);
+	int nproducers = 3, nconsumers = 3, per_producer = 20000;
+	std::atomic<long long> sum(0);
+	std::atomic<int> popped(0);
+	std::vector<std::thread> producers, consumers;
+	for(int p=0; p<nproducers; ++p)
+	{
+		producers.emplace_back([&queue, p, per_producer]() {
+			for(int i=1; i<=per_producer; ++i) queue.push(p*per_producer+i);
+		});
+	}
+	for(int c=0; c<nconsumers; ++c)
+	{
+		consumers.emplace_back([&]() {
+			int value;
+			while(queue.pop(value))
+			{
+				sum += value;
+				++popped;
+			}
+		});
+	}
+	for(std::thread& t: producers) t.join();
+	queue.close();
+	for(std::thread& t: consumers) t.join();
+	long long n = static_cast<long long>(nproducers)*per_producer;
+	assert(popped.load()==n);
+	assert(sum.load()==n*(n+1)/2);
+	std::cout<<"bounded queue blocking push/pop and close test passed"<<std::endl;
+}
+
+void test_pipeline_order()
+{
+	// single worker stages keep frame order, frames are recycled from a pool of 3
+	Pipeline< std::vector<int> > pipeline(3);
+	int next = 0, nframes = 50;
+	std::vector<int> out;
+	pipeline.set_source("source", [&next, nframes](std::vector<int>& frame) {
+		if(next==nframes) return false;
+		frame.assign(1, next++);
+		return true;
+	});
+	pipeline.add_stage("double", [](std::vector<int>& frame) { frame.push_back(2*frame[0]); });
+	pipeline.add_stage("sink", [&out](std::vector<int>& frame) { out.push_back(frame[1]); });
+	pipeline.run();
+	assert(pipeline.num_frames()==nframes);
+	assert(out.size()==nframes);
+	for(int i=0; i<nframes; ++i) assert(out[i]==2*i);
+	assert(pipeline.stage_latency(0).count()==nframes);
+	std::cout<<"pipeline frame order test passed"<<std::endl;
+}
+
+/// @brief per-frame buffers, recycled by the pipeline
+struct LidarFrame
+{
+	int id;
+	std::vector<Point3f> points;
+	std::vector<Point3f> downsampled;
+	std::vector<Point3f> ground;
+	std::vector<Point3f> other;
+	std::vector<Point3f> normals;
+	std::vector<int> labels;
+	int num_clusters;
+};
+
+void load_frame(LidarFrame& frame)
+{
+	read_kitti_bin("../data/0000000000.bin", frame.points);
+}
+
+void downsample_frame(LidarFrame& frame)
+{
+	VoxelGridFilter<float> vgf(0.3);
+	frame.downsampled = vgf.filter(frame.points);
+}
+
+void remove_ground(LidarFrame& frame)
+{
+	PlaneExtractor<float> pe;
+	pe.set_seed(frame.id);
+	auto points_pair = pe.extract_plane(frame.downsampled, 100, 0.3);
+	frame.ground.swap(points_pair.first);
+	frame.other.swap(points_pair.second);
+}
+
+void estimate_normals(LidarFrame& frame)
+{
+	NormalEstimator<3, float> ne;
+	ne.set_pointcloud(frame.other);
+	frame.normals = ne.get_normals(0.5);
+}
+
+void cluster_frame(LidarFrame& frame)
+{
+	EuclideanClusterExtractor<float> ce(0.5, 10);
+	frame.num_clusters = ce.extract(frame.other, frame.labels).size();
+}
+
+void print_histogram(const std::string& name, const LatencyHistogram& hist)
+{
+	std::cout<<"\t"<<name<<": "<<hist.count()<<" frames, mean "<<hist.mean()<<"s, p50 "<<hist.percentile(50)<<"s, p99 "
+		<<hist.percentile(99)<<"s"<<std::endl;
+}
+
+void test_lidar_pipeline_kitti()
+{
+	std::cout<<"lidar pipeline - kitti sample"<<std::endl;
+	int nframes = 6;
+
+	// sequential baseline
+	std::vector<int> sequential_clusters;
+	LidarFrame frame;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(int i=0; i<nframes; ++i)
+	{
+		frame.id = i;
+		load_frame(frame);
+		downsample_frame(frame);
+		remove_ground(frame);
+		estimate_normals(frame);
+		cluster_frame(frame);
+		sequential_clusters.push_back(frame.num_clusters);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tsequential: "<<nframes/duration.count()<<" frames/s"<<std::endl;
+
+	Pipeline<LidarFrame> pipeline(4);
+	int next = 0;
+	std::vector<int> pipelined_clusters(nframes, -1);
+	pipeline.set_source("load", [&next, nframes](LidarFrame& frame) {
+		if(next==nframes) return false;
+		frame.id = next++;
+		load_frame(frame);
+		return true;
+	});
+	pipeline.add_stage("downsample", downsample_frame);
+	pipeline.add_stage("ground removal", remove_ground);
+	// slowest stage gets two workers, frames may leave it out of order
+	pipeline.add_stage("normals", estimate_normals, 2);
+	pipeline.add_stage("clustering", cluster_frame);
+	pipeline.add_stage("output", [&pipelined_clusters](LidarFrame& frame) { pipelined_clusters[frame.id] = frame.num_clusters; });
+	pipeline.run();
+	std::cout<<"\tpipelined: "<<pipeline.throughput()<<" frames/s ("<<std::thread::hardware_concurrency()<<" hardware threads)"<<std::endl;
+	print_histogram(pipeline.stage_name(-1), pipeline.stage_latency(-1));
+	for(int s=0; s<pipeline.num_stages(); ++s) print_histogram(pipeline.stage_name(s), pipeline.stage_latency(s));
+	print_histogram("end to end", pipeline.end_to_end_latency());
+
+	// same seeds per frame, so same results as sequential processing
+	assert(pipeline.num_frames()==nframes);
+	assert(pipelined_clusters==sequential_clusters);
+}
+
+int main(int argc, char** argv)
+{
+	test_bounded_queue();
+	test_bounded_queue_blocking();
+	test_pipeline_order();
+	test_lidar_pipeline_kitti();
+}
@@ -1,7 +1,9 @@
 #include "pointcloud_lib/plane_extractor.h"
+#include "pointcloud_lib/normal_estimator.h"
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <cassert>
 
 std::vector<Point3f> read_kitti_bin(const std::string& binfile)
 {
@@ -51,6 +53,7 @@ void test_plane_extraction()
 	auto end = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<double> duration = end-start;
 	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
+	std::cout<<"\tRANSAC iterations: "<<pe.get_num_iterations()<<", plane points: "<<points_pair.first.size()<<std::endl;
 
 	std::string outfile = "../data/0000000000_plane_points.bin";
 	save_bin(points_pair.first, outfile);
@@ -61,7 +64,86 @@ void test_plane_extraction()
 	std::cout<<"\tother points saved to "<<outfile<<std::endl;
 }
 
+void test_multi_plane_extraction()
+{
+	std::cout<<"multi plane extraction - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+
+	PlaneExtractor<float> pe;
+	std::vector<int> labels;
+	auto start = std::chrono::high_resolution_clock::now();
+	auto planes = pe.extract_planes(pointvec, 5, 1000, 100, 0.2, labels);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tcompute time: "<<duration.count()<<"s, RANSAC iterations: "<<pe.get_num_iterations()<<std::endl;
+
+	std::vector<int> support(planes.size(), 0);
+	for(auto label: labels) if(label>=0) ++support[label];
+	for(int i=0; i<planes.size(); ++i)
+	{
+		std::cout<<"\tplane "<<i<<" - normal: ("<<planes[i][0]<<","<<planes[i][1]<<","<<planes[i][2]<<"), d: "<<planes[i][3]
+			<<", points: "<<support[i]<<std::endl;
+		assert(support[i]>=1000);
+	}
+
+	std::string outfile = "../data/0000000000_plane_labels.bin";
+	std::ofstream f(outfile.c_str(), std::ios::binary);
+	f.write((char *)labels.data(), labels.size()*sizeof(int));
+	f.close();
+	std::cout<<"\tplane labels saved to "<<outfile<<std::endl;
+}
+
+void test_ransac_strategies()
+{
+	std::cout<<"ransac strategies - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+
+	// PROSAC quality: planarity of the local neighborhood weighted by agreement of local normal with the vertical
+	auto start = std::chrono::high_resolution_clock::now();
+	NormalEstimator<3, float> ne;
+	ne.set_pointcloud(pointvec);
+	const GeometricFeatures<float>& features = ne.get_features(0.25);
+	std::vector<Point3f> normalvec = ne.get_normals(0.25);
+	std::vector<float> quality(pointvec.size());
+	for(int i=0; i<pointvec.size(); ++i) quality[i] = features.planarity[i]*std::abs(normalvec[i][2]);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tquality compute time: "<<duration.count()<<"s"<<std::endl;
+
+	std::vector< std::pair<std::string, RansacStrategy> > strategies = {
+		{"standard", RansacStrategy::STANDARD}, 
+		{"T(1,1)", RansacStrategy::TDD}, 
+		{"preemptive", RansacStrategy::PREEMPTIVE}, 
+		{"prosac", RansacStrategy::PROSAC}
+	};
+	int nruns = 10;
+	for(auto& strategy: strategies)
+	{
+		PlaneExtractor<float> pe;
+		pe.set_strategy(strategy.second);
+		pe.set_point_quality(quality);
+		double total_time = 0.0, total_iterations = 0.0, total_points = 0.0;
+		for(int run=0; run<nruns; ++run)
+		{
+			pe.set_seed(run);
+			start = std::chrono::high_resolution_clock::now();
+			auto points_pair = pe.extract_plane(pointvec, 100, 0.3);
+			end = std::chrono::high_resolution_clock::now();
+			duration = end-start;
+			total_time += duration.count();
+			total_iterations += pe.get_num_iterations();
+			total_points += points_pair.first.size();
+		}
+		std::cout<<"\t"<<strategy.first<<" - mean compute time: "<<total_time/nruns<<"s, mean iterations: "<<total_iterations/nruns
+			<<", mean plane points: "<<total_points/nruns<<std::endl;
+	}
+}
+
 int main(int argc, char** argv)
 {
 	test_plane_extraction();
+	test_multi_plane_extraction();
+	test_ransac_strategies();
 }
\ No newline at end of file
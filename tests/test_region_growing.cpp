@@ -0,0 +1,86 @@
+#include "pointcloud_lib/region_growing_segmenter.h"
+#include "pointcloud_lib/voxel_grid_filter.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+void test_region_growing_planes()
+{
+	// floor z=0 and wall x=0 sampled on 0.1 m grids, the wall starts 0.5 m away from the floor edge
+	std::vector<Point3f> pointvec;
+	for(int i=0; i<40; ++i)
+	{
+		for(int j=0; j<40; ++j) pointvec.push_back(Point3f({1.0f+0.1f*i, 0.1f*j, 0.0f}));
+	}
+	for(int i=0; i<40; ++i)
+	{
+		for(int j=0; j<40; ++j) pointvec.push_back(Point3f({0.0f, 0.1f*j, 0.5f+0.1f*i}));
+	}
+
+	RegionGrowingSegmenter<float> rg(0.25, 0.1, 0.05);
+	rg.set_region_size(100, 100000);
+	std::vector<int> labels;
+	int nregions = rg.segment(pointvec, labels);
+	assert(nregions==2);
+	for(int i=1; i<1600; ++i) assert(labels[i]==labels[0]);
+	for(int i=1601; i<3200; ++i) assert(labels[i]==labels[1600]);
+	assert(labels[0]!=labels[1600]);
+	std::cout<<"region growing test for 2 planes passed"<<std::endl;
+}
+
+void test_region_growing_kitti()
+{
+	std::cout<<"region growing - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+
+	VoxelGridFilter<float> filter(0.2);
+	std::vector<int> point_to_voxel;
+	std::vector<Point3f> filtered = filter.filter(pointvec, point_to_voxel);
+	std::cout<<"\t"<<filtered.size()<<" points after voxel grid filter"<<std::endl;
+
+	RegionGrowingSegmenter<float> rg(0.5, 0.15, 0.05);
+	rg.set_region_size(50, 1000000);
+	std::vector<int> labels;
+	auto start = std::chrono::high_resolution_clock::now();
+	int nregions = rg.segment(filtered, labels);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
+	std::cout<<"\t"<<nregions<<" regions"<<std::endl;
+
+	// map region labels back to the full pointcloud
+	std::vector<int> full_labels(pointvec.size());
+	for(int i=0; i<pointvec.size(); ++i) full_labels[i] = labels[point_to_voxel[i]];
+
+	std::string outfile = "../data/0000000000_region_labels.bin";
+	std::ofstream f(outfile.c_str(), std::ios::binary);
+	f.write((char *)full_labels.data(), full_labels.size()*sizeof(int));
+	f.close();
+	std::cout<<"\tregion labels saved to "<<outfile<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_region_growing_planes();
+	test_region_growing_kitti();
+}
@@ -1,60 +1,9 @@
 #include "planning_lib/rrt_planner.h"
+#include "planning_lib/map_loader.h"
 #include <iostream>
 #include <chrono>
 #include <fstream>
-#include <sstream>
-
-struct Map_Data
-{
-	std::vector<unsigned char> data;
-	int width;
-	int height;
-	int max_val;
-};
-
-Map_Data read_pgm(std::string mapfile)
-{
-	Map_Data map_data;
-
-	std::ifstream f(mapfile.c_str(), std::ios::binary);
-	std::stringstream ss;
-	std::string line = "";
-
-	getline(f, line);
-	// std::cout<<line<<std::endl;
-
-	getline(f, line);
-	// std::cout<<line<<std::endl;
-
-	ss << f.rdbuf();
-	ss >> map_data.width >> map_data.height >> map_data.max_val;
-	
-	map_data.data.resize(map_data.width*map_data.height);
-	for(int i=0; i<map_data.height; ++i)
-	{
-		for(int j=0; j<map_data.width; ++j)
-		{
-			ss >> map_data.data[i*map_data.width+j];
-		}
-	}
-
-	return map_data;
-}
-
-std::vector<int> raw_pgm_to_occupancy_data(Map_Data& map_data, float occupied_thresh, float free_thresh)
-{
-	std::vector<int> occ_data(map_data.width*map_data.height, -1);
-	for(int i=0; i<map_data.height; ++i)
-	{
-		for(int j=0; j<map_data.width; ++j)
-		{
-			float prob = float(255-int(map_data.data[i*map_data.width+j]))/255.0;
-			if(prob > occupied_thresh) occ_data[i*map_data.width+j] = 100;
-			else if(prob < free_thresh) occ_data[i*map_data.width+j] = 0;
-		}
-	}
-	return occ_data;
-}
+#include <cassert>
 
 void save_path_as_bin(std::vector<Point2f>& path, std::string outfile)
 {
@@ -73,28 +22,59 @@ void save_path_as_bin(std::vector<Point2f>& path, std::string outfile)
 void test_rrt()
 {
 	std::cout<<"rrt on known map"<<std::endl;
-	Map_Data map_data = read_pgm("../data/map.pgm");
-	float occupied_thresh = 0.65, free_thresh = 0.196;
-	auto occ_data = raw_pgm_to_occupancy_data(map_data, occupied_thresh, free_thresh);
+	OccupancyGrid2d map;
+	auto start_t = std::chrono::high_resolution_clock::now();
+	if(!load_map("../data/map.yaml", map))
+	{
+		std::cout<<"\tcould not load ../data/map.yaml"<<std::endl;
+		return;
+	}
+	auto end_t = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end_t-start_t;
+	std::cout<<"\tmap load time: "<<duration.count()<<"s"<<std::endl;
 
 	RRTPlanner2d planner;
-
-	float resolution = 0.02;
-	Point2f origin({-33.0, -39.4});
-	planner.set_map(occ_data, resolution, map_data.width, map_data.height, origin);
+	planner.set_map(std::move(map));
 
 	Point2f start({11.0, -9.4});
 	Point2f goal({7.0, -5.4});
-	auto start_t = std::chrono::high_resolution_clock::now();
+	start_t = std::chrono::high_resolution_clock::now();
 	auto path = planner.compute_plan(start, goal);
-	auto end_t = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> duration = end_t-start_t;
+	end_t = std::chrono::high_resolution_clock::now();
+	duration = end_t-start_t;
 	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
 
 	save_path_as_bin(path, "../data/map_path.bin");
 }
 
+void test_rrt_pyramid()
+{
+	std::cout<<"rrt with map pyramid - synthetic 200x200 map, wall with a 1m gap"<<std::endl;
+	int width = 200, height = 200;
+	std::vector<int> cells(width*height, 0);
+	for(int j=0; j<width; ++j) if(j<90 || j>=110) for(int i=98; i<102; ++i) cells[i*width+j] = 100;
+
+	RRTPlanner2d planner;
+	planner.set_map(cells, 0.05, width, height, Point2f({0, 0}));
+	planner.get_map().set_use_pyramid(true);
+
+	Point2f start({2.5, 1.0});
+	Point2f goal({7.5, 1.0});
+	auto start_t = std::chrono::high_resolution_clock::now();
+	auto path = planner.compute_plan(start, goal);
+	auto end_t = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end_t-start_t;
+	std::cout<<"\tcompute time: "<<duration.count()<<"s, "<<path.size()<<" waypoints"<<std::endl;
+	assert(!path.empty());
+	// path runs from goal to start, tree edges don't cross the wall
+	for(size_t k=2; k<path.size(); ++k)
+	{
+		assert(planner.get_map().ray_cast(path[k-1][0], path[k-1][1], path[k][0], path[k][1])==1);
+	}
+}
+
 int main(int argc, char** argv)
 {
 	test_rrt();
+	test_rrt_pyramid();
 }
\ No newline at end of file
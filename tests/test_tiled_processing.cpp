@@ -0,0 +1,185 @@
+#include "pointcloud_lib/tiled_pointcloud.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+template<class Result>
+std::vector<Result> read_results(const std::string& binfile)
+{
+	std::ifstream f(binfile.c_str(), std::ios::binary | std::ios::ate);
+	std::vector<Result> results(static_cast<size_t>(f.tellg())/sizeof(Result));
+	f.seekg(0);
+	f.read((char *)results.data(), results.size()*sizeof(Result));
+	return results;
+}
+
+/// @brief field of /proc/self/status in kB, e.g. "VmHWM:" for the peak and "VmRSS:" for the current resident set size
+long status_kb(const std::string& key)
+{
+	std::ifstream f("/proc/self/status");
+	std::string line;
+	while(std::getline(f, line))
+	{
+		if(line.compare(0, key.size(), key)==0) return std::stol(line.substr(key.size()));
+	}
+	return -1;
+}
+
+long peak_rss_kb()
+{
+	return status_kb("VmHWM:");
+}
+
+void test_tiled_processing_kitti()
+{
+	std::cout<<"tiled processing - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	double radius = 0.1;
+
+	// whole pointcloud is not loaded before tiled processing, so peak RSS reflects the tiled pipeline
+	long baseline_kb = status_kb("VmRSS:");
+	size_t memory_limit = 8<<20;
+	TiledPointCloud<float> cloud("../data/0000000000_tiles", 20.0, 0.5);
+	cloud.set_memory_limit(memory_limit);
+	auto start = std::chrono::high_resolution_clock::now();
+	cloud.build_from_bin(binfile);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	uint64_t num_core = 0, max_tile_points = 0;
+	for(int t=0; t<cloud.num_tiles(); ++t)
+	{
+		num_core += cloud.tile(t).num_core;
+		max_tile_points = std::max(max_tile_points, cloud.tile(t).num_core+cloud.tile(t).num_margin);
+	}
+	std::cout<<"\t"<<cloud.size()<<" points in "<<cloud.num_tiles()<<" tiles, largest tile "<<max_tile_points<<" points (limit "
+		<<cloud.get_max_tile_points()<<")"<<std::endl;
+	std::cout<<"\ttiling time: "<<duration.count()<<"s"<<std::endl;
+	assert(num_core==cloud.size());
+	assert(max_tile_points <= cloud.get_max_tile_points());
+
+	// reopen from the index file
+	TiledPointCloud<float> reopened("../data/0000000000_tiles");
+	assert(reopened.open());
+	assert(reopened.num_tiles()==cloud.num_tiles() && reopened.size()==cloud.size());
+
+	std::string normals_file = "../data/0000000000_tiled_normals.bin";
+	start = std::chrono::high_resolution_clock::now();
+	estimate_normals_tiled(reopened, radius, normals_file);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\ttiled normal estimation time: "<<duration.count()<<"s"<<std::endl;
+
+	std::string keep_file = "../data/0000000000_tiled_keep.bin";
+	start = std::chrono::high_resolution_clock::now();
+	radius_outlier_filter_tiled(reopened, 0.3, 2, keep_file);
+	end = std::chrono::high_resolution_clock::now();
+	duration = end-start;
+	std::cout<<"\ttiled radius outlier filter time: "<<duration.count()<<"s"<<std::endl;
+	long tiled_peak_kb = peak_rss_kb();
+	std::cout<<"\tpeak RSS of tiled processing: "<<tiled_peak_kb<<" kB, "<<baseline_kb<<" kB before tiling, working set limit "
+		<<memory_limit/1024<<" kB"<<std::endl;
+	// the limit covers tiling buffers and the estimated per-tile working set, on top of what the process used before
+	assert(tiled_peak_kb <= baseline_kb + static_cast<long>(memory_limit/1024));
+
+	// compare with processing the whole pointcloud in memory
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+	NormalEstimator<3, float> ne;
+	ne.set_pointcloud(pointvec);
+	const GeometricFeatures<float>& features = ne.get_features(radius);
+	std::vector<Point3f> normalvec = ne.get_normals(radius);
+	std::vector< std::array<float, 3> > tiled_normals = read_results< std::array<float, 3> >(normals_file);
+	assert(tiled_normals.size()==pointvec.size());
+	// normals of degenerate (e.g. collinear) neighborhoods are arbitrary and depend on summation order
+	int mismatches = 0;
+	for(int i=0; i<pointvec.size(); ++i)
+	{
+		if(features.lambda2[i]-features.lambda3[i] <= 1e-3*features.lambda1[i]) continue;
+		float dot = 0, sq_norm = 0;
+		for(int k=0; k<3; ++k)
+		{
+			dot += normalvec[i][k]*tiled_normals[i][k];
+			sq_norm += normalvec[i][k]*normalvec[i][k] + tiled_normals[i][k]*tiled_normals[i][k];
+		}
+		if(sq_norm > 0 && std::abs(dot) < 0.99) ++mismatches;
+	}
+	std::cout<<"\tnormals differing from in-memory estimation: "<<mismatches<<std::endl;
+	assert(mismatches==0);
+
+	RadiusOutlierFilter<float> ror(0.3, 2);
+	std::vector<char> keep;
+	ror.filter(pointvec, keep);
+	assert(read_results<char>(keep_file)==keep);
+	std::cout<<"\tpeak RSS with whole pointcloud loaded: "<<peak_rss_kb()<<" kB"<<std::endl;
+
+	cloud.clear();
+}
+
+/**
+* @brief points can't be added once tiles are finalized or opened, only after clearing them
+*/
+void test_tiled_add_after_finalize()
+{
+	std::cout<<"tiled processing - adding points to finalized tiles"<<std::endl;
+	std::vector<Point3f> pointvec;
+	for(int i=0; i<1000; ++i) pointvec.push_back(Point3f({0.05f*i, 0.03f*i, 0}));
+	TiledPointCloud<float> cloud("../data/add_after_finalize_tiles", 10.0, 0.5);
+	cloud.add_points(pointvec);
+	cloud.finalize();
+	int ntiles = cloud.num_tiles();
+	bool thrown = false;
+	try
+	{
+		cloud.add_points(pointvec);
+	}
+	catch(const std::logic_error&)
+	{
+		thrown = true;
+	}
+	assert(thrown && cloud.size()==pointvec.size() && cloud.num_tiles()==ntiles);
+
+	TiledPointCloud<float> reopened("../data/add_after_finalize_tiles");
+	bool opened = reopened.open();
+	assert(opened);
+	thrown = false;
+	try
+	{
+		reopened.add_points(pointvec);
+	}
+	catch(const std::logic_error&)
+	{
+		thrown = true;
+	}
+	assert(thrown);
+
+	cloud.clear();
+	cloud.add_points(pointvec);
+	cloud.finalize();
+	assert(cloud.size()==pointvec.size() && cloud.num_tiles()==ntiles);
+	cloud.clear();
+	std::cout<<"\tok"<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_tiled_processing_kitti();
+	test_tiled_add_after_finalize();
+}
@@ -0,0 +1,91 @@
+#include "pointcloud_lib/voxel_grid_filter.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cassert>
+
+std::vector<Point3f> read_kitti_bin(const std::string& binfile)
+{
+	std::vector<Point3f> pointvec;
+	std::ifstream f(binfile.c_str(), std::ios::binary);
+
+	float* data = new float[4];
+	while(f.read((char *)data, 4*sizeof(float)))
+	{
+		Point3f point;
+		for(int i=0; i<3; ++i) point[i] = data[i];
+		pointvec.push_back(point);
+	}
+
+	delete[] data;
+	f.close();
+	return pointvec;
+}
+
+template<unsigned int d, class T>
+void save_bin(const std::vector< Point<d, T> >& pointvec, std::string outfile)
+{
+	std::ofstream f(outfile.c_str(), std::ios::binary);
+
+	T *data = new T[d];
+	for(auto point: pointvec)
+	{
+		for(int i=0; i<d; ++i) data[i] = point[i];
+		f.write((char *)data, d*sizeof(T));
+	}
+
+	delete[] data;
+	f.close();
+}
+
+void test_radix_sort()
+{
+	std::vector<uint64_t> keys = {5, 3, 1ULL<<40, 3, 0, 255, 256, 1ULL<<40, 7};
+	std::vector<int> order;
+	radix_sort(keys, order);
+	for(int i=1; i<order.size(); ++i)
+	{
+		assert(keys[order[i-1]] <= keys[order[i]]);
+		// stable sort
+		if(keys[order[i-1]]==keys[order[i]]) assert(order[i-1] < order[i]);
+	}
+	std::cout<<"radix sort test passed"<<std::endl;
+}
+
+void test_voxel_grid_filter()
+{
+	std::cout<<"voxel grid filter - kitti sample"<<std::endl;
+	std::string binfile = "../data/0000000000.bin";
+	std::vector<Point3f> pointvec = read_kitti_bin(binfile);
+	std::cout<<"\t"<<pointvec.size()<<" points"<<std::endl;
+
+	double leaf_size = 0.2;
+	VoxelGridFilter<float> filter(leaf_size);
+	std::vector<int> point_to_voxel;
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<Point3f> filtered = filter.filter(pointvec, point_to_voxel);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> duration = end-start;
+	std::cout<<"\tcompute time: "<<duration.count()<<"s"<<std::endl;
+	std::cout<<"\t"<<filtered.size()<<" points after filtering"<<std::endl;
+
+	// every point is in the same voxel as the centroid it is mapped to
+	std::vector<int> count(filtered.size(), 0);
+	for(int i=0; i<pointvec.size(); ++i)
+	{
+		assert(point_to_voxel[i]>=0 && point_to_voxel[i]<filtered.size());
+		assert(pointvec[i].distance_to(filtered[point_to_voxel[i]]) <= leaf_size*std::sqrt(3.0));
+		++count[point_to_voxel[i]];
+	}
+	for(auto c: count) assert(c>0);
+
+	std::string outfile = "../data/0000000000_voxel_points.bin";
+	save_bin(filtered, outfile);
+	std::cout<<"\tfiltered points saved to "<<outfile<<std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	test_radix_sort();
+	test_voxel_grid_filter();
+}